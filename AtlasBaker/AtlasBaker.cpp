@@ -0,0 +1,136 @@
+#include <iostream>
+#include <string>
+
+#include <Carbon.hpp>
+
+#include "Benchmark.hpp"
+
+using namespace cbn;
+
+//-------------------------------------------------------------------------------------
+
+void print_usage()
+{
+	std::cout << "Usage: AtlasBaker <source directory> <output file> [options]\n"
+		<< "       AtlasBaker --benchmark [source directory]\n"
+		<< "  --size <width> <height>   Size of each atlas page (default 2048 2048)\n"
+		<< "  --padding <pixels>        Gap left between packed images (default 0)\n"
+		<< "  --no-rotation             Do not rotate images while packing\n"
+		<< "  --trim                    Trim the transparent borders of images\n"
+		<< "  --deduplicate             Pack identical images only once\n"
+		<< "  --compress <bc1|bc3|bc7>  Block compress the pages (default raw)\n"
+		<< "  --quality <fast|balanced|best>\n"
+		<< "                            Compression quality (default fast)\n"
+		<< "  --force                   Bake even if the atlas is up to date\n";
+}
+
+//-------------------------------------------------------------------------------------
+
+int main(int argc, char* argv[])
+{
+	if(argc >= 2 && argc <= 3 && std::string(argv[1]) == "--benchmark")
+	{
+		benchmark_packing(argc == 3 ? AtlasCache::Gather(argv[2]) : IdentityMap<std::filesystem::path>{});
+		benchmark_kernels();
+		return 0;
+	}
+
+	if(argc < 3)
+	{
+		print_usage();
+		return 1;
+	}
+
+	const std::filesystem::path source_directory = argv[1];
+	const std::filesystem::path output_path = argv[2];
+
+	AtlasBakeSettings settings;
+	bool force = false;
+	for(int i = 3; i < argc; i++)
+	{
+		const std::string option = argv[i];
+		if(option == "--size" && i + 2 < argc)
+		{
+			settings.page_size.x = std::stoul(argv[++i]);
+			settings.page_size.y = std::stoul(argv[++i]);
+		}
+		else if(option == "--padding" && i + 1 < argc)
+			settings.packing.padding = std::stoul(argv[++i]);
+		else if(option == "--no-rotation")
+			settings.packing.allow_image_rotation = false;
+		else if(option == "--trim")
+			settings.packing.trim_transparency = true;
+		else if(option == "--deduplicate")
+			settings.packing.deduplicate = true;
+		else if(option == "--compress" && i + 1 < argc)
+		{
+			const std::string format = argv[++i];
+			if(format == "bc1")
+				settings.compression = CompressedFormat::BC1_RGBA;
+			else if(format == "bc3")
+				settings.compression = CompressedFormat::BC3;
+			else if(format == "bc7")
+				settings.compression = CompressedFormat::BC7;
+			else
+			{
+				print_usage();
+				return 1;
+			}
+		}
+		else if(option == "--quality" && i + 1 < argc)
+		{
+			const std::string quality = argv[++i];
+			if(quality == "fast")
+				settings.compression_quality = CompressionQuality::FAST;
+			else if(quality == "balanced")
+				settings.compression_quality = CompressionQuality::BALANCED;
+			else if(quality == "best")
+				settings.compression_quality = CompressionQuality::BEST;
+			else
+			{
+				print_usage();
+				return 1;
+			}
+		}
+		else if(option == "--force")
+			force = true;
+		else
+		{
+			print_usage();
+			return 1;
+		}
+	}
+
+	const auto sources = AtlasCache::Gather(source_directory);
+	if(sources.empty())
+	{
+		std::cout << "No images found in " << source_directory << "\n";
+		return 1;
+	}
+
+	const auto source_hash = AtlasCache::SourceHash(sources, settings);
+	if(!source_hash)
+	{
+		std::cout << "Failed to read the source images\n";
+		return 1;
+	}
+
+	if(!force && AtlasCache::BakedHash(output_path) == source_hash)
+	{
+		std::cout << output_path << " is up to date\n";
+		return 0;
+	}
+
+	Stopwatch stopwatch;
+	stopwatch.start();
+
+	if(!AtlasCache::Bake(output_path, sources, settings))
+	{
+		std::cout << "Failed to bake " << sources.size() << " images into " << output_path << "\n";
+		return 1;
+	}
+
+	std::cout << "Baked " << sources.size() << " images into " << output_path
+		<< " in " << stopwatch.elapsed().milliseconds() << "ms\n";
+	return 0;
+}
@@ -0,0 +1,333 @@
+#include "Benchmark.hpp"
+
+#include <functional>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace cbn;
+
+//-------------------------------------------------------------------------------------
+
+struct SizeDistribution
+{
+	std::string name;
+	std::vector<Rect<int>> rectangles;
+};
+
+//-------------------------------------------------------------------------------------
+
+struct NamedPacker
+{
+	const char* name;
+	RectanglePackingAlgorithm algorithm;
+};
+
+constexpr NamedPacker c_Packers[] = {
+	{"max rects", RectanglePackingAlgorithm::MAX_RECTS},
+	{"skyline bottom left", RectanglePackingAlgorithm::SKYLINE_BOTTOM_LEFT},
+	{"skyline min waste", RectanglePackingAlgorithm::SKYLINE_MIN_WASTE},
+	{"guillotine", RectanglePackingAlgorithm::GUILLOTINE},
+	{"shelf", RectanglePackingAlgorithm::SHELF}
+};
+
+constexpr glm::uvec2 c_PackingSize = {4096, 4096};
+
+constexpr unsigned c_CanvasSize = 2048;
+constexpr int c_SpriteCount = 2000;
+
+//-------------------------------------------------------------------------------------
+
+std::vector<SizeDistribution> synthetic_distributions(const int count)
+{
+	// The same seed is always used, so that runs can be compared with each other
+	std::mt19937 random(1234);
+	const auto between = [&](const int min, const int max)
+	{
+		return std::uniform_int_distribution<int>(min, max)(random);
+	};
+
+	SizeDistribution icons{"icons " + std::to_string(count)};
+	SizeDistribution glyphs{"glyphs " + std::to_string(count)};
+	SizeDistribution mixed{"mixed " + std::to_string(count)};
+	for(int i = 0; i < count; i++)
+	{
+		// Icons are small and mostly square, glyphs have similar heights and varying widths,
+		// while mixed sprites are mostly small with the occasional large background or effect.
+		const int icon_size = between(16, 64);
+		icons.rectangles.push_back({0, 0, icon_size, icon_size + between(-4, 4)});
+		glyphs.rectangles.push_back({0, 0, between(4, 24), between(18, 24)});
+
+		const int kind = between(0, 99);
+		const int max_size = kind < 70 ? 32 : kind < 95 ? 128 : 512;
+		mixed.rectangles.push_back({0, 0, between(8, max_size), between(8, max_size)});
+	}
+
+	return {icons, glyphs, mixed};
+}
+
+//-------------------------------------------------------------------------------------
+
+void print_packing(const SizeDistribution& distribution, const NamedPacker& packer)
+{
+	std::vector<Rect<int>> rectangles = distribution.rectangles;
+
+	Stopwatch stopwatch;
+	stopwatch.start();
+	const bool packed = pack_rectangles(c_PackingSize, true, packer.algorithm, RectanglePackingHeuristic::BLSF_BAF_SQR, rectangles);
+	const double milliseconds = stopwatch.elapsed().milliseconds();
+
+	std::cout << "  " << std::left << std::setw(14) << distribution.name << std::setw(22) << packer.name;
+	if(!packed)
+	{
+		std::cout << "failed to pack\n";
+		return;
+	}
+
+	uint64_t area = 0;
+	glm::uvec2 footprint = {0, 0};
+	for(const auto& rect : rectangles)
+	{
+		footprint.x = std::max<unsigned>(footprint.x, rect.x + rect.width);
+		footprint.y = std::max<unsigned>(footprint.y, rect.y + rect.height);
+		area += static_cast<uint64_t>(rect.width) * rect.height;
+	}
+
+	const double occupancy = static_cast<double>(area) / (static_cast<uint64_t>(footprint.x) * footprint.y);
+	std::cout << std::right << std::fixed << std::setprecision(2) << std::setw(10) << milliseconds << "ms  "
+		<< std::setw(5) << footprint.x << "x" << std::setw(5) << std::left << footprint.y << std::right
+		<< std::setw(8) << std::setprecision(1) << occupancy * 100.0 << "%\n";
+}
+
+//-------------------------------------------------------------------------------------
+
+void benchmark_packing(const IdentityMap<std::filesystem::path>& sources)
+{
+	std::vector<SizeDistribution> distributions;
+	for(const int count : {500, 2000})
+		for(auto& distribution : synthetic_distributions(count))
+			distributions.push_back(std::move(distribution));
+
+	// The real sprite sizes are taken from the source images, if there are any
+	if(!sources.empty())
+	{
+		std::vector<std::filesystem::path> paths;
+		for(const auto& [identity, path] : sources)
+			paths.push_back(path);
+
+		SizeDistribution source_sizes{"sources " + std::to_string(paths.size())};
+		for(const auto& [image, error] : Image::OpenMany(paths))
+			if(image)
+				source_sizes.rectangles.push_back({0, 0, static_cast<int>(image->width()), static_cast<int>(image->height())});
+
+		distributions.push_back(std::move(source_sizes));
+	}
+
+	std::cout << "Packing into at most " << c_PackingSize.x << "x" << c_PackingSize.y << ", with rotation:\n";
+	for(const auto& distribution : distributions)
+		for(const auto& packer : c_Packers)
+			print_packing(distribution, packer);
+}
+
+//-------------------------------------------------------------------------------------
+
+struct PlacedSprite
+{
+	SRes<Image> image;
+	unsigned x, y;
+};
+
+//-------------------------------------------------------------------------------------
+
+std::vector<PlacedSprite> random_sprites()
+{
+	std::mt19937 random(1234);
+	const auto between = [&](const unsigned min, const unsigned max)
+	{
+		return std::uniform_int_distribution<unsigned>(min, max)(random);
+	};
+
+	// Every pixel is random, with some fully transparent and opaque pixels so that
+	// the blend is timed on the same mix of pixels that real sprites would have.
+	std::vector<PlacedSprite> sprites;
+	for(int i = 0; i < c_SpriteCount; i++)
+	{
+		auto image = Image::Create(between(16, 97), between(16, 97));
+		for(unsigned y = 0; y < image->height(); y++)
+		{
+			for(unsigned x = 0; x < image->width(); x++)
+			{
+				const unsigned kind = between(0, 3);
+				const unsigned alpha = kind == 0 ? 0 : kind == 1 ? 255 : between(0, 255);
+				image->set_pixel(x, y, Colour(between(0, 255), between(0, 255), between(0, 255), alpha));
+			}
+		}
+
+		// Rotated sprites swap their width and height, so either way they must fit
+		const unsigned extent = std::max(image->width(), image->height());
+		sprites.push_back({image, between(0, c_CanvasSize - extent), between(0, c_CanvasSize - extent)});
+	}
+	return sprites;
+}
+
+//-------------------------------------------------------------------------------------
+
+SRes<Image> random_canvas()
+{
+	std::mt19937 random(5678);
+	auto canvas = Image::Create(c_CanvasSize, c_CanvasSize);
+	for(unsigned y = 0; y < c_CanvasSize; y++)
+		for(unsigned x = 0; x < c_CanvasSize; x++)
+			canvas->set_pixel(x, y, Colour(random()));
+	return canvas;
+}
+
+//-------------------------------------------------------------------------------------
+
+void print_kernel(const char* name, const SRes<Image>& canvas, const std::function<void(Image&)>& per_pixel, const std::function<void(Image&)>& kernel)
+{
+	// Both versions run on their own copy of the same canvas, so that their results can be compared
+	const auto time = [&](const std::function<void(Image&)>& operation, SRes<Image>& result)
+	{
+		result = Image::Create(canvas->view());
+
+		Stopwatch stopwatch;
+		stopwatch.start();
+		operation(*result);
+		return stopwatch.elapsed().milliseconds();
+	};
+
+	SRes<Image> expected, result;
+	const double per_pixel_time = time(per_pixel, expected);
+	const double kernel_time = time(kernel, result);
+	const bool matches = std::memcmp(expected->data(), result->data(), expected->byte_size()) == 0;
+
+	std::cout << "  " << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(2)
+		<< std::setw(10) << per_pixel_time << "ms" << std::setw(10) << kernel_time << "ms"
+		<< std::setw(8) << std::setprecision(1) << per_pixel_time / kernel_time << "x"
+		<< (matches ? "" : "  results differ") << "\n";
+}
+
+//-------------------------------------------------------------------------------------
+
+void benchmark_kernels()
+{
+	const auto sprites = random_sprites();
+	const auto canvas = random_canvas();
+	const Colour fill_colour(12, 34, 56, 78), tint_colour(200, 150, 100, 250);
+
+	std::cout << "Pixel kernels on a " << c_CanvasSize << "x" << c_CanvasSize << " image with " << c_SpriteCount << " sprites:\n"
+		<< "  " << std::setw(28) << "per pixel" << std::setw(12) << "kernel" << std::setw(9) << "speedup" << "\n";
+
+	// The per pixel versions of insert and fill are the loops that Image used before it had the
+	// kernels, while blend and tint, which are new, are compared with their scalar fallbacks.
+	print_kernel("insert", canvas,
+		[&](Image& image)
+		{
+			for(const auto& [sprite, x_offset, y_offset] : sprites)
+				for(unsigned y = 0; y < sprite->height(); y++)
+					for(unsigned x = 0; x < sprite->width(); x++)
+						image.set_pixel(x_offset + x, y_offset + y, sprite->data()[y * sprite->width() + x]);
+		},
+		[&](Image& image)
+		{
+			for(const auto& [sprite, x_offset, y_offset] : sprites)
+				image.insert(x_offset, y_offset, sprite);
+		}
+	);
+
+	print_kernel("rotated insert", canvas,
+		[&](Image& image)
+		{
+			for(const auto& [sprite, x_offset, y_offset] : sprites)
+				for(unsigned x = 0; x < sprite->height(); x++)
+					for(unsigned y = 0; y < sprite->width(); y++)
+						image.set_pixel(x_offset + x, y_offset + y, sprite->data()[x * sprite->width() + y]);
+		},
+		[&](Image& image)
+		{
+			for(const auto& [sprite, x_offset, y_offset] : sprites)
+				image.insert(x_offset, y_offset, sprite, true);
+		}
+	);
+
+	print_kernel("fill", canvas,
+		[&](Image& image)
+		{
+			for(unsigned y = 0; y < image.height(); y++)
+				for(unsigned x = 0; x < image.width(); x++)
+					image(x, y) = fill_colour;
+		},
+		[&](Image& image)
+		{
+			image.fill(fill_colour);
+		}
+	);
+
+	print_kernel("blend", canvas,
+		[&](Image& image)
+		{
+			for(const auto& [sprite, x_offset, y_offset] : sprites)
+			{
+				for(unsigned y = 0; y < sprite->height(); y++)
+				{
+					for(unsigned x = 0; x < sprite->width(); x++)
+					{
+						const Colour src = sprite->data()[y * sprite->width() + x];
+						if(src.alpha == 0)
+							continue;
+
+						const Colour dst = image.get_pixel(x_offset + x, y_offset + y);
+						const float source_weight = src.alpha / 255.0f;
+						const float dest_weight = (dst.alpha / 255.0f) * (1.0f - source_weight);
+						const float alpha = source_weight + dest_weight;
+
+						image.set_pixel(x_offset + x, y_offset + y, Colour(
+							static_cast<uint8_t>((src.red * source_weight + dst.red * dest_weight) / alpha + 0.5f),
+							static_cast<uint8_t>((src.green * source_weight + dst.green * dest_weight) / alpha + 0.5f),
+							static_cast<uint8_t>((src.blue * source_weight + dst.blue * dest_weight) / alpha + 0.5f),
+							static_cast<uint8_t>(alpha * 255.0f + 0.5f)
+						));
+					}
+				}
+			}
+		},
+		[&](Image& image)
+		{
+			for(const auto& [sprite, x_offset, y_offset] : sprites)
+				image.blend(x_offset, y_offset, sprite);
+		}
+	);
+
+	print_kernel("tint", canvas,
+		[&](Image& image)
+		{
+			const auto multiply = [](const unsigned a, const unsigned b)
+			{
+				const unsigned rounded = a * b + 128;
+				return static_cast<uint8_t>((rounded + (rounded >> 8)) >> 8);
+			};
+
+			for(unsigned y = 0; y < image.height(); y++)
+			{
+				for(unsigned x = 0; x < image.width(); x++)
+				{
+					const Colour pixel = image.get_pixel(x, y);
+					image.set_pixel(x, y, Colour(
+						multiply(pixel.red, tint_colour.red),
+						multiply(pixel.green, tint_colour.green),
+						multiply(pixel.blue, tint_colour.blue),
+						multiply(pixel.alpha, tint_colour.alpha)
+					));
+				}
+			}
+		},
+		[&](Image& image)
+		{
+			image.tint(tint_colour);
+		}
+	);
+}
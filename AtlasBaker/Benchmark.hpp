@@ -0,0 +1,15 @@
+#pragma once
+
+#include <filesystem>
+
+#include <Carbon.hpp>
+
+// Times the rectangle packers on synthetic sprite size distributions, along with
+// the sizes of the source images if any are given, printing the time taken and
+// the occupancy of the packed footprint for each packer.
+void benchmark_packing(const IdentityMap<std::filesystem::path>& sources);
+
+// Times the bulk pixel kernels which Image uses to insert, fill, blend and tint against the
+// per pixel loops they replaced, on a large image with thousands of randomly placed sprites,
+// and checks that both produce exactly the same pixels.
+void benchmark_kernels();
@@ -2,7 +2,12 @@
 
 #include <algorithm>
 #include <functional>
+#include <limits>
+#include <array>
+#include <atomic>
+#include <thread>
 
+#include "../Control/Timing/Stopwatch.hpp"
 #include "../Utility/VectorExtensions.hpp"
 #include "../Diagnostics/Assert.hpp"
 
@@ -78,7 +83,7 @@ namespace cbn
 	
 	//-------------------------------------------------------------------------------------
 
-	int calculate_sqr_score_penalty(const Rect<int> bin, const Rect<int> rect)
+	int calculate_sqr_score_penalty(const Rect<int> bin)
 	{
 		constexpr const float weight = 5;
 		
@@ -134,7 +139,7 @@ namespace cbn
 				break;
 			case RectanglePackingHeuristic::BLSF:
 			case RectanglePackingHeuristic::BLSF_SQR:
-				scores = best_short_side_fit(bin, rect);
+				scores = best_long_side_fit(bin, rect);
 				break;
 			case RectanglePackingHeuristic::BSSF_BLSF:
 			case RectanglePackingHeuristic::BSSF_BLSF_SQR:
@@ -165,7 +170,7 @@ namespace cbn
 		// If we are also using the SQR heuristic, we 
 		// need to calculate a score penalty for it
 		if(has_sqr_heuristic(heuristic))
-			std::get<0>(scores) += calculate_sqr_score_penalty(bin, rect);
+			std::get<0>(scores) += calculate_sqr_score_penalty(bin);
 
 		return scores;
 	}
@@ -220,185 +225,779 @@ namespace cbn
 	//-------------------------------------------------------------------------------------
 
 
-	void insert_into_bin(Rect<int>& rect, const bool rotate, const int bin_index, std::vector<Rect<int>>& bins, const int minimum_dimension = 0)
+	// Keeps track of the free bins of a MaxRects packing. Bins keep the same id for their entire
+	// life, so that they can be referenced without having to worry about other bins being removed.
+	class FreeBinList
 	{
-		// Update the location and orientation of the rect
-		if(rotate) std::swap(rect.width, rect.height);
-		rect.x = bins[bin_index].x;
-		rect.y = bins[bin_index].y;
+	private:
 
-		// Every bin which intersects our rectangle needs to be  split into
-		// 1-4 maximal bins surrounding the rectangle. These new bins will be 
-		// added to a new_bins vector, instead of our normal bins one. Otherwise 
-		// they will be checked for intersection when we know that they already do 
-		// not intersect. This new vector will then be appended to the bins vector. 
-		std::vector<Rect<int>> new_bins;
-		for(int i = 0; i < bins.size(); i++)
+		struct Bin
 		{
-			const Rect<int> bin = bins[i];
+			Rect<int> rect;
+			int live_position;
+		};
 
-			if(intersects(bin, rect))
-			{
-				split_bin(bin, rect, new_bins, minimum_dimension);
-				swap_erase(bins, i);
-				i--;
-			}
+		std::vector<Bin> m_Bins;
+		std::vector<int> m_Live;
+
+	public:
+
+		int add(const Rect<int>& rect)
+		{
+			const int id = m_Bins.size();
+			m_Bins.push_back({rect, static_cast<int>(m_Live.size())});
+			m_Live.push_back(id);
+
+			return id;
+		}
+
+		void remove(const int id)
+		{
+			auto& bin = m_Bins[id];
+			m_Bins[m_Live.back()].live_position = bin.live_position;
+			swap_erase(m_Live, bin.live_position);
+			bin.live_position = -1;
+		}
+
+		bool is_live(const int id) const
+		{
+			return m_Bins[id].live_position >= 0;
+		}
+
+		const Rect<int>& operator[](const int id) const
+		{
+			return m_Bins[id].rect;
+		}
+
+		const std::vector<int>& live() const
+		{
+			return m_Live;
 		}
-		bins.insert(bins.end(), new_bins.begin(), new_bins.end());
+	};
+
+	//-------------------------------------------------------------------------------------
 
-		// When we split the bins we will have made a bunch of
-		// bins which are contained within other bins. We need
-		// to remove this bins so that we only have maximal bins. 
-		for(int i = 0; i < bins.size(); i++)
+	void insert_into_bin(const Rect<int>& rect, FreeBinList& bins, std::vector<Rect<int>>& pieces, std::vector<int>& new_bins, const int minimum_dimension)
+	{
+		// Every bin which intersects our rectangle needs to be split into
+		// 1-4 maximal bins surrounding the rectangle. Removing a bin moves
+		// the last live bin into its place, so the live list is walked 
+		// backwards, where the moved bin will always have been visited.
+		pieces.clear();
+		const auto& live = bins.live();
+		for(int i = static_cast<int>(live.size()) - 1; i >= 0; i--)
 		{
-			// If any dimension of bin i is smaller than 
-			// the given minimum dimension we want to remove it.
-			if(bins[i].width < minimum_dimension || bins[i].height < minimum_dimension)
+			const int id = live[i];
+			if(intersects(bins[id], rect))
 			{
-				swap_erase(bins, i);
-				i--;
-				continue;
+				split_bin(bins[id], rect, pieces, minimum_dimension);
+				bins.remove(id);
 			}
+		}
 
-			for(int j = i + 1; j < bins.size(); j++)
-			{
+		// Only the new pieces need to be pruned if they aren't maximal. None of the
+		// remaining bins can be contained by a piece, as each piece lies within a 
+		// bin that has been removed, which itself did not contain any other bins.
+		// Pieces are checked against the bins as they are added, so that any 
+		// duplicate pieces from neighbouring bins are only added once. 
+		new_bins.clear();
+		for(const auto& piece : pieces)
+		{
+			const bool contained = std::any_of(bins.live().begin(), bins.live().end(), [&](const int id){
+				return contains(bins[id], piece);
+			});
 
-				// If any dimension of bin j is smaller than 
-                // the given minimum dimension we want to remove it.
-				if(bins[j].width < minimum_dimension || bins[j].height < minimum_dimension)
-				{
-					swap_erase(bins, j);
-					j--;
-					continue;
-				}
+			if(contained)
+				continue;
 
-				// if bin j contains i, we want to remove i 
-				// and skip processing the rest of the j bins. 
-				if(contains(bins[j], bins[i]))
+			for(int i = 0; i < new_bins.size(); i++)
+			{
+				if(contains(piece, bins[new_bins[i]]))
 				{
-					swap_erase(bins, i);
+					bins.remove(new_bins[i]);
+					swap_erase(new_bins, i);
 					i--;
-					break;
 				}
+			}
 
-				// If bin i contains j, we want to remove j
-				if(contains(bins[i], bins[j]))
-				{
-					swap_erase(bins, j);
-					j--;
-				}
+			new_bins.push_back(bins.add(piece));
+		}
+	}
 
-			}
+	//-------------------------------------------------------------------------------------
+
+	struct PlacementScore
+	{
+		int score = std::numeric_limits<int>::max();
+		int tiebreak = std::numeric_limits<int>::max();
+		int rect = -1;
+		bool rotated = false;
+	};
+
+	struct BinPlacements
+	{
+		// The best placements are kept in order, and if there were fewer placements
+		// than can be cached, then every rect which fits the bin is in the cache.
+		static constexpr int c_Capacity = 8;
+
+		std::array<PlacementScore, c_Capacity> best;
+		int first = 0, count = 0;
+		bool complete = false;
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	bool is_better_placement(const PlacementScore& placement, const PlacementScore& other)
+	{
+		return placement.score < other.score || (placement.score == other.score && placement.tiebreak < other.tiebreak);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void consider_placement(BinPlacements& placements, const PlacementScore& placement)
+	{
+		auto& best = placements.best;
+		auto& count = placements.count;
+		if(count == BinPlacements::c_Capacity && !is_better_placement(placement, best[count - 1]))
+			return;
+
+		// Insertion sort the placement into the cache, dropping the worst if it's full
+		int i = std::min(count, BinPlacements::c_Capacity - 1);
+		for(; i > 0 && is_better_placement(placement, best[i - 1]); i--)
+			best[i] = best[i - 1];
+
+		best[i] = placement;
+		count = std::min(count + 1, BinPlacements::c_Capacity);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void score_placements(BinPlacements& placements, const int rect_index, const Rect<int>& rect, const Rect<int>& bin, const bool allow_rotation, const RectanglePackingHeuristic heuristic)
+	{
+		// If the rect fits in the bin, then calculate its score
+		if(rect.width <= bin.width && rect.height <= bin.height)
+		{
+			const auto [score, tiebreak] = calculate_score(bin, rect, heuristic);
+			consider_placement(placements, {score, tiebreak, rect_index, false});
 		}
 
+		// Also check of the rect fits rotated, and if its a better fit
+		if(allow_rotation && rect.height <= bin.width && rect.width <= bin.height)
+		{
+			const auto [score, tiebreak] = calculate_score(bin, {bin.x, bin.y, rect.height, rect.width}, heuristic);
+			consider_placement(placements, {score, tiebreak, rect_index, true});
+		}
 	}
 
 	//-------------------------------------------------------------------------------------
 	 
 	bool max_rects_optimal(const glm::uvec2& size, const bool allow_rotation, const RectanglePackingHeuristic heuristic, std::vector<Rect<int>>& rectangles)
 	{
-		// We do not want to change the order of the given rectangles vector
-		// so we will make a new vector which references each of the rectangles
-		// Also since we are iterating over the rectangles, we want to determine
-		// the total rectangle area, and the minimum rectangle dimension. 
+		// A rect can only fit into a bin if its shortest side is no longer than the bin's,
+		// regardless of rotation. The rects which are still to be packed are kept in order 
+		// of their shortest side, so that scoring a bin can stop as soon as it reaches a rect
+		// which is too wide. This is kept separate from the given rectangles vector, as we 
+		// do not want to change its order. Also since we are iterating over the rectangles,
+		// we want to determine the total rectangle area, and the minimum rectangle dimension. 
+		struct PendingRect
+		{
+			int index;
+			int shortest_side;
+			Rect<int> rect;
+		};
+
 		int minimum_dimension = std::numeric_limits<int>::max();
-		unsigned required_rectangle_area = 0;
+		uint64_t required_rectangle_area = 0;
 
-		std::vector<Rect<int>*> references;
-		references.reserve(rectangles.size());
-		for(auto& rect : rectangles)
+		std::vector<PendingRect> pending;
+		pending.reserve(rectangles.size());
+		for(int r = 0; r < rectangles.size(); r++)
 		{
+			const auto& rect = rectangles[r];
+
 			// Accumulate the area
-			required_rectangle_area += rect.width * rect.height;
+			required_rectangle_area += static_cast<uint64_t>(rect.width) * rect.height;
 
 			// Update minimum dimension
-			if(int dim = std::min(rect.width, rect.height); dim < minimum_dimension)
+			const int dim = std::min(rect.width, rect.height);
+			if(dim < minimum_dimension)
 				minimum_dimension = dim;
 
-			references.push_back(&rect);
+			pending.push_back({r, dim, rect});
 		}
 		
 		// If the total area of the rectangles exceeds the given area, exit out early
-		if(required_rectangle_area > size.x * size.y)
+		if(required_rectangle_area > static_cast<uint64_t>(size.x) * size.y)
 			return false;
 
-		std::vector<Rect<int>> bins;
-		bins.push_back({0, 0, static_cast<int>(size.x), static_cast<int>(size.y)});
+		std::stable_sort(pending.begin(), pending.end(), [](const PendingRect& left, const PendingRect& right){
+			return left.shortest_side < right.shortest_side;
+		});
 
-		// Insert rectangles until all have been added
-		while(!references.empty())
-		{
-			// The best score is the best score for the bin and rect given
-			// a heuristic. The best tiebreak is the score which is considered
-			// when two sets of bins/rects have the same score as each other. 
-			int best_tiebreak = std::numeric_limits<int>::max();
-			int best_score = std::numeric_limits<int>::max();
-			int best_rect_index = 0;
-			int best_bin_index = 0;
-			bool bin_found = false;
-			bool rotated = false;
+		FreeBinList bins;
+		bins.add({0, 0, static_cast<int>(size.x), static_cast<int>(size.y)});
+
+		// The score of a rect against a bin never changes, so each bin caches its best few
+		// placements. Rects are only ever removed, so a bin's best placement is the first
+		// cached one whose rect is not yet packed. A bin only needs to be rescored against 
+		// every remaining rect once it is new, or once all of its cached rects are packed.
+		std::vector<BinPlacements> placements;
+		std::vector<bool> packed(rectangles.size(), false);
+		const auto best_placement = [&](const int id) -> const PlacementScore*
+		{
+			if(id >= placements.size())
+				placements.resize(id + 1);
+
+			auto& bin_placements = placements[id];
+			while(bin_placements.first < bin_placements.count && packed[bin_placements.best[bin_placements.first].rect])
+				bin_placements.first++;
+
+			if(bin_placements.first == bin_placements.count && !bin_placements.complete)
+			{
+				bin_placements.first = 0;
+				bin_placements.count = 0;
+
+				const auto& bin = bins[id];
+				const int bin_shortest_side = std::min(bin.width, bin.height);
+				for(const auto& candidate : pending)
+				{
+					if(candidate.shortest_side > bin_shortest_side)
+						break;
 
+					score_placements(bin_placements, candidate.index, candidate.rect, bin, allow_rotation, heuristic);
+				}
+
+				bin_placements.complete = bin_placements.count < BinPlacements::c_Capacity;
+			}
+
+			return bin_placements.first < bin_placements.count ? &bin_placements.best[bin_placements.first] : nullptr;
+		};
+
+		// Insert rectangles until all have been added
+		std::vector<Rect<int>> pieces;
+		std::vector<int> new_bins;
+		while(!pending.empty())
+		{
 			// Since we are finding the optimal packing. We want
 			// to find the global optimal combination of bin and rect
-			for(int b = 0; b < bins.size(); b++)
+			int best_bin = -1;
+			PlacementScore best;
+			for(const int id : bins.live())
 			{
-				const auto& bin = bins[b];
-
-				for(int r = 0; r < references.size(); r++)
+				const auto placement = best_placement(id);
+				if(placement != nullptr && (best_bin < 0 || is_better_placement(*placement, best)))
 				{
-					const auto& rect = *references[r];
-
-					// If the rect fits in the bin, then calculate its score
-					if(rect.width <= bin.width && rect.height <= bin.height)
-					{
-						bin_found = true;
-
-						const auto [score, tiebreak] = calculate_score(bin, rect, heuristic);
-						if(score < best_score || (score == best_score && tiebreak < best_tiebreak))
-						{
-							best_tiebreak = tiebreak;
-							best_score = score;
-							best_rect_index = r;
-							best_bin_index = b;
-							rotated = false;
-						}
-					}
-
-					// Also check of the rect fits rotated, and if its a better fit
-					if(allow_rotation && rect.height <= bin.width && rect.width <= bin.height)
-					{
-						bin_found = true;
-						
-						const auto [score, tiebreak] = calculate_score(bin, {rect.height, rect.width}, heuristic);
-						if(score < best_score || (score == best_score && tiebreak < best_tiebreak))
-						{
-							best_tiebreak = tiebreak;
-							best_score = score;
-							best_rect_index = r;
-							best_bin_index = b;
-							rotated = true;
-						}
-					}
+					best_bin = id;
+					best = *placement;
 				}
 			}
 
 			// If no bin was found to place a rectangle into, then
 			// we could not pack the rectangles into the given size
-			if(!bin_found)
+			if(best_bin < 0)
 				return false;
 
-			// Insert the rect into the bin. This will update
-			// the rects location/orientation and split the 
-			// bin as required, then prune non-maximal bins. 
-			Rect<int>& chosen_rect = *references[best_rect_index];
-			insert_into_bin(chosen_rect, rotated, best_bin_index, bins, minimum_dimension);
-		
-			// Remove the chosen rectangle from references so we dont pack it again
-			swap_erase(references, best_rect_index);
+			// Update the location and orientation of the chosen rect
+			Rect<int>& chosen_rect = rectangles[best.rect];
+			if(best.rotated) std::swap(chosen_rect.width, chosen_rect.height);
+			chosen_rect.x = bins[best_bin].x;
+			chosen_rect.y = bins[best_bin].y;
+
+			// Insert the rect, this splits the bins as 
+			// required, then prunes non-maximal bins.
+			insert_into_bin(chosen_rect, bins, pieces, new_bins, minimum_dimension);
+
+			// Remove the chosen rectangle so we dont pack it again
+			packed[best.rect] = true;
+			pending.erase(std::find_if(pending.begin(), pending.end(), [&](const PendingRect& candidate){
+				return candidate.index == best.rect;
+			}));
 		}
 
 		return true;
 	}
-	
+
+	//-------------------------------------------------------------------------------------
+
+	bool max_rects_search(const glm::uvec2& size, const bool allow_rotation, std::vector<Rect<int>>& rectangles, std::vector<PackingAttempt>& attempts, const unsigned thread_count)
+	{
+		constexpr int heuristic_count = static_cast<int>(RectanglePackingHeuristic::BLSF_BSSF_SQR) + 1;
+
+		attempts.clear();
+		for(int h = 0; h < heuristic_count; h++)
+		{
+			attempts.push_back({static_cast<RectanglePackingHeuristic>(h), false, false, Time(), {0, 0}, 0.0f});
+			if(allow_rotation)
+				attempts.push_back({static_cast<RectanglePackingHeuristic>(h), true, false, Time(), {0, 0}, 0.0f});
+		}
+
+		// Each attempt packs its own copy of the rectangles, so they are entirely independent.
+		// Threads pull the next attempt from a shared counter, as some heuristics are much 
+		// slower than others and splitting them up evenly would leave threads sitting idle.
+		std::vector<std::vector<Rect<int>>> results(attempts.size(), rectangles);
+		std::atomic<int> next_attempt = 0;
+		const auto pack = [&]()
+		{
+			for(int a = next_attempt++; a < attempts.size(); a = next_attempt++)
+			{
+				auto& attempt = attempts[a];
+				auto& result = results[a];
+
+				Stopwatch stopwatch;
+				stopwatch.start();
+				attempt.packed = max_rects_optimal(size, attempt.allow_rotation, attempt.heuristic, result);
+				attempt.duration = stopwatch.elapsed();
+
+				if(!attempt.packed || result.empty())
+					continue;
+
+				uint64_t packed_area = 0;
+				for(const auto& rect : result)
+				{
+					attempt.footprint.x = std::max<unsigned>(attempt.footprint.x, rect.x + rect.width);
+					attempt.footprint.y = std::max<unsigned>(attempt.footprint.y, rect.y + rect.height);
+					packed_area += static_cast<uint64_t>(rect.width) * rect.height;
+				}
+				attempt.occupancy = static_cast<float>(packed_area) / (static_cast<uint64_t>(attempt.footprint.x) * attempt.footprint.y);
+			}
+		};
+
+		const unsigned hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+		const unsigned threads = std::min<unsigned>(thread_count == 0 ? hardware_threads : thread_count, attempts.size());
+
+		// The calling thread also packs, rather than waiting idle on the others
+		std::vector<std::thread> workers;
+		for(unsigned t = 1; t < threads; t++)
+			workers.emplace_back(pack);
+		pack();
+
+		for(auto& worker : workers)
+			worker.join();
+
+		// The best packing has the smallest footprint, with the squarest footprint as a tiebreak
+		int best_attempt = -1;
+		for(int a = 0; a < attempts.size(); a++)
+		{
+			if(!attempts[a].packed)
+				continue;
+
+			if(best_attempt < 0)
+			{
+				best_attempt = a;
+				continue;
+			}
+
+			const auto& best = attempts[best_attempt].footprint;
+			const auto& footprint = attempts[a].footprint;
+
+			const uint64_t best_area = static_cast<uint64_t>(best.x) * best.y;
+			const uint64_t area = static_cast<uint64_t>(footprint.x) * footprint.y;
+			if(area < best_area || (area == best_area && std::max(footprint.x, footprint.y) < std::max(best.x, best.y)))
+				best_attempt = a;
+		}
+
+		if(best_attempt < 0)
+			return false;
+
+		rectangles = std::move(results[best_attempt]);
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::vector<int> sorted_indices(const std::vector<Rect<int>>& rectangles, const std::function<bool(const Rect<int>&, const Rect<int>&)>& comparator)
+	{
+		// The offline packers work best when given rectangles in a particular order,
+		// but the order of the given rectangles must not be changed, so sort indices.
+		std::vector<int> indices(rectangles.size());
+		for(int i = 0; i < indices.size(); i++)
+			indices[i] = i;
+
+		std::stable_sort(indices.begin(), indices.end(), [&](const int left, const int right){
+			return comparator(rectangles[left], rectangles[right]);
+		});
+
+		return indices;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool skyline_pack(const glm::uvec2& size, const bool allow_rotation, const SkylineHeuristic heuristic, std::vector<Rect<int>>& rectangles)
+	{
+		// Packing the longest rectangles first lets the shorter ones fill in around them
+		const auto order = sorted_indices(rectangles, [](const Rect<int>& left, const Rect<int>& right){
+			const int left_side = std::max(left.width, left.height);
+			const int right_side = std::max(right.width, right.height);
+			return left_side > right_side || (left_side == right_side && std::min(left.width, left.height) > std::min(right.width, right.height));
+		});
+
+		SkylinePacker packer(size, heuristic);
+		for(const int r : order)
+		{
+			const auto rect = packer.insert(rectangles[r].width, rectangles[r].height, allow_rotation);
+			if(!rect.has_value())
+				return false;
+
+			rectangles[r] = *rect;
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void merge_free_rects(std::vector<Rect<int>>& free_rects, const int index)
+	{
+		// Keep merging the given free rect with any neighbour which shares a 
+		// whole edge with it, as the merged rect can fit larger rectangles. 
+		for(int i = 0; i < free_rects.size(); i++)
+		{
+			if(i == index)
+				continue;
+
+			auto& rect = free_rects[index];
+			const auto& other = free_rects[i];
+
+			const bool same_column = rect.x == other.x && rect.width == other.width;
+			const bool same_row = rect.y == other.y && rect.height == other.height;
+			if(same_column && (rect.y + rect.height == other.y || other.y + other.height == rect.y))
+			{
+				rect.y = std::min(rect.y, other.y);
+				rect.height += other.height;
+			}
+			else if(same_row && (rect.x + rect.width == other.x || other.x + other.width == rect.x))
+			{
+				rect.x = std::min(rect.x, other.x);
+				rect.width += other.width;
+			}
+			else continue;
+
+			// Removing the other rect may move our rect into its slot, so start over
+			const int last = free_rects.size() - 1;
+			swap_erase(free_rects, i);
+			merge_free_rects(free_rects, index == last ? i : index);
+			return;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool guillotine_pack(const glm::uvec2& size, const bool allow_rotation, std::vector<Rect<int>>& rectangles)
+	{
+		// Packing the largest rectangles first leaves the small ones to fill in the gaps
+		const auto order = sorted_indices(rectangles, [](const Rect<int>& left, const Rect<int>& right){
+			return left.width * left.height > right.width * right.height;
+		});
+
+		std::vector<Rect<int>> free_rects;
+		free_rects.push_back({0, 0, static_cast<int>(size.x), static_cast<int>(size.y)});
+
+		for(const int r : order)
+		{
+			auto& rect = rectangles[r];
+
+			// Choose the free rect which grows the packed footprint the least, using the best
+			// area fit as a tiebreak. Otherwise the best fits tend to be spread over the whole
+			// area, as the leftover free rects towards the edges are all similarly large. 
+			int best_free = -1;
+			bool rotated = false;
+			std::tuple<int, int> best_score = {std::numeric_limits<int>::max(), std::numeric_limits<int>::max()};
+			const auto score_fit = [&](const int f, const int width, const int height, const bool rotate)
+			{
+				const auto& free = free_rects[f];
+				if(width > free.width || height > free.height)
+					return;
+
+				const std::tuple<int, int> score = {
+					std::max(free.x + width, free.y + height),
+					std::get<0>(best_area_fit(free, {0, 0, width, height}))
+				};
+
+				if(score < best_score)
+				{
+					best_score = score;
+					best_free = f;
+					rotated = rotate;
+				}
+			};
+
+			for(int f = 0; f < free_rects.size(); f++)
+			{
+				score_fit(f, rect.width, rect.height, false);
+				if(allow_rotation)
+					score_fit(f, rect.height, rect.width, true);
+			}
+
+			if(best_free < 0)
+				return false;
+
+			const Rect<int> free = free_rects[best_free];
+			if(rotated) std::swap(rect.width, rect.height);
+			rect.x = free.x;
+			rect.y = free.y;
+
+			// The free rect is split by a single cut along the shorter leftover axis, 
+			// which keeps the larger of the two leftover pieces as big as possible.
+			const int leftover_width = free.width - rect.width;
+			const int leftover_height = free.height - rect.height;
+
+			Rect<int> right, bottom;
+			if(leftover_width <= leftover_height)
+			{
+				right = {free.x + rect.width, free.y, leftover_width, rect.height};
+				bottom = {free.x, free.y + rect.height, free.width, leftover_height};
+			}
+			else
+			{
+				right = {free.x + rect.width, free.y, leftover_width, free.height};
+				bottom = {free.x, free.y + rect.height, rect.width, leftover_height};
+			}
+
+			swap_erase(free_rects, best_free);
+			for(const auto& piece : {right, bottom})
+			{
+				if(piece.width > 0 && piece.height > 0)
+				{
+					free_rects.push_back(piece);
+					merge_free_rects(free_rects, free_rects.size() - 1);
+				}
+			}
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool shelf_pack(const glm::uvec2& size, const bool allow_rotation, std::vector<Rect<int>>& rectangles)
+	{
+		struct Shelf
+		{
+			int y, height, used_width;
+		};
+
+		// Rectangles are laid flat if they can be, so that the shelves are as short as possible. 
+		// Then sorting them by height means that each new shelf is no taller than the last.
+		if(allow_rotation)
+			for(auto& rect : rectangles)
+				if(rect.height > rect.width && rect.height <= static_cast<int>(size.x))
+					std::swap(rect.width, rect.height);
+
+		const auto order = sorted_indices(rectangles, [](const Rect<int>& left, const Rect<int>& right){
+			return left.height > right.height || (left.height == right.height && left.width > right.width);
+		});
+
+		std::vector<Shelf> shelves;
+		for(const int r : order)
+		{
+			auto& rect = rectangles[r];
+
+			// Use the first shelf with enough room left, otherwise start a new shelf on top
+			auto shelf = std::find_if(shelves.begin(), shelves.end(), [&](const Shelf& shelf){
+				return rect.height <= shelf.height && shelf.used_width + rect.width <= static_cast<int>(size.x);
+			});
+
+			if(shelf == shelves.end())
+			{
+				const int y = shelves.empty() ? 0 : shelves.back().y + shelves.back().height;
+				if(y + rect.height > static_cast<int>(size.y) || rect.width > static_cast<int>(size.x))
+					return false;
+
+				shelves.push_back({y, rect.height, 0});
+				shelf = shelves.end() - 1;
+			}
+
+			rect.x = shelf->used_width;
+			rect.y = shelf->y;
+			shelf->used_width += rect.width;
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool pack_rectangles(const glm::uvec2& size, const bool allow_rotation, const RectanglePackingAlgorithm algorithm, const RectanglePackingHeuristic heuristic, std::vector<Rect<int>>& rectangles)
+	{
+		switch(algorithm)
+		{
+			case RectanglePackingAlgorithm::MAX_RECTS:
+				return max_rects_optimal(size, allow_rotation, heuristic, rectangles);
+			case RectanglePackingAlgorithm::SKYLINE_BOTTOM_LEFT:
+				return skyline_pack(size, allow_rotation, SkylineHeuristic::BOTTOM_LEFT, rectangles);
+			case RectanglePackingAlgorithm::SKYLINE_MIN_WASTE:
+				return skyline_pack(size, allow_rotation, SkylineHeuristic::MIN_WASTE, rectangles);
+			case RectanglePackingAlgorithm::GUILLOTINE:
+				return guillotine_pack(size, allow_rotation, rectangles);
+			case RectanglePackingAlgorithm::SHELF:
+				return shelf_pack(size, allow_rotation, rectangles);
+			default:
+				return false;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SkylinePacker::SkylinePacker(const glm::uvec2& size, const SkylineHeuristic heuristic)
+		: m_Size(size),
+		m_Heuristic(heuristic)
+	{
+		reset();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<int> SkylinePacker::fit(const int segment, const int width, const int height, uint64_t& wasted_area) const
+	{
+		const int x = m_Skyline[segment].x;
+		if(x + width > static_cast<int>(m_Size.x))
+			return std::nullopt;
+
+		// The rectangle has to sit on top of the highest segment which it spans
+		int y = 0, remaining_width = width;
+		for(int s = segment; remaining_width > 0; s++)
+		{
+			y = std::max(y, m_Skyline[s].y);
+			if(y + height > static_cast<int>(m_Size.y))
+				return std::nullopt;
+
+			remaining_width -= m_Skyline[s].width;
+		}
+
+		// Any segment lower than the rectangle leaves a gap underneath it
+		wasted_area = 0;
+		remaining_width = width;
+		for(int s = segment; remaining_width > 0; s++)
+		{
+			const int span = std::min(remaining_width, m_Skyline[s].width);
+			wasted_area += static_cast<uint64_t>(y - m_Skyline[s].y) * span;
+			remaining_width -= span;
+		}
+
+		return y;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void SkylinePacker::add_segment(const int segment, const Rect<int>& rect)
+	{
+		m_Skyline.insert(m_Skyline.begin() + segment, {rect.x, rect.y + rect.height, rect.width});
+
+		// The following segments which lie underneath the new segment 
+		// need to be shrunk or removed, so that no segments overlap.
+		for(int s = segment + 1; s < m_Skyline.size(); s++)
+		{
+			auto& previous = m_Skyline[s - 1];
+			auto& current = m_Skyline[s];
+
+			const int overlap = previous.x + previous.width - current.x;
+			if(overlap <= 0)
+				break;
+
+			current.x += overlap;
+			current.width -= overlap;
+			if(current.width > 0)
+				break;
+
+			m_Skyline.erase(m_Skyline.begin() + s);
+			s--;
+		}
+
+		// Merge neighbouring segments at the same height, this keeps the skyline short
+		for(int s = 0; s < static_cast<int>(m_Skyline.size()) - 1; s++)
+		{
+			if(m_Skyline[s].y == m_Skyline[s + 1].y)
+			{
+				m_Skyline[s].width += m_Skyline[s + 1].width;
+				m_Skyline.erase(m_Skyline.begin() + s + 1);
+				s--;
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<Rect<int>> SkylinePacker::insert(const int width, const int height, const bool allow_rotation)
+	{
+		if(width <= 0 || height <= 0)
+			return std::nullopt;
+
+		// Find the best position for the rectangle, in either orientation if allowed.
+		// Bottom left prefers the lowest skyline, with the narrowest segment as the 
+		// tiebreak, while min waste prefers the smallest gap left under the rectangle.
+		std::optional<Rect<int>> best_rect;
+		int best_segment = -1;
+		uint64_t best_score = std::numeric_limits<uint64_t>::max();
+		uint64_t best_tiebreak = std::numeric_limits<uint64_t>::max();
+		for(int s = 0; s < m_Skyline.size(); s++)
+		{
+			for(int rotation = 0; rotation < (allow_rotation ? 2 : 1); rotation++)
+			{
+				const int rect_width = rotation ? height : width;
+				const int rect_height = rotation ? width : height;
+
+				uint64_t wasted_area;
+				const auto y = fit(s, rect_width, rect_height, wasted_area);
+				if(!y.has_value())
+					continue;
+
+				const uint64_t top = *y + rect_height;
+				const uint64_t score = m_Heuristic == SkylineHeuristic::BOTTOM_LEFT ? top : wasted_area;
+				const uint64_t tiebreak = m_Heuristic == SkylineHeuristic::BOTTOM_LEFT ? m_Skyline[s].width : top;
+				if(score < best_score || (score == best_score && tiebreak < best_tiebreak))
+				{
+					best_rect = Rect<int>{m_Skyline[s].x, *y, rect_width, rect_height};
+					best_segment = s;
+					best_score = score;
+					best_tiebreak = tiebreak;
+				}
+			}
+		}
+
+		if(!best_rect.has_value())
+			return std::nullopt;
+
+		add_segment(best_segment, *best_rect);
+		m_PackedArea += static_cast<uint64_t>(width) * height;
+
+		return best_rect;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void SkylinePacker::reset()
+	{
+		m_Skyline.clear();
+		m_Skyline.push_back({0, 0, static_cast<int>(m_Size.x)});
+		m_PackedArea = 0;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	glm::uvec2 SkylinePacker::size() const
+	{
+		return m_Size;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t SkylinePacker::packed_area() const
+	{
+		return m_PackedArea;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t SkylinePacker::covered_area() const
+	{
+		// All of the area underneath the skyline is 
+		// unusable, whether it was packed or wasted.
+		uint64_t covered_area = 0;
+		for(const auto& segment : m_Skyline)
+			covered_area += static_cast<uint64_t>(segment.width) * segment.y;
+
+		return covered_area;
+	}
+
 	//-------------------------------------------------------------------------------------
 }
\ No newline at end of file
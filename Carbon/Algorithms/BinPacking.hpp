@@ -1,9 +1,12 @@
 #pragma once
 
 #include <vector>
+#include <optional>
+#include <stdint.h>
 #include <glm/glm.hpp>
 #include <functional>
 
+#include "../Control/Timing/Time.hpp"
 #include "../Maths/Shapes.hpp"
 
 namespace cbn
@@ -28,6 +31,31 @@ namespace cbn
 		BLSF_BSSF_SQR, // Best Long Side Fit + Best Short Side Fit Tiebreaker + Square Footprint
 	};
 
+	// The packers trade occupancy for speed. Packing 2000 sprites of random sizes:
+	//  - MAX_RECTS packs well with a suitable heuristic, but is quadratic and takes 100s of ms.
+	//  - SKYLINE_BOTTOM_LEFT takes a few ms and packs tightly, but fills the full width first.
+	//  - SKYLINE_MIN_WASTE leaves fewer holes under the skyline, but is slower and grows taller.
+	//  - GUILLOTINE takes around 10ms, and keeps a compact square footprint for varied sizes.
+	//  - SHELF takes well under 1ms, but wastes space unless the rectangle heights are similar.
+	enum class RectanglePackingAlgorithm
+	{
+		MAX_RECTS,
+		SKYLINE_BOTTOM_LEFT,
+		SKYLINE_MIN_WASTE,
+		GUILLOTINE,
+		SHELF
+	};
+
+	enum class SkylineHeuristic
+	{
+		BOTTOM_LEFT, // Lowest top edge, narrowest segment tiebreaker
+		MIN_WASTE // Least area left underneath, lowest top edge tiebreaker
+	};
+
+	// All of the packers share the same interface. The rectangles are packed in place, 
+	// by updating their position, and swapping their width and height if they are rotated.
+	// If they could not all be packed within the given size then false is returned.
+
 	bool max_rects_optimal(
 		const glm::uvec2& size,
 		const bool allow_rotation,
@@ -35,4 +63,92 @@ namespace cbn
 		std::vector<Rect<int>>& rectangles
 	);
 
+	bool skyline_pack(
+		const glm::uvec2& size,
+		const bool allow_rotation,
+		const SkylineHeuristic heuristic,
+		std::vector<Rect<int>>& rectangles
+	);
+
+	bool guillotine_pack(
+		const glm::uvec2& size,
+		const bool allow_rotation,
+		std::vector<Rect<int>>& rectangles
+	);
+
+	bool shelf_pack(
+		const glm::uvec2& size,
+		const bool allow_rotation,
+		std::vector<Rect<int>>& rectangles
+	);
+
+	// The heuristic is only used by MAX_RECTS
+	bool pack_rectangles(
+		const glm::uvec2& size,
+		const bool allow_rotation,
+		const RectanglePackingAlgorithm algorithm,
+		const RectanglePackingHeuristic heuristic,
+		std::vector<Rect<int>>& rectangles
+	);
+
+	struct PackingAttempt
+	{
+		RectanglePackingHeuristic heuristic;
+		bool allow_rotation = false;
+		bool packed = false;
+		Time duration;
+		glm::uvec2 footprint = {0, 0};
+		float occupancy = 0.0f;
+	};
+
+	// Which heuristic packs best depends on the rectangles, so this tries every heuristic, 
+	// with and without rotation if it is allowed, across a number of threads. The rectangles 
+	// are updated with the packing which has the smallest footprint, and the results of each
+	// attempt are returned through attempts. A thread count of zero uses every hardware thread.
+	bool max_rects_search(
+		const glm::uvec2& size,
+		const bool allow_rotation,
+		std::vector<Rect<int>>& rectangles,
+		std::vector<PackingAttempt>& attempts,
+		const unsigned thread_count = 0
+	);
+
+	// Packs rectangles one at a time as they arrive, without knowing about any future
+	// rectangles. The top edge of the packed area is tracked as a skyline of horizontal
+	// segments, and each rectangle is placed where the heuristic scores best. Any space
+	// which ends up underneath a rectangle is never reused, until the packer is reset.
+	class SkylinePacker
+	{
+	private:
+
+		struct Segment
+		{
+			int x, y, width;
+		};
+
+		glm::uvec2 m_Size;
+		SkylineHeuristic m_Heuristic;
+		std::vector<Segment> m_Skyline;
+		uint64_t m_PackedArea;
+
+		std::optional<int> fit(const int segment, const int width, const int height, uint64_t& wasted_area) const;
+
+		void add_segment(const int segment, const Rect<int>& rect);
+
+	public:
+
+		SkylinePacker(const glm::uvec2& size, const SkylineHeuristic heuristic = SkylineHeuristic::BOTTOM_LEFT);
+
+		std::optional<Rect<int>> insert(const int width, const int height, const bool allow_rotation = false);
+
+		void reset();
+
+		glm::uvec2 size() const;
+
+		uint64_t packed_area() const;
+
+		uint64_t covered_area() const;
+
+	};
+
 }
\ No newline at end of file
@@ -20,8 +20,20 @@
 
 #include "Graphics/Window.hpp"
 #include "Graphics/SpriteRenderer.hpp"
+#include "Graphics/GlyphCache.hpp"
 #include "Graphics/Resources/Shader.hpp"
 #include "Graphics/Resources/ShaderProgram.hpp"
 #include "Graphics/OpenGL/VertexArrayObject.hpp"
+#include "Graphics/OpenGL/StateCache.hpp"
+#include "Graphics/Resources/AtlasCache.hpp"
+#include "Graphics/Resources/BlockCompression.hpp"
+#include "Graphics/Resources/CompressedImage.hpp"
+#include "Graphics/Resources/DynamicTextureAtlas.hpp"
+#include "Graphics/Resources/Font.hpp"
+#include "Graphics/Resources/ImageKernels.hpp"
+#include "Graphics/Resources/ImageView.hpp"
+#include "Graphics/Resources/IndexedImage.hpp"
+#include "Graphics/Resources/QOI.hpp"
 #include "Graphics/Resources/Texture.hpp"
 #include "Graphics/Resources/TextureAtlas.hpp"
+#include "Graphics/Resources/TextureStreamer.hpp"
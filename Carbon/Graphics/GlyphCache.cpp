@@ -0,0 +1,285 @@
+#include "GlyphCache.hpp"
+
+#include <bit>
+#include <cmath>
+
+#include "../Diagnostics/Assert.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	size_t GlyphCache::RunHash::operator()(const RunView& run) const
+	{
+		return std::hash<std::string_view>{}(run.text) ^ (std::hash<float>{}(run.pixel_height) * 0x9E3779B97F4A7C15ull);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	size_t GlyphCache::RunHash::operator()(const RunKey& run) const
+	{
+		return operator()(RunView{run.text, run.pixel_height});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool GlyphCache::RunEqual::operator()(const RunKey& a, const RunKey& b) const
+	{
+		return a.pixel_height == b.pixel_height && a.text == b.text;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool GlyphCache::RunEqual::operator()(const RunKey& a, const RunView& b) const
+	{
+		return a.pixel_height == b.pixel_height && a.text == b.text;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool GlyphCache::RunEqual::operator()(const RunView& a, const RunKey& b) const
+	{
+		return a.pixel_height == b.pixel_height && a.text == b.text;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const ShapedText& GlyphCache::shape(const std::string_view& text, const float pixel_height)
+	{
+		const auto run = m_Runs.find(RunView{text, pixel_height});
+		if(run != m_Runs.end())
+			return run->second;
+
+		// Text which changes every frame would fill the cache with runs that are never drawn
+		// again, so once it is full the whole cache is dropped. Any text which is still being
+		// drawn is shaped again on its next use, which is far cheaper than tracking its usage.
+		if(m_Runs.size() >= m_Properties.max_cached_runs)
+			m_Runs.clear();
+
+		return m_Runs.emplace(RunKey{std::string(text), pixel_height}, m_Font->shape(text, pixel_height)).first->second;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const GlyphCache::Glyph* GlyphCache::acquire_glyph(TexturePack& pack, const uint32_t index, const float pixel_height)
+	{
+		const uint64_t key = (static_cast<uint64_t>(std::bit_cast<uint32_t>(pixel_height)) << 32) | index;
+
+		// Glyphs without an image are cached too, so that spaces are only checked once
+		const auto existing = m_Glyphs.find(key);
+		if(existing != m_Glyphs.end())
+		{
+			const Glyph& glyph = existing->second;
+			if(!glyph.handle.has_value())
+				return &glyph;
+
+			if(m_Atlas.contains(*glyph.handle))
+			{
+				m_Atlas.touch(*glyph.handle);
+				return &glyph;
+			}
+		}
+
+		// The glyph is new, or was evicted from the atlas since it was last used
+		glm::ivec2 offset;
+		const auto image = m_Font->rasterize(index, pixel_height, offset);
+		m_RasterizedCount++;
+
+		Glyph glyph = existing != m_Glyphs.end() ? existing->second : Glyph{Identifier(m_Name + ":" + std::to_string(key))};
+
+		// Glyphs too large to ever fit in a page are drawn as if they had no image
+		const auto& atlas_properties = m_Atlas.properties();
+		if(!image || image->width() + atlas_properties.padding > atlas_properties.page_size.x
+		|| image->height() + atlas_properties.padding > atlas_properties.page_size.y)
+		{
+			glyph.handle.reset();
+			return &(m_Glyphs[key] = glyph);
+		}
+
+		const int entry_count = m_Atlas.entry_count();
+		const auto handle = m_Atlas.insert(image);
+		if(!handle.has_value())
+		{
+			// The atlas can evict glyphs and still fail to find room, so their regions are freed
+			if(m_Atlas.entry_count() != entry_count)
+				sync_glyphs(pack);
+			return nullptr;
+		}
+
+		// An evicted glyph may land on a different page, so its old region is dropped
+		if(existing != m_Glyphs.end())
+			pack.remove_region(glyph.identifier);
+
+		const DynamicSubTexture subtexture = m_Atlas.get_subtexture(*handle);
+		if(!register_pages(pack) || !pack.set_region(m_Pages[subtexture.page], glyph.identifier, subtexture.uvs))
+		{
+			m_Atlas.remove(*handle);
+			return nullptr;
+		}
+
+		glyph.handle = handle;
+		glyph.page = subtexture.page;
+		glyph.rect = subtexture.rect;
+		glyph.offset = offset;
+		glyph.size = {image->width(), image->height()};
+		const Glyph& stored = (m_Glyphs[key] = glyph);
+
+		// Making room may have evicted other glyphs and repacked a page which had not been used
+		// this frame, so the regions of the evicted and moved glyphs must be updated.
+		if(m_Atlas.entry_count() != entry_count + 1)
+			sync_glyphs(pack);
+
+		return &stored;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool GlyphCache::register_pages(TexturePack& pack)
+	{
+		while(m_Pages.size() < static_cast<size_t>(m_Atlas.page_count()))
+		{
+			const Identifier page(m_Name + ":page:" + std::to_string(m_Pages.size()));
+			if(!pack.add({page, m_Atlas.page_texture(static_cast<unsigned>(m_Pages.size()))}))
+				return false;
+
+			m_Pages.push_back(page);
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void GlyphCache::sync_glyphs(TexturePack& pack)
+	{
+		for(auto it = m_Glyphs.begin(); it != m_Glyphs.end();)
+		{
+			Glyph& glyph = it->second;
+			if(!glyph.handle.has_value())
+			{
+				++it;
+				continue;
+			}
+
+			// Evicted glyphs give up their region, and are rasterized again if used
+			if(!m_Atlas.contains(*glyph.handle))
+			{
+				pack.remove_region(glyph.identifier);
+				it = m_Glyphs.erase(it);
+				continue;
+			}
+
+			const DynamicSubTexture subtexture = m_Atlas.get_subtexture(*glyph.handle);
+			if(subtexture.page != glyph.page || subtexture.rect.x != glyph.rect.x || subtexture.rect.y != glyph.rect.y)
+			{
+				if(subtexture.page != glyph.page)
+					pack.remove_region(glyph.identifier);
+
+				pack.set_region(m_Pages[subtexture.page], glyph.identifier, subtexture.uvs);
+				glyph.page = subtexture.page;
+				glyph.rect = subtexture.rect;
+			}
+			++it;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	GlyphCache::GlyphCache(const SRes<Font>& font, const String& name, const GlyphCacheProperties& properties)
+		: m_Font(font),
+		m_Name(name.as_std_string()),
+		m_Properties(properties),
+		m_Atlas(properties.atlas),
+		m_RasterizedCount(0)
+	{
+		CBN_Assert(font != nullptr, "Glyph cache requires a font");
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void GlyphCache::submit(SpriteRenderer& renderer, const std::string_view& text, const glm::vec2& position, const float pixel_height, const glm::uvec4& vertex_data)
+	{
+		const ShapedText& shaped = shape(text, pixel_height);
+		TexturePack& pack = renderer.texture_pack();
+
+		const glm::vec2 origin = glm::round(position);
+		for(const auto& [index, pen] : shaped.glyphs)
+		{
+			const Glyph* glyph = acquire_glyph(pack, index, pixel_height);
+			if(!glyph || !glyph->handle.has_value())
+				continue;
+
+			// The text is laid out with y pointing down, but y points up in the world
+			const float left = origin.x + std::round(pen.x) + glyph->offset.x;
+			const float top = origin.y - std::round(pen.y) - glyph->offset.y;
+			const float right = left + glyph->size.x;
+			const float bottom = top - glyph->size.y;
+
+			const std::array<glm::vec2, 4> vertices = {glm::vec2{left, top}, {left, bottom}, {right, bottom}, {right, top}};
+			renderer.submit(vertices, glyph->identifier, vertex_data);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	glm::vec2 GlyphCache::measure(const std::string_view& text, const float pixel_height)
+	{
+		return shape(text, pixel_height).size;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void GlyphCache::update(TexturePack& pack)
+	{
+		// Glyphs only move when a background repack finishes, which happens during the update
+		const bool repacking = m_Atlas.is_repacking();
+		m_Atlas.update();
+
+		if(repacking)
+			sync_glyphs(pack);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void GlyphCache::clear_runs()
+	{
+		m_Runs.clear();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t GlyphCache::rasterized_count() const
+	{
+		return m_RasterizedCount;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	int GlyphCache::glyph_count() const
+	{
+		return static_cast<int>(m_Glyphs.size());
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	int GlyphCache::run_count() const
+	{
+		return static_cast<int>(m_Runs.size());
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const SRes<Font>& GlyphCache::font() const
+	{
+		return m_Font;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const DynamicTextureAtlas& GlyphCache::atlas() const
+	{
+		return m_Atlas;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <unordered_map>
+#include <string_view>
+#include <optional>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+#include "../Data/Identity/Identifier.hpp"
+#include "Resources/DynamicTextureAtlas.hpp"
+#include "Resources/Font.hpp"
+#include "SpriteRenderer.hpp"
+#include "TexturePack.hpp"
+
+namespace cbn
+{
+
+	struct GlyphCacheProperties
+	{
+		DynamicAtlasProperties atlas = {{1024, 1024}, 2, 1, 0.25f, {}};
+		unsigned max_cached_runs = 1024;
+	};
+
+	// Draws text through a SpriteRenderer as one textured quad per glyph. Glyphs are rasterized
+	// on demand into a dynamic atlas, so each glyph is only rasterized once per size while it 
+	// stays in use. The atlas pages are added to the renderer's texture pack as entries named
+	// '<name>:page:<index>', with each glyph registered as a region of its page. Shaped runs of
+	// text are cached too, so that redrawing the same text only has to emit its quads. The
+	// cache must be updated once per frame, after all of the frame's text has been submitted.
+	class GlyphCache
+	{
+	private:
+
+		struct Glyph
+		{
+			Identifier identifier;
+			std::optional<uint32_t> handle = std::nullopt;
+			unsigned page = 0;
+			Rect<int> rect = {0, 0, 0, 0};
+			glm::vec2 offset = {0, 0};
+			glm::vec2 size = {0, 0};
+		};
+
+		struct RunKey
+		{
+			std::string text;
+			float pixel_height;
+		};
+
+		struct RunView
+		{
+			std::string_view text;
+			float pixel_height;
+		};
+
+		// Runs are looked up by a view of their text, so that finding a cached run never allocates
+		struct RunHash
+		{
+			using is_transparent = void;
+
+			size_t operator()(const RunView& run) const;
+			size_t operator()(const RunKey& run) const;
+		};
+
+		struct RunEqual
+		{
+			using is_transparent = void;
+
+			bool operator()(const RunKey& a, const RunKey& b) const;
+			bool operator()(const RunKey& a, const RunView& b) const;
+			bool operator()(const RunView& a, const RunKey& b) const;
+		};
+
+		const SRes<Font> m_Font;
+		const std::string m_Name;
+		const GlyphCacheProperties m_Properties;
+
+		DynamicTextureAtlas m_Atlas;
+		std::vector<Identifier> m_Pages;
+		std::unordered_map<uint64_t, Glyph> m_Glyphs;
+		std::unordered_map<RunKey, ShapedText, RunHash, RunEqual> m_Runs;
+		uint64_t m_RasterizedCount;
+
+		const ShapedText& shape(const std::string_view& text, const float pixel_height);
+
+		const Glyph* acquire_glyph(TexturePack& pack, const uint32_t index, const float pixel_height);
+
+		bool register_pages(TexturePack& pack);
+
+		void sync_glyphs(TexturePack& pack);
+
+	public:
+
+		GlyphCache(const SRes<Font>& font, const String& name, const GlyphCacheProperties& properties = {});
+
+		// Submits the text with the top left corner of its first line at the given position, 
+		// which is snapped to whole pixels so that the glyphs stay sharp. The batch must have
+		// room for a sprite per glyph, and glyphs which cannot fit in the atlas are skipped.
+		void submit(SpriteRenderer& renderer, const std::string_view& text, const glm::vec2& position, const float pixel_height, const glm::uvec4& vertex_data = {0, 0, 0, 0});
+
+		glm::vec2 measure(const std::string_view& text, const float pixel_height);
+
+		// Advances the atlas to the next frame, and moves any glyphs which it repacked.
+		// The texture pack must be the one that the text was submitted through.
+		void update(TexturePack& pack);
+
+		void clear_runs();
+
+		uint64_t rasterized_count() const;
+
+		int glyph_count() const;
+
+		int run_count() const;
+
+		const SRes<Font>& font() const;
+
+		const DynamicTextureAtlas& atlas() const;
+
+	};
+
+}
\ No newline at end of file
@@ -2,17 +2,12 @@
 
 #include "../../Utility/Enum.hpp"
 #include "../../Diagnostics/Assert.hpp"
+#include "StateCache.hpp"
 
 namespace cbn
 {
 	//-------------------------------------------------------------------------------------
 
-	// Initialize bound buffer state with all buffer types unbound. We do this via
-	// a zero-initialization of a raw array which is then converted to an std array.
-	std::array<GLuint, 3> Buffer::s_BoundBuffers = std::to_array<GLuint, 3>({0});
-
-	//-------------------------------------------------------------------------------------
-
 	GLenum Buffer::to_opengl_target(const BufferTarget& target)
 	{
 		switch(target)
@@ -20,6 +15,7 @@ namespace cbn
 			case BufferTarget::ELEMENT_BUFFER: return GL_ELEMENT_ARRAY_BUFFER;
 			case BufferTarget::UNIFORM_BUFFER: return GL_UNIFORM_BUFFER;
 			case BufferTarget::VERTEX_BUFFER: return GL_ARRAY_BUFFER;
+			case BufferTarget::PIXEL_UNPACK_BUFFER: return GL_PIXEL_UNPACK_BUFFER;
 		
 			default: CBN_Assert(false, "Undefined buffer target");
 		}
@@ -28,20 +24,33 @@ namespace cbn
 	
 	//-------------------------------------------------------------------------------------
 
-	Buffer::Buffer(const BufferTarget target)
-		: m_Target(target)
+	bool Buffer::supports_direct_state_access(const Version& opengl_version)
+	{
+		return opengl_version >= Version{4,5};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	Buffer::Buffer(const BufferTarget target, const Version& opengl_version)
+		: m_Target(target),
+		m_DirectStateAccess(supports_direct_state_access(opengl_version))
 	{
-		glGenBuffers(1, &m_BufferID);
+		// With direct state access, the buffer must be created with glCreateBuffers so that
+		// it is initialized without being bound. Buffers generated with glGenBuffers do not
+		// exist until their first bind, so they cannot be edited with the named functions.
+		if(m_DirectStateAccess)
+			glCreateBuffers(1, &m_BufferID);
+		else
+			glGenBuffers(1, &m_BufferID);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	Buffer::~Buffer()
 	{
-		// Before we destroy the object, we need to ensure the static bounded object tracker
-		// doesnt consider it as being bound. Otherwise issues will arise when a new object
-		// takes its ID.
-		unbind();
+		// Before we destroy the object, we need to ensure the state cache doesnt consider 
+		// it as being bound. Otherwise issues will arise when a new object takes its ID.
+		StateCache::ForgetBuffer(m_BufferID);
 		glDeleteBuffers(1, &m_BufferID);
 	}
 
@@ -49,8 +58,7 @@ namespace cbn
 
 	void Buffer::bind()
 	{
-		if(!is_bound())
-			force_bind();
+		StateCache::BindBuffer(to_opengl_target(m_Target), m_BufferID);
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -58,25 +66,21 @@ namespace cbn
 	void Buffer::unbind()
 	{
 		if(is_bound())
-		{
-			s_BoundBuffers[value(m_Target)] = 0;
-			glBindBuffer(to_opengl_target(m_Target), 0);
-		}
+			StateCache::BindBuffer(to_opengl_target(m_Target), 0);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	void Buffer::force_bind()
 	{
-		s_BoundBuffers[value(m_Target)] = m_BufferID;
-		glBindBuffer(to_opengl_target(m_Target), m_BufferID);
+		StateCache::BindBuffer(to_opengl_target(m_Target), m_BufferID, true);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	bool Buffer::is_bound() const
 	{
-		return s_BoundBuffers[value(m_Target)] == m_BufferID;
+		return StateCache::IsBufferBound(to_opengl_target(m_Target), m_BufferID);
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -1,7 +1,6 @@
 #pragma once
 
-#include <array>
-
+#include "../../Utility/Version.hpp"
 #include "OpenGL.hpp"
 
 namespace cbn
@@ -12,24 +11,29 @@ namespace cbn
 		ELEMENT_BUFFER,
 		UNIFORM_BUFFER,
 		VERTEX_BUFFER,
+		PIXEL_UNPACK_BUFFER,
 	};
 
 	class Buffer
 	{
-	private:
+		friend class VertexArrayObject;
 
-		static std::array<GLuint, 3> s_BoundBuffers;
+	private:
 
 		const BufferTarget m_Target;
-		GLuint m_BufferID;
 
 	protected:
 
+		const bool m_DirectStateAccess;
+		GLuint m_BufferID;
+
 		static GLenum to_opengl_target(const BufferTarget& target);
 
+		static bool supports_direct_state_access(const Version& opengl_version);
+
 	public:
 
-		Buffer(const BufferTarget target);
+		Buffer(const BufferTarget target, const Version& opengl_version);
 
 		~Buffer();
 
@@ -0,0 +1,268 @@
+#include "StateCache.hpp"
+
+#include "../../Diagnostics/Assert.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	std::array<GLuint, StateCache::c_BufferTargetCount> StateCache::s_BoundBuffers = {};
+	std::array<std::array<GLuint, StateCache::c_TextureTargetCount>, StateCache::TextureUnitCount> StateCache::s_BoundTextures = {};
+	GLuint StateCache::s_BoundVertexArray = 0;
+	GLuint StateCache::s_BoundProgram = 0;
+	GLuint StateCache::s_ActiveTextureUnit = 0;
+
+	bool StateCache::s_BlendingEnabled = false;
+	GLenum StateCache::s_BlendSourceFactor = GL_ONE;
+	GLenum StateCache::s_BlendDestinationFactor = GL_ZERO;
+
+	StateCacheStatistics StateCache::s_Statistics = {};
+	Version StateCache::s_ContextVersion = {};
+
+	//-------------------------------------------------------------------------------------
+
+	GLuint StateCache::buffer_slot(const GLenum target)
+	{
+		switch(target)
+		{
+			case GL_ARRAY_BUFFER: return 0;
+			case GL_ELEMENT_ARRAY_BUFFER: return 1;
+			case GL_UNIFORM_BUFFER: return 2;
+			case GL_TEXTURE_BUFFER: return 3;
+			case GL_PIXEL_UNPACK_BUFFER: return 4;
+			case GL_PIXEL_PACK_BUFFER: return 5;
+			case GL_COPY_READ_BUFFER: return 6;
+			case GL_COPY_WRITE_BUFFER: return 7;
+
+			default: CBN_Assert(false, "Buffer target is not tracked by the state cache");
+		}
+		return 0;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	GLuint StateCache::texture_slot(const GLenum target)
+	{
+		switch(target)
+		{
+			case GL_TEXTURE_2D: return 0;
+			case GL_TEXTURE_BUFFER: return 1;
+
+			default: CBN_Assert(false, "Texture target is not tracked by the state cache");
+		}
+		return 0;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StateCache::record(const bool redundant)
+	{
+		if(redundant)
+			s_Statistics.saved_calls++;
+		else
+			s_Statistics.issued_calls++;
+
+		return redundant;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::Reset(const Version& context_version)
+	{
+		s_ContextVersion = context_version;
+
+		// A freshly created context has nothing bound, texture unit 0 active and
+		// blending disabled with the default (GL_ONE, GL_ZERO) blend function.
+		s_BoundBuffers.fill(0);
+		for(auto& unit : s_BoundTextures)
+			unit.fill(0);
+
+		s_BoundVertexArray = 0;
+		s_BoundProgram = 0;
+		s_ActiveTextureUnit = 0;
+
+		s_BlendingEnabled = false;
+		s_BlendSourceFactor = GL_ONE;
+		s_BlendDestinationFactor = GL_ZERO;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::BindBuffer(const GLenum target, const GLuint buffer, const bool force)
+	{
+		GLuint& bound_buffer = s_BoundBuffers[buffer_slot(target)];
+
+		if(record(!force && bound_buffer == buffer))
+			return;
+
+		bound_buffer = buffer;
+		glBindBuffer(target, buffer);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::BindVertexArray(const GLuint vertex_array, const bool force)
+	{
+		if(record(!force && s_BoundVertexArray == vertex_array))
+			return;
+
+		// The element buffer binding is part of the vertex array's state rather than the
+		// context's. So once we switch vertex arrays we no longer know what is bound to it.
+		s_BoundBuffers[buffer_slot(GL_ELEMENT_ARRAY_BUFFER)] = c_UnknownBinding;
+
+		s_BoundVertexArray = vertex_array;
+		glBindVertexArray(vertex_array);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::UseProgram(const GLuint program, const bool force)
+	{
+		if(record(!force && s_BoundProgram == program))
+			return;
+
+		s_BoundProgram = program;
+		glUseProgram(program);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::ActivateTextureUnit(const GLuint texture_unit, const bool force)
+	{
+		CBN_Assert(texture_unit < TextureUnitCount, "Texture unit is out of range");
+
+		if(record(!force && s_ActiveTextureUnit == texture_unit))
+			return;
+
+		s_ActiveTextureUnit = texture_unit;
+		glActiveTexture(GL_TEXTURE0 + texture_unit);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::BindTexture(const GLuint texture_unit, const GLenum target, const GLuint texture, const bool force)
+	{
+		CBN_Assert(texture_unit < TextureUnitCount, "Texture unit is out of range");
+
+		GLuint& bound_texture = s_BoundTextures[texture_unit][texture_slot(target)];
+
+		if(record(!force && bound_texture == texture))
+			return;
+
+		// We only need to switch the active texture unit if the binding actually changes
+		ActivateTextureUnit(texture_unit, force);
+
+		bound_texture = texture;
+		glBindTexture(target, texture);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::SetBlending(const bool enabled)
+	{
+		if(record(s_BlendingEnabled == enabled))
+			return;
+
+		s_BlendingEnabled = enabled;
+		if(enabled)
+			glEnable(GL_BLEND);
+		else
+			glDisable(GL_BLEND);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::SetBlendFunction(const GLenum source_factor, const GLenum destination_factor)
+	{
+		if(record(s_BlendSourceFactor == source_factor && s_BlendDestinationFactor == destination_factor))
+			return;
+
+		s_BlendSourceFactor = source_factor;
+		s_BlendDestinationFactor = destination_factor;
+		glBlendFunc(source_factor, destination_factor);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::ForgetBuffer(const GLuint buffer)
+	{
+		// Deleting an object implicitly unbinds it from the context, so the cache only needs
+		// to be updated. Otherwise a new object which re-uses the ID would be seen as bound.
+		for(auto& bound_buffer : s_BoundBuffers)
+			if(bound_buffer == buffer)
+				bound_buffer = 0;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::ForgetTexture(const GLuint texture)
+	{
+		for(auto& unit : s_BoundTextures)
+			for(auto& bound_texture : unit)
+				if(bound_texture == texture)
+					bound_texture = 0;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::ForgetVertexArray(const GLuint vertex_array)
+	{
+		if(s_BoundVertexArray == vertex_array)
+		{
+			s_BoundVertexArray = 0;
+			s_BoundBuffers[buffer_slot(GL_ELEMENT_ARRAY_BUFFER)] = c_UnknownBinding;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StateCache::IsBufferBound(const GLenum target, const GLuint buffer)
+	{
+		return s_BoundBuffers[buffer_slot(target)] == buffer;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StateCache::IsTextureBound(const GLuint texture_unit, const GLenum target, const GLuint texture)
+	{
+		return s_BoundTextures[texture_unit][texture_slot(target)] == texture;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StateCache::IsVertexArrayBound(const GLuint vertex_array)
+	{
+		return s_BoundVertexArray == vertex_array;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StateCache::IsProgramBound(const GLuint program)
+	{
+		return s_BoundProgram == program;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	Version StateCache::ContextVersion()
+	{
+		return s_ContextVersion;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	StateCacheStatistics StateCache::Statistics()
+	{
+		return s_Statistics;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StateCache::ResetStatistics()
+	{
+		s_Statistics = {};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <stdint.h>
+#include <limits>
+#include <array>
+
+#include "../../Utility/Version.hpp"
+#include "OpenGL.hpp"
+
+namespace cbn
+{
+
+	struct StateCacheStatistics
+	{
+		uint64_t issued_calls = 0;
+		uint64_t saved_calls = 0;
+	};
+
+	// Tracks the binding state of the OpenGL context so that redundant state changes
+	// never reach the driver. Carbon only ever uses a single context, so the cache is
+	// static and must be reset whenever a new context is made current. Every wrapper
+	// object should change context state through here, rather than calling OpenGL directly.
+	class StateCache
+	{
+	public:
+
+		static constexpr GLuint TextureUnitCount = 32;
+
+	private:
+
+		static constexpr GLuint c_BufferTargetCount = 8;
+		static constexpr GLuint c_TextureTargetCount = 2;
+		static constexpr GLuint c_UnknownBinding = std::numeric_limits<GLuint>::max();
+
+		static std::array<GLuint, c_BufferTargetCount> s_BoundBuffers;
+		static std::array<std::array<GLuint, c_TextureTargetCount>, TextureUnitCount> s_BoundTextures;
+		static GLuint s_BoundVertexArray;
+		static GLuint s_BoundProgram;
+		static GLuint s_ActiveTextureUnit;
+
+		static bool s_BlendingEnabled;
+		static GLenum s_BlendSourceFactor, s_BlendDestinationFactor;
+
+		static StateCacheStatistics s_Statistics;
+		static Version s_ContextVersion;
+
+		static GLuint buffer_slot(const GLenum target);
+
+		static GLuint texture_slot(const GLenum target);
+
+		static bool record(const bool redundant);
+
+	public:
+
+		static void Reset(const Version& context_version);
+
+		static Version ContextVersion();
+
+		static void BindBuffer(const GLenum target, const GLuint buffer, const bool force = false);
+
+		static void BindVertexArray(const GLuint vertex_array, const bool force = false);
+
+		static void UseProgram(const GLuint program, const bool force = false);
+
+		static void ActivateTextureUnit(const GLuint texture_unit, const bool force = false);
+
+		static void BindTexture(const GLuint texture_unit, const GLenum target, const GLuint texture, const bool force = false);
+
+		static void SetBlending(const bool enabled);
+
+		static void SetBlendFunction(const GLenum source_factor, const GLenum destination_factor);
+
+		static void ForgetBuffer(const GLuint buffer);
+
+		static void ForgetTexture(const GLuint texture);
+
+		static void ForgetVertexArray(const GLuint vertex_array);
+
+		static bool IsBufferBound(const GLenum target, const GLuint buffer);
+
+		static bool IsTextureBound(const GLuint texture_unit, const GLenum target, const GLuint texture);
+
+		static bool IsVertexArrayBound(const GLuint vertex_array);
+
+		static bool IsProgramBound(const GLuint program);
+
+		static StateCacheStatistics Statistics();
+
+		static void ResetStatistics();
+
+	};
+
+}
\ No newline at end of file
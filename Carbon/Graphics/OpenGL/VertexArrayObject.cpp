@@ -1,61 +1,119 @@
 #include "VertexArrayObject.hpp"
 
-#include <iostream>
+#include "../../Diagnostics/Assert.hpp"
+#include "StateCache.hpp"
 
 namespace cbn
 {
 
 	//-------------------------------------------------------------------------------------
 
-	GLuint VertexArrayObject::s_BoundObjectID = 0;
-
-	//-------------------------------------------------------------------------------------
-
 	VertexArrayObject::VertexArrayObject()
-		: m_ObjectID(0)
+		: m_DirectStateAccess(StateCache::ContextVersion() >= Version{4,5}),
+		m_ObjectID(0)
 	{
-		glGenVertexArrays(1, &m_ObjectID);
+		if(m_DirectStateAccess)
+			glCreateVertexArrays(1, &m_ObjectID);
+		else
+			glGenVertexArrays(1, &m_ObjectID);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	VertexArrayObject::~VertexArrayObject()
 	{
-		// If the VAO is bound, we need to unbind it before we destroy it in order to
-		// ensure that s_BoundObjectID doesnt end up pointing to a destroyed objected. 
-		unbind();
+		// If the VAO is bound, the state cache needs to forget it before we destroy it 
+		// in order to ensure that it doesnt end up pointing to a destroyed objected. 
+		StateCache::ForgetVertexArray(m_ObjectID);
 		glDeleteVertexArrays(1, &m_ObjectID);
 	}
 
 	//-------------------------------------------------------------------------------------
 
-	void VertexArrayObject::bind() const
+	void VertexArrayObject::attach_element_buffer(Buffer& buffer)
+	{
+		CBN_Assert(buffer.get_target() == BufferTarget::ELEMENT_BUFFER, "Buffer is not an element buffer");
+
+		if(m_DirectStateAccess)
+		{
+			glVertexArrayElementBuffer(m_ObjectID, buffer.m_BufferID);
+		}
+		else
+		{
+			// The element buffer binding is part of the vertex array state
+			bind();
+			buffer.bind();
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void VertexArrayObject::set_attribute(const GLuint attribute, Buffer& buffer, const GLint components, const GLenum type, const GLsizei stride, const GLuint offset)
 	{
-		// Only bind the object if it is not already bound
-		if(!is_bound())
+		CBN_Assert(buffer.get_target() == BufferTarget::VERTEX_BUFFER, "Buffer is not a vertex buffer");
+
+		// With direct state access, each attribute is given its own buffer binding 
+		// point so that it maps directly onto the legacy vertex attribute pointers. 
+		if(m_DirectStateAccess)
+		{
+			glVertexArrayVertexBuffer(m_ObjectID, attribute, buffer.m_BufferID, offset, stride);
+			glVertexArrayAttribFormat(m_ObjectID, attribute, components, type, false, 0);
+			glVertexArrayAttribBinding(m_ObjectID, attribute, attribute);
+			glEnableVertexArrayAttrib(m_ObjectID, attribute);
+		}
+		else
 		{
-			s_BoundObjectID = m_ObjectID;
-			glBindVertexArray(m_ObjectID);
+			bind();
+			buffer.bind();
+			glVertexAttribPointer(attribute, components, type, false, stride, (void*)static_cast<uintptr_t>(offset));
+			glEnableVertexAttribArray(attribute);
 		}
 	}
 
 	//-------------------------------------------------------------------------------------
 
+	void VertexArrayObject::set_integer_attribute(const GLuint attribute, Buffer& buffer, const GLint components, const GLenum type, const GLsizei stride, const GLuint offset)
+	{
+		CBN_Assert(buffer.get_target() == BufferTarget::VERTEX_BUFFER, "Buffer is not a vertex buffer");
+
+		if(m_DirectStateAccess)
+		{
+			glVertexArrayVertexBuffer(m_ObjectID, attribute, buffer.m_BufferID, offset, stride);
+			glVertexArrayAttribIFormat(m_ObjectID, attribute, components, type, 0);
+			glVertexArrayAttribBinding(m_ObjectID, attribute, attribute);
+			glEnableVertexArrayAttrib(m_ObjectID, attribute);
+		}
+		else
+		{
+			bind();
+			buffer.bind();
+			glVertexAttribIPointer(attribute, components, type, stride, (void*)static_cast<uintptr_t>(offset));
+			glEnableVertexAttribArray(attribute);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void VertexArrayObject::bind() const
+	{
+		// The state cache will only bind the object if it is not already bound
+		StateCache::BindVertexArray(m_ObjectID);
+	}
+
+	//-------------------------------------------------------------------------------------
+
 	void VertexArrayObject::unbind() const
 	{
 		// Only unbind the object if it is actually bound
 		if(is_bound())
-		{
-			s_BoundObjectID = 0;
-			glBindVertexArray(0);
-		}
+			StateCache::BindVertexArray(0);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	bool VertexArrayObject::is_bound() const
 	{
-		return m_ObjectID == s_BoundObjectID;
+		return StateCache::IsVertexArrayBound(m_ObjectID);
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "OpenGL.hpp"
+#include "Buffer.hpp"
 
 namespace cbn
 {
@@ -9,8 +10,7 @@ namespace cbn
 	{
 	private:
 
-		static GLuint s_BoundObjectID;
-
+		const bool m_DirectStateAccess;
 		GLuint m_ObjectID;
 
 	public:
@@ -19,6 +19,12 @@ namespace cbn
 
 		~VertexArrayObject();
 
+		void attach_element_buffer(Buffer& buffer);
+
+		void set_attribute(const GLuint attribute, Buffer& buffer, const GLint components, const GLenum type, const GLsizei stride, const GLuint offset);
+
+		void set_integer_attribute(const GLuint attribute, Buffer& buffer, const GLint components, const GLenum type, const GLsizei stride, const GLuint offset);
+
 		void bind() const;
 
 		void unbind() const;
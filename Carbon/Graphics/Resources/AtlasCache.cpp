@@ -0,0 +1,487 @@
+#include "AtlasCache.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <fstream>
+#include <cstring>
+#include <cctype>
+#include <array>
+#include <span>
+
+#include "../../Memory/MappedFile.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	constexpr uint8_t c_AtlasIdentifier[8] = {'C', 'B', 'N', 'A', 'T', 'L', 'A', 'S'};
+	constexpr uint32_t c_FormatVersion = 2;
+	constexpr uint32_t c_RawFormat = 0;
+	constexpr uint64_t c_PixelAlignment = 16;
+
+	constexpr std::array c_SourceExtensions = {".png", ".qoi", ".cbnimg", ".jpg", ".jpeg", ".bmp", ".tga", ".gif", ".psd"};
+
+	// The file is laid out as the header, followed by the page, level and sub-texture
+	// tables, then the sub-texture names. The pixel data of each level comes last,
+	// with each level aligned so that it can be uploaded directly from the mapping.
+#pragma pack(push, 1)
+
+	struct AtlasHeader
+	{
+		uint8_t identifier[8];
+		uint32_t version;
+		uint32_t page_count;
+		uint32_t level_count;
+		uint32_t subtexture_count;
+		uint64_t source_hash;
+		uint64_t names_length;
+	};
+
+	struct AtlasPageRecord
+	{
+		uint32_t width;
+		uint32_t height;
+		uint32_t format;
+		uint32_t first_level;
+		uint32_t level_count;
+	};
+
+	struct AtlasLevelRecord
+	{
+		uint64_t offset;
+		uint64_t length;
+	};
+
+	struct AtlasSubTextureRecord
+	{
+		uint32_t page;
+		uint32_t name_offset;
+		uint32_t name_length;
+		int32_t x, y, width, height;
+		uint32_t rotated;
+		int32_t trim_x, trim_y;
+		int32_t source_width, source_height;
+		float uvs[8];
+	};
+
+#pragma pack(pop)
+
+	//-------------------------------------------------------------------------------------
+
+	class FNV1aHash
+	{
+	private:
+
+		uint64_t m_Hash = 0xcbf29ce484222325;
+
+	public:
+
+		void update(const void* data, const uint64_t size)
+		{
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			for(uint64_t i = 0; i < size; i++)
+				m_Hash = (m_Hash ^ bytes[i]) * 0x100000001b3;
+		}
+
+		template<typename T>
+		void update(const T& value)
+		{
+			update(&value, sizeof(T));
+		}
+
+		uint64_t value() const
+		{
+			return m_Hash;
+		}
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	IdentityMap<std::filesystem::path> AtlasCache::Gather(const std::filesystem::path& directory)
+	{
+		IdentityMap<std::filesystem::path> sources;
+		if(!std::filesystem::is_directory(directory))
+			return sources;
+
+		// Images are identified by their path relative to the directory, without the
+		// extension, so 'player/run_1.png' becomes 'player/run_1' on every platform.
+		for(const auto& entry : std::filesystem::recursive_directory_iterator(directory))
+		{
+			if(!entry.is_regular_file())
+				continue;
+
+			std::string extension = entry.path().extension().string();
+			std::transform(extension.begin(), extension.end(), extension.begin(), [](const char c){ return std::tolower(c); });
+			if(std::find(c_SourceExtensions.begin(), c_SourceExtensions.end(), extension) == c_SourceExtensions.end())
+				continue;
+
+			const auto relative = std::filesystem::relative(entry.path(), directory).replace_extension();
+			sources[Identifier(relative.generic_string())] = entry.path();
+		}
+
+		return sources;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<uint64_t> AtlasCache::SourceHash(const IdentityMap<std::filesystem::path>& sources, const AtlasBakeSettings& settings)
+	{
+		FNV1aHash hash;
+		hash.update(c_FormatVersion);
+		hash.update(settings.page_size.x);
+		hash.update(settings.page_size.y);
+		hash.update(settings.packing.algorithm);
+		hash.update(settings.packing.heuristic);
+		hash.update(settings.packing.search_heuristics);
+		hash.update(settings.packing.allow_image_rotation);
+		hash.update(settings.packing.shrink_to_footprint);
+		hash.update(settings.packing.padding);
+		hash.update(settings.packing.trim_transparency);
+		hash.update(settings.packing.deduplicate);
+		hash.update(settings.compression.value_or(static_cast<CompressedFormat>(c_RawFormat)));
+		hash.update(settings.compression_quality);
+
+		// The identity map has no defined order, so the sources are sorted by
+		// name to make sure the same sources always produce the same hash.
+		std::vector<std::pair<std::string, std::filesystem::path>> ordered;
+		for(const auto& [identity, path] : sources)
+			ordered.emplace_back(identity.alias().as_std_string(), path);
+		std::sort(ordered.begin(), ordered.end());
+
+		std::vector<char> buffer(1 << 16);
+		for(const auto& [name, path] : ordered)
+		{
+			hash.update(name.data(), name.size() + 1);
+
+			std::ifstream file(MappedFile::Resolve(path), std::ios::binary);
+			if(!file)
+				return std::nullopt;
+
+			while(file)
+			{
+				file.read(buffer.data(), buffer.size());
+				hash.update(buffer.data(), file.gcount());
+			}
+		}
+
+		return hash.value();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<uint64_t> AtlasCache::BakedHash(const std::filesystem::path& path)
+	{
+		std::ifstream file(MappedFile::Resolve(path), std::ios::binary);
+		if(!file)
+			return std::nullopt;
+
+		AtlasHeader header;
+		if(!file.read(reinterpret_cast<char*>(&header), sizeof(AtlasHeader))
+		|| std::memcmp(header.identifier, c_AtlasIdentifier, sizeof(c_AtlasIdentifier)) != 0
+		|| header.version != c_FormatVersion)
+			return std::nullopt;
+
+		return header.source_hash;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool AtlasCache::Bake(const std::filesystem::path& path, const IdentityMap<std::filesystem::path>& sources, const AtlasBakeSettings& settings)
+	{
+		const auto source_hash = SourceHash(sources, settings);
+		if(!source_hash)
+			return false;
+
+		return bake(path, sources, settings, *source_hash);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool AtlasCache::bake(const std::filesystem::path& path, const IdentityMap<std::filesystem::path>& sources, const AtlasBakeSettings& settings, const uint64_t source_hash)
+	{
+		if(sources.empty())
+			return false;
+
+		std::vector<Identifier> identities;
+		std::vector<std::filesystem::path> paths;
+		for(const auto& [identity, source] : sources)
+		{
+			identities.push_back(identity);
+			paths.push_back(source);
+		}
+
+		IdentityMap<SRes<Image>> images;
+		const auto loaded = Image::OpenMany(paths);
+		for(size_t i = 0; i < loaded.size(); i++)
+		{
+			const auto& [image, error] = loaded[i];
+			if(!image)
+				return false;
+
+			images[identities[i]] = image;
+		}
+
+		const auto& size = settings.page_size;
+		const auto pages = TextureAtlas::Paginate(size.x, size.y, images, settings.packing);
+		if(pages.empty())
+			return false;
+
+		std::vector<AtlasPageRecord> page_records;
+		std::vector<AtlasLevelRecord> level_records;
+		std::vector<AtlasSubTextureRecord> subtexture_records;
+		std::vector<std::span<const uint8_t>> levels;
+		std::vector<SRes<Image>> raw_pages;
+		std::vector<SRes<CompressedImage>> compressed_pages;
+		std::string names;
+
+		for(const auto& page : pages)
+		{
+			IdentityMap<AtlasRegion> regions;
+			auto page_image = TextureAtlas::Compose(size.x, size.y, page, settings.packing, regions);
+			if(!page_image)
+				return false;
+
+			const uint32_t page_index = static_cast<uint32_t>(page_records.size());
+			for(const auto& [identity, region] : regions)
+			{
+				const std::string name = identity.alias().as_std_string();
+				const TextureUVMap uvs = TextureAtlas::calculate_uvs(region.rect, region.rotated, page_image->resolution());
+
+				AtlasSubTextureRecord record = {
+					page_index,
+					static_cast<uint32_t>(names.size()),
+					static_cast<uint32_t>(name.size()),
+					region.rect.x, region.rect.y, region.rect.width, region.rect.height,
+					region.rotated,
+					region.trim_offset.x, region.trim_offset.y,
+					region.source_resolution.x, region.source_resolution.y,
+					{uvs.uv_1.x, uvs.uv_1.y, uvs.uv_2.x, uvs.uv_2.y, uvs.uv_3.x, uvs.uv_3.y, uvs.uv_4.x, uvs.uv_4.y}
+				};
+				subtexture_records.push_back(record);
+				names += name;
+			}
+
+			if(settings.compression)
+			{
+				auto compressed = CompressedImage::Encode(page_image->view(), *settings.compression, settings.compression_quality, true, settings.thread_count);
+				if(!compressed)
+					return false;
+
+				page_records.push_back({
+					compressed->width(),
+					compressed->height(),
+					static_cast<uint32_t>(compressed->format()),
+					static_cast<uint32_t>(levels.size()),
+					compressed->levels()
+				});
+
+				for(unsigned l = 0; l < compressed->levels(); l++)
+					levels.emplace_back(compressed->level_data(l), compressed->level_size(l));
+				compressed_pages.push_back(compressed);
+			}
+			else
+			{
+				page_records.push_back({
+					page_image->width(),
+					page_image->height(),
+					c_RawFormat,
+					static_cast<uint32_t>(levels.size()),
+					1
+				});
+
+				levels.emplace_back(reinterpret_cast<const uint8_t*>(page_image->data()), page_image->byte_size());
+				raw_pages.push_back(page_image);
+			}
+		}
+
+		// Work out where each level will be placed, after all of the tables
+		uint64_t offset = sizeof(AtlasHeader)
+			+ page_records.size() * sizeof(AtlasPageRecord)
+			+ levels.size() * sizeof(AtlasLevelRecord)
+			+ subtexture_records.size() * sizeof(AtlasSubTextureRecord)
+			+ names.size();
+
+		for(const auto& level : levels)
+		{
+			offset = (offset + c_PixelAlignment - 1) / c_PixelAlignment * c_PixelAlignment;
+			level_records.push_back({offset, level.size()});
+			offset += level.size();
+		}
+
+		AtlasHeader header = {};
+		std::memcpy(header.identifier, c_AtlasIdentifier, sizeof(c_AtlasIdentifier));
+		header.version = c_FormatVersion;
+		header.page_count = static_cast<uint32_t>(page_records.size());
+		header.level_count = static_cast<uint32_t>(level_records.size());
+		header.subtexture_count = static_cast<uint32_t>(subtexture_records.size());
+		header.source_hash = source_hash;
+		header.names_length = names.size();
+
+		// The atlas is written to a temporary file first and then moved over the
+		// old atlas, so that a failed bake can never leave behind a corrupted file.
+		const auto temporary_path = std::filesystem::path(path).concat(".tmp");
+		{
+			std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+			if(!file)
+				return false;
+
+			file.write(reinterpret_cast<const char*>(&header), sizeof(AtlasHeader));
+			file.write(reinterpret_cast<const char*>(page_records.data()), page_records.size() * sizeof(AtlasPageRecord));
+			file.write(reinterpret_cast<const char*>(level_records.data()), level_records.size() * sizeof(AtlasLevelRecord));
+			file.write(reinterpret_cast<const char*>(subtexture_records.data()), subtexture_records.size() * sizeof(AtlasSubTextureRecord));
+			file.write(names.data(), names.size());
+
+			for(size_t l = 0; l < levels.size(); l++)
+			{
+				const auto padding = level_records[l].offset - static_cast<uint64_t>(file.tellp());
+				const char zeros[c_PixelAlignment] = {};
+				file.write(zeros, padding);
+				file.write(reinterpret_cast<const char*>(levels[l].data()), levels[l].size());
+			}
+
+			if(!file)
+				return false;
+		}
+
+		// If the old atlas is still mapped, it is replaced on its next load
+		return MappedFile::Replace(temporary_path, path);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::vector<SRes<TextureAtlas>> AtlasCache::Load(const std::filesystem::path& path, const TextureSettings& settings)
+	{
+		const auto file = MappedFile::Open(path);
+		if(!file || file->size() < sizeof(AtlasHeader))
+			return {};
+
+		const uint8_t* data = file->data();
+		const uint64_t size = file->size();
+
+		AtlasHeader header;
+		std::memcpy(&header, data, sizeof(AtlasHeader));
+		if(std::memcmp(header.identifier, c_AtlasIdentifier, sizeof(c_AtlasIdentifier)) != 0 || header.version != c_FormatVersion)
+			return {};
+
+		// The counts are 32 bit, so the size of the tables cannot overflow
+		const uint64_t pages_offset = sizeof(AtlasHeader);
+		const uint64_t levels_offset = pages_offset + static_cast<uint64_t>(header.page_count) * sizeof(AtlasPageRecord);
+		const uint64_t subtextures_offset = levels_offset + static_cast<uint64_t>(header.level_count) * sizeof(AtlasLevelRecord);
+		const uint64_t names_offset = subtextures_offset + static_cast<uint64_t>(header.subtexture_count) * sizeof(AtlasSubTextureRecord);
+		if(names_offset > size || header.names_length > size - names_offset)
+			return {};
+
+		std::vector<AtlasPageRecord> page_records(header.page_count);
+		std::vector<AtlasLevelRecord> level_records(header.level_count);
+		std::vector<AtlasSubTextureRecord> subtexture_records(header.subtexture_count);
+		std::memcpy(page_records.data(), data + pages_offset, page_records.size() * sizeof(AtlasPageRecord));
+		std::memcpy(level_records.data(), data + levels_offset, level_records.size() * sizeof(AtlasLevelRecord));
+		std::memcpy(subtexture_records.data(), data + subtextures_offset, subtexture_records.size() * sizeof(AtlasSubTextureRecord));
+		const char* names = reinterpret_cast<const char*>(data + names_offset);
+
+		std::vector<SRes<Texture>> textures;
+		for(const auto& page : page_records)
+		{
+			// The level count is bounded by the length of a full mipmap chain, which also keeps
+			// the level shifts below in range, and the format must be one that we can upload.
+			const bool raw = page.format == c_RawFormat;
+			if(page.width == 0 || page.height == 0 || page.level_count == 0
+			|| page.level_count > static_cast<uint32_t>(std::bit_width(std::max(page.width, page.height)))
+			|| page.first_level > level_records.size() || page.level_count > level_records.size() - page.first_level
+			|| (!raw && !CompressedImage::IsCompressedFormat(page.format)))
+				return {};
+
+			// Every level must lie within the file and be exactly the size that its format requires
+			std::vector<std::span<const uint8_t>> levels;
+			for(uint32_t l = 0; l < page.level_count; l++)
+			{
+				const auto& level = level_records[page.first_level + l];
+				const uint64_t level_width = std::max(page.width >> l, 1u);
+				const uint64_t level_height = std::max(page.height >> l, 1u);
+				const uint64_t expected_length = raw
+					? level_width * level_height * sizeof(Colour)
+					: ((level_width + 3) / 4) * ((level_height + 3) / 4) * CompressedImage::BlockSize(static_cast<CompressedFormat>(page.format));
+
+				if(level.length != expected_length || level.offset > size || level.length > size - level.offset)
+					return {};
+
+				levels.emplace_back(data + level.offset, level.length);
+			}
+
+			// Raw pages only hold the base level, any mipmaps are generated on the GPU
+			SRes<Texture> texture;
+			if(raw)
+			{
+				if(page.level_count != 1)
+					return {};
+
+				texture = Texture::Create(page.width, page.height, settings);
+				if(!texture)
+					return {};
+
+				texture->upload(reinterpret_cast<const Colour*>(levels.front().data()), 0, 0, page.width, page.height);
+				if(settings.mipmaps != TextureMipmaps::NONE)
+					texture->generate_mipmaps();
+			}
+			else texture = Texture::Create(static_cast<CompressedFormat>(page.format), page.width, page.height, levels, settings);
+
+			if(!texture)
+				return {};
+
+			textures.push_back(texture);
+		}
+
+		// The UVs were already calculated during the bake, so the
+		// sub-textures are created directly from the stored records.
+		std::vector<std::vector<SubTexture>> subtextures(textures.size());
+		for(const auto& record : subtexture_records)
+		{
+			if(record.page >= textures.size() || record.name_offset > header.names_length || record.name_length > header.names_length - record.name_offset)
+				return {};
+
+			const auto& texture = textures[record.page];
+			const Rect<int> rect = {record.x, record.y, record.width, record.height};
+			if(rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0
+			|| static_cast<unsigned>(rect.x + rect.width) > texture->width()
+			|| static_cast<unsigned>(rect.y + rect.height) > texture->height())
+				return {};
+
+			const TextureUVMap uvs = {
+				{record.uvs[0], record.uvs[1]},
+				{record.uvs[2], record.uvs[3]},
+				{record.uvs[4], record.uvs[5]},
+				{record.uvs[6], record.uvs[7]}
+			};
+
+			const Identifier identity(std::string(names + record.name_offset, record.name_length));
+			const glm::ivec2 trim_offset = {record.trim_x, record.trim_y};
+			const glm::ivec2 source_resolution = {record.source_width, record.source_height};
+			subtextures[record.page].emplace_back(identity, record.rotated != 0, uvs, rect, trim_offset, source_resolution);
+		}
+
+		std::vector<SRes<TextureAtlas>> atlases;
+		for(size_t p = 0; p < textures.size(); p++)
+			atlases.push_back(Resource::WrapShared(new TextureAtlas(textures[p], subtextures[p])));
+
+		return atlases;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::vector<SRes<TextureAtlas>> AtlasCache::Open(const std::filesystem::path& path, const IdentityMap<std::filesystem::path>& sources, const AtlasBakeSettings& bake_settings, const TextureSettings& settings)
+	{
+		// Only the source files are hashed, which is much cheaper than decoding
+		// and packing them, and the atlas is only re-baked if anything changed.
+		const auto source_hash = SourceHash(sources, bake_settings);
+		if(!source_hash)
+			return {};
+
+		if(BakedHash(path) != source_hash && !bake(path, sources, bake_settings, *source_hash))
+			return {};
+
+		return Load(path, settings);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <filesystem>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+
+#include "../../Data/Identity/Identifier.hpp"
+#include "../../Memory/Resource.hpp"
+#include "CompressedImage.hpp"
+#include "TextureAtlas.hpp"
+
+namespace cbn
+{
+
+	struct AtlasBakeSettings
+	{
+		glm::uvec2 page_size = {2048, 2048};
+		TexturePackingSettings packing = {};
+
+		// Pages are block compressed with their full chain of mipmaps when a compression
+		// format is given, otherwise they are stored raw. Compression is split across the
+		// given number of threads, or one per hardware thread if it is zero.
+		std::optional<CompressedFormat> compression = std::nullopt;
+		CompressionQuality compression_quality = CompressionQuality::FAST;
+		unsigned thread_count = 0;
+	};
+
+	// Bakes a set of source images into a binary file holding the packed pages and the layout
+	// of their sub-textures, so that loading an atlas is a single upload per page instead of
+	// decoding, packing and compositing every image. The file is memory mapped when loaded, so
+	// the pixels are uploaded straight from the mapping. Each bake records a hash of the source
+	// files and settings, which is used to detect when the atlas is stale and must be re-baked.
+	class AtlasCache
+	{
+	public:
+
+		static IdentityMap<std::filesystem::path> Gather(const std::filesystem::path& directory);
+
+		static std::optional<uint64_t> SourceHash(const IdentityMap<std::filesystem::path>& sources, const AtlasBakeSettings& settings = {});
+
+		static std::optional<uint64_t> BakedHash(const std::filesystem::path& path);
+
+		static bool Bake(const std::filesystem::path& path, const IdentityMap<std::filesystem::path>& sources, const AtlasBakeSettings& settings = {});
+
+		static std::vector<SRes<TextureAtlas>> Load(const std::filesystem::path& path, const TextureSettings& settings = {});
+
+		static std::vector<SRes<TextureAtlas>> Open(const std::filesystem::path& path, const IdentityMap<std::filesystem::path>& sources, const AtlasBakeSettings& bake_settings = {}, const TextureSettings& settings = {});
+
+	private:
+
+		static bool bake(const std::filesystem::path& path, const IdentityMap<std::filesystem::path>& sources, const AtlasBakeSettings& settings, const uint64_t source_hash);
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,1064 @@
+#include "BlockCompression.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <array>
+#include <cmath>
+
+#include "../../Diagnostics/Assert.hpp"
+#include "ImageKernels.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	constexpr unsigned c_BlockPixels = 16;
+
+	// BC7 interpolates between endpoints with 2, 3 or 4-bit indices, using these weights
+	constexpr int c_BC7Weights2[4] = {0, 21, 43, 64};
+	constexpr int c_BC7Weights3[8] = {0, 9, 18, 27, 37, 46, 55, 64};
+	constexpr int c_BC7Weights4[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+
+	// Higher qualities spend more least squares refinements on the endpoints of each block
+	constexpr unsigned c_Refinements[] = {1, 2, 4};
+
+	//-------------------------------------------------------------------------------------
+
+	// The colours of a block as floats, with alpha ignored by the formats which store it apart
+	struct BlockColours
+	{
+		float values[c_BlockPixels][4];
+		unsigned count;
+	};
+
+	// Interpolated palettes for BC1 blocks which hold a single colour, so that the colour can
+	// be matched more closely than its RGB565 endpoints alone would allow. Each entry holds
+	// the pair of endpoints whose two thirds interpolant is nearest to the 8-bit value.
+	struct SingleColourTables
+	{
+		std::array<std::array<uint8_t, 2>, 256> five_bit;
+		std::array<std::array<uint8_t, 2>, 256> six_bit;
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	unsigned expand_5(const unsigned value)
+	{
+		return (value << 3) | (value >> 2);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	unsigned expand_6(const unsigned value)
+	{
+		return (value << 2) | (value >> 4);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const SingleColourTables& single_colour_tables()
+	{
+		static const SingleColourTables tables = []()
+		{
+			const auto build = [](std::array<std::array<uint8_t, 2>, 256>& table, const unsigned levels, unsigned (*expand)(const unsigned))
+			{
+				for(int value = 0; value < 256; value++)
+				{
+					int best_error = std::numeric_limits<int>::max();
+					for(unsigned a = 0; a < levels; a++)
+					{
+						for(unsigned b = 0; b < levels; b++)
+						{
+							const int error = std::abs(static_cast<int>((2 * expand(a) + expand(b)) / 3) - value);
+							if(error < best_error)
+							{
+								best_error = error;
+								table[value] = {static_cast<uint8_t>(a), static_cast<uint8_t>(b)};
+							}
+						}
+					}
+				}
+			};
+
+			SingleColourTables tables;
+			build(tables.five_bit, 32, expand_5);
+			build(tables.six_bit, 64, expand_6);
+			return tables;
+		}();
+
+		return tables;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Gathers a 4x4 block of pixels, repeating the last row and column of the image to fill
+	// out the blocks which hang over its edges.
+	void load_block(const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height, const unsigned x, const unsigned y, Colour* block)
+	{
+		for(unsigned j = 0; j < 4; j++)
+		{
+			const Colour* row = src + static_cast<size_t>(std::min(y + j, height - 1)) * src_stride;
+			if(x + 4 <= width)
+			{
+				std::copy_n(row + x, 4, block + j * 4);
+				continue;
+			}
+
+			for(unsigned i = 0; i < 4; i++)
+				block[j * 4 + i] = row[std::min(x + i, width - 1)];
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool is_uniform(const Colour* block)
+	{
+		for(unsigned i = 1; i < c_BlockPixels; i++)
+			if(block[i].hex != block[0].hex)
+				return false;
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Fits a line through the colours along their principal axis, which is found by power
+	// iteration on their covariance, and returns the extent of the colours along that line.
+	void fit_line(const BlockColours& colours, const unsigned channels, float* start, float* end)
+	{
+		float mean[4] = {}, low[4] = {255.0f, 255.0f, 255.0f, 255.0f}, high[4] = {};
+		for(unsigned i = 0; i < colours.count; i++)
+		{
+			for(unsigned c = 0; c < channels; c++)
+			{
+				mean[c] += colours.values[i][c];
+				low[c] = std::min(low[c], colours.values[i][c]);
+				high[c] = std::max(high[c], colours.values[i][c]);
+			}
+		}
+		for(unsigned c = 0; c < channels; c++)
+			mean[c] /= static_cast<float>(colours.count);
+
+		float covariance[4][4] = {};
+		for(unsigned i = 0; i < colours.count; i++)
+		{
+			float offset[4];
+			for(unsigned c = 0; c < channels; c++)
+				offset[c] = colours.values[i][c] - mean[c];
+
+			for(unsigned a = 0; a < channels; a++)
+				for(unsigned b = a; b < channels; b++)
+					covariance[a][b] += offset[a] * offset[b];
+		}
+		for(unsigned a = 0; a < channels; a++)
+			for(unsigned b = 0; b < a; b++)
+				covariance[a][b] = covariance[b][a];
+
+		// The diagonal of the bounding box is already close to the axis for most blocks
+		float axis[4] = {};
+		for(unsigned c = 0; c < channels; c++)
+			axis[c] = high[c] - low[c];
+
+		for(unsigned iteration = 0; iteration < 4; iteration++)
+		{
+			float next[4] = {}, length = 0.0f;
+			for(unsigned a = 0; a < channels; a++)
+			{
+				for(unsigned b = 0; b < channels; b++)
+					next[a] += covariance[a][b] * axis[b];
+				length = std::max(length, std::abs(next[a]));
+			}
+
+			if(length < 1e-6f)
+				break;
+
+			for(unsigned c = 0; c < channels; c++)
+				axis[c] = next[c] / length;
+		}
+
+		float axis_length = 0.0f;
+		for(unsigned c = 0; c < channels; c++)
+			axis_length += axis[c] * axis[c];
+
+		float min_t = 0.0f, max_t = 0.0f;
+		if(axis_length > 1e-6f)
+		{
+			min_t = std::numeric_limits<float>::max();
+			max_t = std::numeric_limits<float>::lowest();
+			for(unsigned i = 0; i < colours.count; i++)
+			{
+				float t = 0.0f;
+				for(unsigned c = 0; c < channels; c++)
+					t += (colours.values[i][c] - mean[c]) * axis[c];
+
+				min_t = std::min(min_t, t);
+				max_t = std::max(max_t, t);
+			}
+			min_t /= axis_length;
+			max_t /= axis_length;
+		}
+
+		for(unsigned c = 0; c < channels; c++)
+		{
+			start[c] = std::clamp(mean[c] + axis[c] * min_t, 0.0f, 255.0f);
+			end[c] = std::clamp(mean[c] + axis[c] * max_t, 0.0f, 255.0f);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Solves for the endpoints which best fit the colours in the least squares sense, given
+	// the weight of the second endpoint in each colour. Returns false if the system is
+	// degenerate, which happens when every colour uses the same weight.
+	bool fit_endpoints(const BlockColours& colours, const float* weights, const unsigned channels, float* start, float* end)
+	{
+		float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+		float ax[4] = {}, bx[4] = {};
+		for(unsigned i = 0; i < colours.count; i++)
+		{
+			const float b = weights[i], a = 1.0f - b;
+			aa += a * a;
+			ab += a * b;
+			bb += b * b;
+			for(unsigned c = 0; c < channels; c++)
+			{
+				ax[c] += a * colours.values[i][c];
+				bx[c] += b * colours.values[i][c];
+			}
+		}
+
+		const float determinant = aa * bb - ab * ab;
+		if(std::abs(determinant) < 1e-6f)
+			return false;
+
+		const float inverse = 1.0f / determinant;
+		for(unsigned c = 0; c < channels; c++)
+		{
+			start[c] = std::clamp((bb * ax[c] - ab * bx[c]) * inverse, 0.0f, 255.0f);
+			end[c] = std::clamp((aa * bx[c] - ab * ax[c]) * inverse, 0.0f, 255.0f);
+		}
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint16_t pack_565(const float* colour)
+	{
+		const unsigned red = static_cast<unsigned>(colour[0] * (31.0f / 255.0f) + 0.5f);
+		const unsigned green = static_cast<unsigned>(colour[1] * (63.0f / 255.0f) + 0.5f);
+		const unsigned blue = static_cast<unsigned>(colour[2] * (31.0f / 255.0f) + 0.5f);
+		return static_cast<uint16_t>((red << 11) | (green << 5) | blue);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Builds the palette of a BC1 colour block the same way as the GPU decodes it. Blocks with
+	// the first endpoint greater than the second interpolate four colours, otherwise they have
+	// three colours and transparent black, unless the format always uses four colours.
+	void bc1_palette(const uint16_t first, const uint16_t second, const bool four_colours, float palette[4][3])
+	{
+		const float a[3] = {
+			static_cast<float>(expand_5(first >> 11)),
+			static_cast<float>(expand_6((first >> 5) & 63)),
+			static_cast<float>(expand_5(first & 31))
+		};
+		const float b[3] = {
+			static_cast<float>(expand_5(second >> 11)),
+			static_cast<float>(expand_6((second >> 5) & 63)),
+			static_cast<float>(expand_5(second & 31))
+		};
+
+		for(unsigned c = 0; c < 3; c++)
+		{
+			palette[0][c] = a[c];
+			palette[1][c] = b[c];
+			if(four_colours)
+			{
+				palette[2][c] = std::floor((2.0f * a[c] + b[c]) / 3.0f);
+				palette[3][c] = std::floor((a[c] + 2.0f * b[c]) / 3.0f);
+			}
+			else
+			{
+				palette[2][c] = std::floor((a[c] + b[c]) / 2.0f);
+				palette[3][c] = 0.0f;
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Gives each colour the index of its nearest palette entry, returning the total error
+	float bc1_indices(const BlockColours& colours, const float palette[4][3], const unsigned entries, uint8_t* indices)
+	{
+		float total = 0.0f;
+		for(unsigned i = 0; i < colours.count; i++)
+		{
+			float best = std::numeric_limits<float>::max();
+			for(unsigned e = 0; e < entries; e++)
+			{
+				const float r = colours.values[i][0] - palette[e][0];
+				const float g = colours.values[i][1] - palette[e][1];
+				const float b = colours.values[i][2] - palette[e][2];
+				const float error = r * r + g * g + b * b;
+				if(error < best)
+				{
+					best = error;
+					indices[i] = static_cast<uint8_t>(e);
+				}
+			}
+			total += best;
+		}
+		return total;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void write_bc1_block(const uint16_t first, const uint16_t second, const uint32_t indices, uint8_t* output)
+	{
+		output[0] = static_cast<uint8_t>(first);
+		output[1] = static_cast<uint8_t>(first >> 8);
+		output[2] = static_cast<uint8_t>(second);
+		output[3] = static_cast<uint8_t>(second >> 8);
+		std::memcpy(output + 4, &indices, sizeof(uint32_t));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Encodes the colours of a block in BC1. Pixels with an alpha below 128 are made transparent
+	// if punchthrough is enabled, which needs a three colour block. Otherwise four colours are
+	// used, and the best quality also tries three colours if the format allows it. BC3 always
+	// decodes its colours as four colour blocks, whatever the order of the endpoints.
+	void encode_bc1_block(const Colour* pixels, const bool punchthrough, const bool always_four, const CompressionQuality quality, uint8_t* output)
+	{
+		BlockColours colours;
+		colours.count = 0;
+		uint8_t slots[c_BlockPixels];
+		for(unsigned i = 0; i < c_BlockPixels; i++)
+		{
+			if(punchthrough && pixels[i].alpha < 128)
+			{
+				slots[i] = c_BlockPixels;
+				continue;
+			}
+
+			slots[i] = static_cast<uint8_t>(colours.count);
+			colours.values[colours.count][0] = pixels[i].red;
+			colours.values[colours.count][1] = pixels[i].green;
+			colours.values[colours.count][2] = pixels[i].blue;
+			colours.count++;
+		}
+
+		// Three colour blocks with equal endpoints, where every pixel uses transparent black
+		if(colours.count == 0)
+		{
+			write_bc1_block(0, 0, 0xFFFFFFFF, output);
+			return;
+		}
+		const bool transparent = colours.count < c_BlockPixels;
+
+		// Blocks of a single colour can use endpoints which interpolate to a closer match
+		bool single_colour = !transparent;
+		for(unsigned i = 1; i < c_BlockPixels && single_colour; i++)
+			single_colour = (pixels[i].hex & 0x00FFFFFF) == (pixels[0].hex & 0x00FFFFFF);
+
+		if(single_colour)
+		{
+			const auto& tables = single_colour_tables();
+			const auto& red = tables.five_bit[pixels[0].red];
+			const auto& green = tables.six_bit[pixels[0].green];
+			const auto& blue = tables.five_bit[pixels[0].blue];
+			const uint16_t first = static_cast<uint16_t>((red[0] << 11) | (green[0] << 5) | blue[0]);
+			const uint16_t second = static_cast<uint16_t>((red[1] << 11) | (green[1] << 5) | blue[1]);
+
+			// The matching interpolant is the third entry, or the fourth if the endpoints swap
+			if(first > second || (always_four && first == second))
+				write_bc1_block(first, second, 0xAAAAAAAA, output);
+			else if(first < second)
+				write_bc1_block(second, first, 0xFFFFFFFF, output);
+			else
+				write_bc1_block(first, second, 0, output);
+			return;
+		}
+
+		float start[4], end[4];
+		fit_line(colours, 3, start, end);
+
+		const bool try_four = !transparent;
+		const bool try_three = transparent || (quality == CompressionQuality::BEST && !always_four);
+		const unsigned refinements = c_Refinements[static_cast<unsigned>(quality)];
+
+		float best_error = std::numeric_limits<float>::max();
+		uint16_t best_first = 0, best_second = 0;
+		uint8_t best_indices[c_BlockPixels] = {};
+
+		for(const bool four : {true, false})
+		{
+			if((four && !try_four) || (!four && !try_three))
+				continue;
+
+			float a[4] = {end[0], end[1], end[2]}, b[4] = {start[0], start[1], start[2]};
+			for(unsigned iteration = 0; iteration < refinements; iteration++)
+			{
+				uint16_t first = pack_565(a), second = pack_565(b);
+
+				// Four colour blocks need the first endpoint to be the greater, three colour
+				// blocks need it to be the lesser. Equal endpoints are decoded as three colours.
+				if(four != (first > second))
+					std::swap(first, second);
+
+				float palette[4][3];
+				const bool four_colours = always_four || first > second;
+				bc1_palette(first, second, four_colours, palette);
+
+				uint8_t indices[c_BlockPixels];
+				const float error = bc1_indices(colours, palette, four_colours ? 4 : 3, indices);
+				if(error < best_error)
+				{
+					best_error = error;
+					best_first = first;
+					best_second = second;
+					std::copy_n(indices, colours.count, best_indices);
+				}
+
+				if(iteration + 1 == refinements || error == 0.0f)
+					break;
+
+				// The endpoints are refit to the colours using the indices they were given
+				const float four_weights[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+				const float three_weights[4] = {0.0f, 1.0f, 0.5f, 0.0f};
+				float weights[c_BlockPixels];
+				for(unsigned i = 0; i < colours.count; i++)
+					weights[i] = four_colours ? four_weights[indices[i]] : three_weights[indices[i]];
+
+				if(!fit_endpoints(colours, weights, 3, a, b))
+					break;
+
+				// The refit is made against the ordered endpoints, and stops once they settle
+				if(pack_565(a) == first && pack_565(b) == second)
+					break;
+			}
+		}
+
+		uint32_t indices = 0;
+		for(unsigned i = 0; i < c_BlockPixels; i++)
+		{
+			const uint32_t index = slots[i] == c_BlockPixels ? 3 : best_indices[slots[i]];
+			indices |= index << (i * 2);
+		}
+		write_bc1_block(best_first, best_second, indices, output);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Builds the palette of a BC3 alpha block. Blocks with the first endpoint greater than the
+	// second interpolate eight values, otherwise they interpolate six along with 0 and 255.
+	void alpha_palette(const int first, const int second, int palette[8])
+	{
+		palette[0] = first;
+		palette[1] = second;
+		if(first > second)
+		{
+			for(int k = 1; k < 7; k++)
+				palette[k + 1] = ((7 - k) * first + k * second) / 7;
+		}
+		else
+		{
+			for(int k = 1; k < 5; k++)
+				palette[k + 1] = ((5 - k) * first + k * second) / 5;
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	int alpha_indices(const Colour* pixels, const int palette[8], uint64_t& indices)
+	{
+		int total = 0;
+		indices = 0;
+		for(unsigned i = 0; i < c_BlockPixels; i++)
+		{
+			int best = std::numeric_limits<int>::max();
+			uint64_t best_index = 0;
+			for(unsigned e = 0; e < 8; e++)
+			{
+				const int error = std::abs(pixels[i].alpha - palette[e]);
+				if(error < best)
+				{
+					best = error;
+					best_index = e;
+				}
+			}
+			indices |= best_index << (i * 3);
+			total += best * best;
+		}
+		return total;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void encode_alpha_block(const Colour* pixels, const CompressionQuality quality, uint8_t* output)
+	{
+		int low = 255, high = 0, inner_low = 255, inner_high = 0;
+		for(unsigned i = 0; i < c_BlockPixels; i++)
+		{
+			const int alpha = pixels[i].alpha;
+			low = std::min(low, alpha);
+			high = std::max(high, alpha);
+			if(alpha != 0 && alpha != 255)
+			{
+				inner_low = std::min(inner_low, alpha);
+				inner_high = std::max(inner_high, alpha);
+			}
+		}
+
+		// Blocks of a single alpha use equal endpoints, which every index can point to
+		if(low == high)
+		{
+			std::fill_n(output, 8, 0);
+			output[0] = output[1] = static_cast<uint8_t>(low);
+			return;
+		}
+
+		// Eight values spread over the whole range suit most blocks. Blocks which mix fully
+		// transparent or opaque pixels with a narrow range of others can do better with six
+		// values, as 0 and 255 are always available.
+		int first = high, second = low, palette[8];
+		uint64_t indices;
+		alpha_palette(first, second, palette);
+		const int error = alpha_indices(pixels, palette, indices);
+
+		if(quality != CompressionQuality::FAST && error > 0 && inner_low <= inner_high)
+		{
+			int six_palette[8];
+			uint64_t six_indices;
+			alpha_palette(inner_low, inner_high, six_palette);
+			if(alpha_indices(pixels, six_palette, six_indices) < error)
+			{
+				first = inner_low;
+				second = inner_high;
+				indices = six_indices;
+			}
+		}
+
+		output[0] = static_cast<uint8_t>(first);
+		output[1] = static_cast<uint8_t>(second);
+		for(unsigned b = 0; b < 6; b++)
+			output[2 + b] = static_cast<uint8_t>(indices >> (b * 8));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Writes the fields of a BC7 block from its least significant bit upwards
+	class BlockWriter
+	{
+	private:
+
+		uint64_t m_Bits[2] = {0, 0};
+		unsigned m_Position = 0;
+
+	public:
+
+		void write(const uint64_t value, const unsigned count)
+		{
+			const unsigned word = m_Position / 64, offset = m_Position % 64;
+			m_Bits[word] |= value << offset;
+			if(offset + count > 64)
+				m_Bits[word + 1] |= value >> (64 - offset);
+			m_Position += count;
+		}
+
+		void store(uint8_t* output) const
+		{
+			for(unsigned b = 0; b < 16; b++)
+				output[b] = static_cast<uint8_t>(m_Bits[b / 8] >> ((b % 8) * 8));
+		}
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	// The endpoints and indices of one half of a mode 4 or 5 block, which holds either the
+	// three colour channels or the single channel which is rotated into alpha.
+	struct BC7Half
+	{
+		unsigned endpoints[2][3];
+		uint8_t indices[c_BlockPixels];
+		float error;
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	int expand_bc7(const unsigned code, const unsigned bits)
+	{
+		return static_cast<int>((code << (8 - bits)) | (code >> (2 * bits - 8)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Quantizes a channel to an endpoint with the given number of bits, picking the code
+	// which expands back to the nearest value since rounding alone can land one step off.
+	unsigned quantize_bc7_channel(const float value, const unsigned bits)
+	{
+		const unsigned max = (1u << bits) - 1;
+		const unsigned code = std::min(static_cast<unsigned>(value * max / 255.0f + 0.5f), max);
+
+		unsigned best = code;
+		for(const unsigned candidate : {code - 1, code + 1})
+			if(candidate <= max && std::abs(expand_bc7(candidate, bits) - value) < std::abs(expand_bc7(best, bits) - value))
+				best = candidate;
+		return best;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Quantizes an endpoint to the seven bits per channel of mode 6, along with its shared
+	// p-bit which is the lowest bit of every channel. Returns the squared error of the result.
+	float quantize_bc7_endpoint(const float* endpoint, const unsigned pbit, unsigned* quantized)
+	{
+		float error = 0.0f;
+		for(unsigned c = 0; c < 4; c++)
+		{
+			const int value = std::clamp(static_cast<int>((endpoint[c] - pbit) * 0.5f + 0.5f), 0, 127);
+			quantized[c] = static_cast<unsigned>(value);
+
+			const float difference = endpoint[c] - static_cast<float>(value * 2 + pbit);
+			error += difference * difference;
+		}
+		return error;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Gives each colour the index of its nearest interpolated colour, returning the total error.
+	// The fast path projects each colour onto the line between the endpoints, which only gets
+	// the index wrong for colours which lie far off the line.
+	float bc7_indices(const BlockColours& colours, const unsigned channels, const int* first, const int* second, const std::span<const int> weights, const bool exhaustive, uint8_t* indices)
+	{
+		const unsigned count = static_cast<unsigned>(weights.size());
+
+		int palette[16][4];
+		for(unsigned k = 0; k < count; k++)
+			for(unsigned c = 0; c < channels; c++)
+				palette[k][c] = ((64 - weights[k]) * first[c] + weights[k] * second[c] + 32) >> 6;
+
+		float direction[4], length = 0.0f;
+		for(unsigned c = 0; c < channels; c++)
+		{
+			direction[c] = static_cast<float>(second[c] - first[c]);
+			length += direction[c] * direction[c];
+		}
+
+		float total = 0.0f;
+		for(unsigned i = 0; i < colours.count; i++)
+		{
+			const float* colour = colours.values[i];
+			const auto error_of = [&](const unsigned k)
+			{
+				float error = 0.0f;
+				for(unsigned c = 0; c < channels; c++)
+				{
+					const float difference = colour[c] - static_cast<float>(palette[k][c]);
+					error += difference * difference;
+				}
+				return error;
+			};
+
+			if(exhaustive || length == 0.0f)
+			{
+				float best = std::numeric_limits<float>::max();
+				for(unsigned k = 0; k < count; k++)
+				{
+					const float error = error_of(k);
+					if(error < best)
+					{
+						best = error;
+						indices[i] = static_cast<uint8_t>(k);
+					}
+				}
+				total += best;
+				continue;
+			}
+
+			float t = 0.0f;
+			for(unsigned c = 0; c < channels; c++)
+				t += (colour[c] - static_cast<float>(first[c])) * direction[c];
+			t = std::clamp(t / length * 64.0f, 0.0f, 64.0f);
+
+			// The weights are close to evenly spaced, so the nearest is one of two candidates
+			unsigned k = std::min(static_cast<unsigned>(t * (count - 1) / 64.0f), count - 2);
+			if(std::abs(t - weights[k + 1]) < std::abs(t - weights[k]))
+				k++;
+			else if(k > 0 && std::abs(t - weights[k - 1]) < std::abs(t - weights[k]))
+				k--;
+
+			indices[i] = static_cast<uint8_t>(k);
+			total += error_of(k);
+		}
+		return total;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Encodes a block in mode 6, a single RGBA subset with 16 interpolated colours, returning
+	// the squared error of the block.
+	float encode_bc7_mode_6(const BlockColours& colours, const CompressionQuality quality, BlockWriter& writer)
+	{
+		float start[4], end[4];
+		fit_line(colours, 4, start, end);
+
+		const bool exhaustive = quality == CompressionQuality::BEST;
+		const unsigned refinements = c_Refinements[static_cast<unsigned>(quality)];
+
+		float best_error = std::numeric_limits<float>::max();
+		unsigned best_endpoints[2][4] = {}, best_pbits[2] = {};
+		uint8_t best_indices[c_BlockPixels] = {};
+
+		for(unsigned iteration = 0; iteration < refinements; iteration++)
+		{
+			// Each endpoint takes the p-bit which quantizes it best, while the best quality
+			// tries every combination since the best endpoints alone may not give the best block
+			unsigned pbit_options[4][2];
+			unsigned option_count = 0;
+			if(exhaustive)
+			{
+				for(; option_count < 4; option_count++)
+				{
+					pbit_options[option_count][0] = option_count & 1;
+					pbit_options[option_count][1] = option_count >> 1;
+				}
+			}
+			else
+			{
+				unsigned scratch[4];
+				pbit_options[0][0] = quantize_bc7_endpoint(start, 1, scratch) < quantize_bc7_endpoint(start, 0, scratch) ? 1 : 0;
+				pbit_options[0][1] = quantize_bc7_endpoint(end, 1, scratch) < quantize_bc7_endpoint(end, 0, scratch) ? 1 : 0;
+				option_count = 1;
+			}
+
+			uint8_t indices[c_BlockPixels];
+			for(unsigned option = 0; option < option_count; option++)
+			{
+				unsigned endpoints[2][4];
+				const unsigned pbits[2] = {pbit_options[option][0], pbit_options[option][1]};
+				quantize_bc7_endpoint(start, pbits[0], endpoints[0]);
+				quantize_bc7_endpoint(end, pbits[1], endpoints[1]);
+
+				int first[4], second[4];
+				for(unsigned c = 0; c < 4; c++)
+				{
+					first[c] = static_cast<int>(endpoints[0][c] * 2 + pbits[0]);
+					second[c] = static_cast<int>(endpoints[1][c] * 2 + pbits[1]);
+				}
+
+				uint8_t option_indices[c_BlockPixels];
+				const float error = bc7_indices(colours, 4, first, second, c_BC7Weights4, exhaustive, option_indices);
+				if(error < best_error)
+				{
+					best_error = error;
+					std::memcpy(best_endpoints, endpoints, sizeof(endpoints));
+					best_pbits[0] = pbits[0];
+					best_pbits[1] = pbits[1];
+					std::copy_n(option_indices, c_BlockPixels, best_indices);
+				}
+
+				if(option == 0)
+					std::copy_n(option_indices, c_BlockPixels, indices);
+			}
+
+			if(iteration + 1 == refinements || best_error == 0.0f)
+				break;
+
+			float weights[c_BlockPixels];
+			for(unsigned i = 0; i < c_BlockPixels; i++)
+				weights[i] = c_BC7Weights4[indices[i]] / 64.0f;
+
+			if(!fit_endpoints(colours, weights, 4, start, end))
+				break;
+		}
+
+		// The first index is stored with its top bit implied to be zero, so if it is set
+		// then the endpoints are swapped, which mirrors every index.
+		if(best_indices[0] >= 8)
+		{
+			std::swap(best_endpoints[0], best_endpoints[1]);
+			std::swap(best_pbits[0], best_pbits[1]);
+			for(unsigned i = 0; i < c_BlockPixels; i++)
+				best_indices[i] = static_cast<uint8_t>(15 - best_indices[i]);
+		}
+
+		writer.write(1 << 6, 7);
+		for(unsigned c = 0; c < 4; c++)
+		{
+			writer.write(best_endpoints[0][c], 7);
+			writer.write(best_endpoints[1][c], 7);
+		}
+		writer.write(best_pbits[0], 1);
+		writer.write(best_pbits[1], 1);
+
+		writer.write(best_indices[0], 3);
+		for(unsigned i = 1; i < c_BlockPixels; i++)
+			writer.write(best_indices[i], 4);
+
+		return best_error;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Fits one half of a mode 4 or 5 block with endpoints of the given precision, refining
+	// them against the indices they are given, the same way as the endpoints of mode 6.
+	void encode_bc7_half(const BlockColours& colours, const unsigned channels, const unsigned bits, const std::span<const int> weights, const CompressionQuality quality, BC7Half& half)
+	{
+		float start[4], end[4];
+		fit_line(colours, channels, start, end);
+
+		const bool exhaustive = quality == CompressionQuality::BEST;
+		const unsigned refinements = c_Refinements[static_cast<unsigned>(quality)];
+
+		half.error = std::numeric_limits<float>::max();
+		for(unsigned iteration = 0; iteration < refinements; iteration++)
+		{
+			unsigned endpoints[2][3];
+			int first[4], second[4];
+			for(unsigned c = 0; c < channels; c++)
+			{
+				endpoints[0][c] = quantize_bc7_channel(start[c], bits);
+				endpoints[1][c] = quantize_bc7_channel(end[c], bits);
+				first[c] = expand_bc7(endpoints[0][c], bits);
+				second[c] = expand_bc7(endpoints[1][c], bits);
+			}
+
+			uint8_t indices[c_BlockPixels];
+			const float error = bc7_indices(colours, channels, first, second, weights, exhaustive, indices);
+			if(error < half.error)
+			{
+				half.error = error;
+				std::memcpy(half.endpoints, endpoints, sizeof(endpoints));
+				std::copy_n(indices, c_BlockPixels, half.indices);
+			}
+
+			if(iteration + 1 == refinements || error == 0.0f)
+				break;
+
+			float fit_weights[c_BlockPixels];
+			for(unsigned i = 0; i < c_BlockPixels; i++)
+				fit_weights[i] = weights[indices[i]] / 64.0f;
+
+			if(!fit_endpoints(colours, fit_weights, channels, start, end))
+				break;
+		}
+
+		// Each half stores its first index with the top bit implied to be zero, like mode 6
+		const unsigned count = static_cast<unsigned>(weights.size());
+		if(half.indices[0] >= count / 2)
+		{
+			std::swap(half.endpoints[0], half.endpoints[1]);
+			for(unsigned i = 0; i < c_BlockPixels; i++)
+				half.indices[i] = static_cast<uint8_t>(count - 1 - half.indices[i]);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Encodes a block in mode 4 or 5, which store alpha apart from the colour so that it
+	// can vary independently, as it does along the soft edges of sprites. The rotation first
+	// swaps alpha with one of the colour channels, letting that channel take the separate
+	// endpoints instead. Mode 4 has 5-bit colour and 6-bit alpha endpoints, with 2-bit indices
+	// for one half and 3-bit indices for the other, while mode 5 has 7-bit colour and 8-bit
+	// alpha endpoints with 2-bit indices for both. Returns the squared error of the block.
+	float encode_bc7_separate_alpha(const BlockColours& colours, const unsigned mode, const unsigned rotation, const bool index_selection, const CompressionQuality quality, BlockWriter& writer)
+	{
+		BlockColours colour, alpha;
+		colour.count = alpha.count = colours.count;
+		for(unsigned i = 0; i < colours.count; i++)
+		{
+			float values[4];
+			std::copy_n(colours.values[i], 4, values);
+			if(rotation != 0)
+				std::swap(values[rotation - 1], values[3]);
+
+			std::copy_n(values, 3, colour.values[i]);
+			alpha.values[i][0] = values[3];
+		}
+
+		// The index selection bit of mode 4 gives the 3-bit indices to the colour
+		const bool mode_4 = mode == 4;
+		const bool colour_three = mode_4 && index_selection;
+		const bool alpha_three = mode_4 && !index_selection;
+		const unsigned colour_bits = mode_4 ? 5 : 7, alpha_bits = mode_4 ? 6 : 8;
+
+		BC7Half colour_half, alpha_half;
+		encode_bc7_half(colour, 3, colour_bits, colour_three ? std::span<const int>(c_BC7Weights3) : c_BC7Weights2, quality, colour_half);
+		encode_bc7_half(alpha, 1, alpha_bits, alpha_three ? std::span<const int>(c_BC7Weights3) : c_BC7Weights2, quality, alpha_half);
+
+		writer.write(1 << mode, mode + 1);
+		writer.write(rotation, 2);
+		if(mode_4)
+			writer.write(index_selection ? 1 : 0, 1);
+
+		for(unsigned c = 0; c < 3; c++)
+		{
+			writer.write(colour_half.endpoints[0][c], colour_bits);
+			writer.write(colour_half.endpoints[1][c], colour_bits);
+		}
+		writer.write(alpha_half.endpoints[0][0], alpha_bits);
+		writer.write(alpha_half.endpoints[1][0], alpha_bits);
+
+		// The 2-bit indices always come first, whichever half they belong to
+		const auto write_indices = [&](const BC7Half& half, const unsigned bits)
+		{
+			writer.write(half.indices[0], bits - 1);
+			for(unsigned i = 1; i < c_BlockPixels; i++)
+				writer.write(half.indices[i], bits);
+		};
+		write_indices(colour_three ? alpha_half : colour_half, 2);
+		write_indices(colour_three ? colour_half : alpha_half, mode_4 ? 3 : 2);
+
+		return colour_half.error + alpha_half.error;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Encodes a block with whichever of modes 4, 5 and 6 gives the least error. The fast
+	// quality only tries modes 4 and 5 without rotation, and only on blocks where alpha varies
+	// since mode 6 is nearly as good elsewhere. The balanced quality tries them on every block,
+	// along with both index selections of mode 4, and the best quality tries every rotation.
+	void encode_bc7_block(const Colour* pixels, const CompressionQuality quality, uint8_t* output)
+	{
+		BlockColours colours;
+		colours.count = c_BlockPixels;
+		for(unsigned i = 0; i < c_BlockPixels; i++)
+		{
+			colours.values[i][0] = pixels[i].red;
+			colours.values[i][1] = pixels[i].green;
+			colours.values[i][2] = pixels[i].blue;
+			colours.values[i][3] = pixels[i].alpha;
+		}
+
+		BlockWriter best_writer;
+		float best_error = encode_bc7_mode_6(colours, quality, best_writer);
+
+		bool uniform_alpha = true;
+		for(unsigned i = 1; i < c_BlockPixels && uniform_alpha; i++)
+			uniform_alpha = pixels[i].alpha == pixels[0].alpha;
+
+		if(quality == CompressionQuality::FAST && uniform_alpha)
+		{
+			best_writer.store(output);
+			return;
+		}
+
+		const unsigned rotations = quality == CompressionQuality::BEST ? 4 : 1;
+		const unsigned selections = quality == CompressionQuality::FAST ? 1 : 2;
+		for(unsigned rotation = 0; rotation < rotations && best_error > 0.0f; rotation++)
+		{
+			for(unsigned selection = 0; selection <= selections && best_error > 0.0f; selection++)
+			{
+				// The last option is mode 5, which has no index selection
+				const unsigned mode = selection < selections ? 4 : 5;
+
+				BlockWriter writer;
+				const float error = encode_bc7_separate_alpha(colours, mode, rotation, mode == 4 && selection == 1, quality, writer);
+				if(error < best_error)
+				{
+					best_error = error;
+					best_writer = writer;
+				}
+			}
+		}
+
+		best_writer.store(output);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool can_compress(const CompressedFormat format)
+	{
+		switch(format)
+		{
+			case CompressedFormat::BC1_RGB:
+			case CompressedFormat::BC1_RGBA:
+			case CompressedFormat::BC1_SRGB:
+			case CompressedFormat::BC1_SRGB_ALPHA:
+			case CompressedFormat::BC3:
+			case CompressedFormat::BC3_SRGB:
+			case CompressedFormat::BC7:
+			case CompressedFormat::BC7_SRGB:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t compressed_size(const CompressedFormat format, const unsigned width, const unsigned height)
+	{
+		return static_cast<uint64_t>((width + 3) / 4) * ((height + 3) / 4) * CompressedImage::BlockSize(format);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void compress_pixels(uint8_t* dst, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height, const CompressedFormat format, const CompressionQuality quality, const unsigned thread_count)
+	{
+		CBN_Assert(can_compress(format), "Format cannot be encoded");
+
+		if(width == 0 || height == 0)
+			return;
+
+		const unsigned blocks_x = (width + 3) / 4, blocks_y = (height + 3) / 4;
+		const uint64_t block_size = CompressedImage::BlockSize(format);
+		const uint64_t row_size = blocks_x * block_size;
+
+		const bool bc1 = block_size == 8;
+		const bool punchthrough = format == CompressedFormat::BC1_RGBA || format == CompressedFormat::BC1_SRGB_ALPHA;
+		const bool bc3 = format == CompressedFormat::BC3 || format == CompressedFormat::BC3_SRGB;
+
+		parallel_rows(blocks_y, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			Colour block[c_BlockPixels];
+			uint8_t previous_block[16];
+			Colour previous_colour(0u);
+			bool has_previous = false;
+
+			for(unsigned by = begin; by < end; by++)
+			{
+				uint8_t* output = dst + by * row_size;
+				for(unsigned bx = 0; bx < blocks_x; bx++, output += block_size)
+				{
+					load_block(src, src_stride, width, height, bx * 4, by * 4, block);
+
+					// Atlas pages are mostly empty space and flat colour, so runs of identical
+					// uniform blocks are copied from the last one rather than encoded again
+					const bool uniform = is_uniform(block);
+					if(uniform && has_previous && block[0].hex == previous_colour.hex)
+					{
+						std::memcpy(output, previous_block, block_size);
+						continue;
+					}
+
+					if(bc1)
+					{
+						encode_bc1_block(block, punchthrough, false, quality, output);
+					}
+					else if(bc3)
+					{
+						encode_alpha_block(block, quality, output);
+						encode_bc1_block(block, false, true, quality, output + 8);
+					}
+					else encode_bc7_block(block, quality, output);
+
+					has_previous = uniform;
+					if(uniform)
+					{
+						previous_colour = block[0];
+						std::memcpy(previous_block, output, block_size);
+					}
+				}
+			}
+		});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
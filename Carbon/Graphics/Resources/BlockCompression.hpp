@@ -0,0 +1,28 @@
+#pragma once
+
+#include <stdint.h>
+
+#include "../../Utility/Colour.hpp"
+#include "CompressedImage.hpp"
+
+namespace cbn
+{
+
+	// Encodes RGBA pixels into block compressed formats, so that textures can be baked to be
+	// stored compressed on the GPU. Pixels are encoded in 4x4 blocks, where partial blocks at
+	// the edges of the image repeat its last row and column. BC1, BC3 and BC7, along with
+	// their sRGB variants, can be encoded. BC1 with alpha keeps pixels with an alpha of at
+	// least 128 and makes the rest transparent black. BC7 blocks use mode 6, a single RGBA
+	// subset with 16 interpolated colours, or modes 4 and 5, which store alpha separately
+	// and suit sprites whose soft edges fade out without the colour changing.
+
+	bool can_compress(const CompressedFormat format);
+
+	uint64_t compressed_size(const CompressedFormat format, const unsigned width, const unsigned height);
+
+	// Compresses the width x height source block into the destination, which must hold
+	// compressed_size bytes. Rows of blocks are split across the given number of threads,
+	// or one per hardware thread if it is zero.
+	void compress_pixels(uint8_t* dst, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height, const CompressedFormat format, const CompressionQuality quality = CompressionQuality::FAST, const unsigned thread_count = 0);
+
+}
\ No newline at end of file
@@ -1,15 +1,12 @@
 #include "BufferTexture.hpp"
 
+#include "../../Diagnostics/Assert.hpp"
+#include "../OpenGL/StateCache.hpp"
+
 namespace cbn
 {
 	//-------------------------------------------------------------------------------------
 
-    // Initialize bound buffer texture states with all units unbound. We do this via
-	// a zero-initialization of a raw array which is then converted to an std array.
-	std::array<GLuint, 32> BufferTexture::s_BoundBufferTextures = std::to_array<GLuint, 32>({0});
-
-	//-------------------------------------------------------------------------------------
-
 	SRes<BufferTexture> BufferTexture::Allocate(const std::vector<uint8_t>& data, const BufferTextureDataFormat data_format, const Version& opengl_version)
 	{
 		return Allocate(data.data(), data.size(), data_format, opengl_version);
@@ -20,49 +17,92 @@ namespace cbn
 	SRes<BufferTexture> BufferTexture::Allocate(const uint8_t* data, const uint64_t length, const BufferTextureDataFormat data_format, const Version& opengl_version)
 	{
 		// Create the texture buffer first to generate the OpenGL buffer object, then simply attach the required memory to it
-		auto texture_buffer = SRes<BufferTexture>(new BufferTexture(length, data_format));
+		auto texture_buffer = SRes<BufferTexture>(new BufferTexture(length, data_format, false, opengl_version));
+		texture_buffer->create_storage(data, opengl_version);
+
+		return texture_buffer;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<BufferTexture> BufferTexture::Reserve(const uint64_t byte_size, const BufferTextureDataFormat data_format, const Version& opengl_version)
+	{
+		// Reserved buffer textures start off uninitialized, and are filled
+		// in afterwards by uploading or copying data into sub-ranges of it.
+		auto texture_buffer = SRes<BufferTexture>(new BufferTexture(byte_size, data_format, true, opengl_version));
+		texture_buffer->create_storage(nullptr, opengl_version);
+
+		if(glGetError() == GL_OUT_OF_MEMORY)
+			return nullptr;
+
+		return texture_buffer;
+	}
 
-		glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer->m_BufferID);
+	//-------------------------------------------------------------------------------------
+
+	void BufferTexture::create_storage(const uint8_t* data, const Version& opengl_version)
+	{
+		// Immutable storage can only be written to after creation if it is dynamic
+		const GLbitfield storage_flags = m_Writable ? GL_DYNAMIC_STORAGE_BIT : 0;
 
-		// If OpenGL 4.4 is supported, create immutable storage otherwise use the normal buffer data.
-		if(opengl_version >= Version{4,4})
+		// If OpenGL 4.5 is supported, we can create immutable storage without binding the buffer.
+		// Otherwise the buffer must be bound, and immutable storage is only available on OpenGL 4.4.
+		if(m_DirectStateAccess)
 		{
-			glBufferStorage(GL_TEXTURE_BUFFER, length, data, NULL);
+			glNamedBufferStorage(m_BufferID, m_ByteSize, data, storage_flags);
 		}
 		else
 		{
-			glBufferData(GL_TEXTURE_BUFFER, length, data, GL_STATIC_DRAW);
+			StateCache::BindBuffer(GL_TEXTURE_BUFFER, m_BufferID);
+
+			if(opengl_version >= Version{4,4})
+			{
+				glBufferStorage(GL_TEXTURE_BUFFER, m_ByteSize, data, storage_flags);
+			}
+			else
+			{
+				glBufferData(GL_TEXTURE_BUFFER, m_ByteSize, data, m_Writable ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+			}
 		}
-
-		glBindBuffer(GL_TEXTURE_BUFFER, texture_buffer->m_BufferID);
-
-		return texture_buffer;
 	}
 
 	//-------------------------------------------------------------------------------------
 
-	BufferTexture::BufferTexture(const uint64_t byte_size, const BufferTextureDataFormat data_format)
-		: m_ByteSize(byte_size),
-		m_Format(data_format)
+	BufferTexture::BufferTexture(const uint64_t byte_size, const BufferTextureDataFormat data_format, const bool writable, const Version& opengl_version)
+		: m_TextureUnit(TextureUnit::UNIT_0),
+		m_Format(data_format),
+		m_DirectStateAccess(opengl_version >= Version{4,5}),
+		m_ByteSize(byte_size),
+		m_Writable(writable)
 	{
-		// Create the buffer and texture, then bind them together
-		glGenBuffers(1, &m_BufferID);
-		glGenTextures(1, &m_TextureID);
-		
-		// Bind the texture and buffer
-		force_bind();
-		glBindBuffer(GL_TEXTURE_BUFFER, m_BufferID);
-		glTexBuffer(GL_TEXTURE_BUFFER, value(data_format), m_BufferID);
+		// Create the buffer and texture, then attach them together. With direct
+		// state access this can be done without disturbing any of the bindings.
+		if(m_DirectStateAccess)
+		{
+			glCreateBuffers(1, &m_BufferID);
+			glCreateTextures(GL_TEXTURE_BUFFER, 1, &m_TextureID);
+			glTextureBuffer(m_TextureID, value(data_format), m_BufferID);
+		}
+		else
+		{
+			glGenBuffers(1, &m_BufferID);
+			glGenTextures(1, &m_TextureID);
+
+			// Bind the texture and buffer
+			bind();
+			StateCache::BindBuffer(GL_TEXTURE_BUFFER, m_BufferID);
+			glTexBuffer(GL_TEXTURE_BUFFER, value(data_format), m_BufferID);
+		}
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	BufferTexture::~BufferTexture()
 	{
-		// Before we destroy the object, we need to ensure the static bounded object tracker
-		// doesnt consider it as being bound. Otherwise issues will arise when a new object
-		// takes its ID.
-		unbind();
+		// Before we destroy the object, we need to ensure the state cache doesnt consider 
+		// it as being bound. Otherwise issues will arise when a new object takes its ID.
+		StateCache::ForgetBuffer(m_BufferID);
+		StateCache::ForgetTexture(m_TextureID);
 		glDeleteBuffers(1, &m_BufferID);
 		glDeleteTextures(1, &m_TextureID);
 	}
@@ -75,11 +115,7 @@ namespace cbn
 		if(is_bound())
 		{
 			// Unbind from the texture unit the texture is bound to
-			glActiveTexture(GL_TEXTURE0 + value(m_TextureUnit));
-			glBindTexture(GL_TEXTURE_BUFFER, 0);
-
-			// Reset state information
-			s_BoundBufferTextures[value(m_TextureUnit)] = 0;
+			StateCache::BindTexture(value(m_TextureUnit), GL_TEXTURE_BUFFER, 0);
 		}
 	}
 	
@@ -87,38 +123,70 @@ namespace cbn
 
 	void BufferTexture::bind(const TextureUnit texture_unit) const
 	{
-		// Only bind if it is not already bound to the given texture unit
-		if(!is_bound(texture_unit))
-		{
-			force_bind(texture_unit);
-		}
+		// The state cache will only bind if it is not already bound to the given texture unit
+		StateCache::BindTexture(value(texture_unit), GL_TEXTURE_BUFFER, m_TextureID);
+		m_TextureUnit = texture_unit;
 	}
 	
 	//-------------------------------------------------------------------------------------
 
 	void BufferTexture::force_bind(const TextureUnit texture_unit) const
 	{
-		// Update the buffer texture binding states
-		s_BoundBufferTextures[value(texture_unit)] = m_TextureID;
+		// Re-issue the binding even if the state cache believes it is already bound
+		StateCache::BindTexture(value(texture_unit), GL_TEXTURE_BUFFER, m_TextureID, true);
 		m_TextureUnit = texture_unit;
-
-		// Bind the buffer texture to the correct unit
-		glActiveTexture(GL_TEXTURE0 + value(texture_unit));
-		glBindTexture(GL_TEXTURE_BUFFER, m_TextureID);
 	}
 	
 	//-------------------------------------------------------------------------------------
 
 	bool BufferTexture::is_bound(const TextureUnit texture_unit) const
 	{
-		return m_TextureUnit == texture_unit && s_BoundBufferTextures[value(texture_unit)] == m_TextureID;
+		return m_TextureUnit == texture_unit && StateCache::IsTextureBound(value(texture_unit), GL_TEXTURE_BUFFER, m_TextureID);
 	}
 	
 	//-------------------------------------------------------------------------------------
 
 	bool BufferTexture::is_bound() const
 	{
-		return s_BoundBufferTextures[value(m_TextureUnit)] == m_TextureID;
+		return StateCache::IsTextureBound(value(m_TextureUnit), GL_TEXTURE_BUFFER, m_TextureID);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void BufferTexture::upload(const uint8_t* data, const uint64_t length, const uint64_t offset)
+	{
+		CBN_Assert(is_writable(), "Cannot upload to a buffer texture which was not reserved");
+		CBN_Assert(offset + length <= m_ByteSize, "Upload exceeds the size of the buffer texture");
+
+		if(m_DirectStateAccess)
+		{
+			glNamedBufferSubData(m_BufferID, offset, length, data);
+		}
+		else
+		{
+			StateCache::BindBuffer(GL_TEXTURE_BUFFER, m_BufferID);
+			glBufferSubData(GL_TEXTURE_BUFFER, offset, length, data);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void BufferTexture::copy(const BufferTexture& source, const uint64_t source_offset, const uint64_t offset, const uint64_t length)
+	{
+		CBN_Assert(is_writable(), "Cannot copy to a buffer texture which was not reserved");
+		CBN_Assert(source_offset + length <= source.m_ByteSize, "Copy exceeds the size of the source buffer texture");
+		CBN_Assert(offset + length <= m_ByteSize, "Copy exceeds the size of the buffer texture");
+
+		if(m_DirectStateAccess)
+		{
+			glCopyNamedBufferSubData(source.m_BufferID, m_BufferID, source_offset, offset, length);
+		}
+		else
+		{
+			StateCache::BindBuffer(GL_COPY_READ_BUFFER, source.m_BufferID);
+			StateCache::BindBuffer(GL_COPY_WRITE_BUFFER, m_BufferID);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source_offset, offset, length);
+		}
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -136,4 +204,11 @@ namespace cbn
 	}
 
 	//-------------------------------------------------------------------------------------
+
+	bool BufferTexture::is_writable() const
+	{
+		return m_Writable;
+	}
+
+	//-------------------------------------------------------------------------------------
 }
\ No newline at end of file
@@ -50,16 +50,20 @@ namespace cbn
 		
 		static SRes<BufferTexture> Allocate(const uint8_t* data, const uint64_t length, const BufferTextureDataFormat data_format, const Version& opengl_version);
 
+		static SRes<BufferTexture> Reserve(const uint64_t byte_size, const BufferTextureDataFormat data_format, const Version& opengl_version);
+
 	private:
 
-		static std::array<GLuint, 32> s_BoundBufferTextures;
-		
 		mutable TextureUnit m_TextureUnit;
 		const BufferTextureDataFormat m_Format;
 		GLuint m_BufferID, m_TextureID;
+		const bool m_DirectStateAccess;
 		const uint64_t m_ByteSize;
+		const bool m_Writable;
+
+		void create_storage(const uint8_t* data, const Version& opengl_version);
 
-		BufferTexture(const uint64_t byte_size, const BufferTextureDataFormat data_format);
+		BufferTexture(const uint64_t byte_size, const BufferTextureDataFormat data_format, const bool writable, const Version& opengl_version);
 
 	public:
 
@@ -74,9 +78,15 @@ namespace cbn
 		bool is_bound(const TextureUnit texture_unit) const;
 		
 		bool is_bound() const;
+
+		void upload(const uint8_t* data, const uint64_t length, const uint64_t offset = 0);
+
+		void copy(const BufferTexture& source, const uint64_t source_offset, const uint64_t offset, const uint64_t length);
 		
 		uint64_t size() const;
 
+		bool is_writable() const;
+
 		BufferTextureDataFormat format() const;
 	};
 
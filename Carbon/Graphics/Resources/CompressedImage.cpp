@@ -0,0 +1,332 @@
+#include "CompressedImage.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <cstring>
+#include <bit>
+
+#include "../../Diagnostics/Assert.hpp"
+#include "BlockCompression.hpp"
+#include "ImageKernels.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	constexpr uint8_t c_KTX2Identifier[12] = {0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+#pragma pack(push, 1)
+
+	struct KTX2Header
+	{
+		uint8_t identifier[12];
+		uint32_t vk_format;
+		uint32_t type_size;
+		uint32_t pixel_width;
+		uint32_t pixel_height;
+		uint32_t pixel_depth;
+		uint32_t layer_count;
+		uint32_t face_count;
+		uint32_t level_count;
+		uint32_t supercompression_scheme;
+		uint32_t dfd_byte_offset;
+		uint32_t dfd_byte_length;
+		uint32_t kvd_byte_offset;
+		uint32_t kvd_byte_length;
+		uint64_t sgd_byte_offset;
+		uint64_t sgd_byte_length;
+	};
+
+	struct KTX2Level
+	{
+		uint64_t byte_offset;
+		uint64_t byte_length;
+		uint64_t uncompressed_byte_length;
+	};
+
+#pragma pack(pop)
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<CompressedImage> CompressedImage::Open(const std::filesystem::path& path)
+	{
+		if(!std::filesystem::is_regular_file(path))
+			return nullptr;
+
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if(!file)
+			return nullptr;
+
+		std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		if(!file || data.size() < sizeof(KTX2Header))
+			return nullptr;
+
+		KTX2Header header;
+		std::memcpy(&header, data.data(), sizeof(KTX2Header));
+		if(std::memcmp(header.identifier, c_KTX2Identifier, sizeof(c_KTX2Identifier)) != 0)
+			return nullptr;
+
+		// We only support plain 2D images, without any array layers, cube
+		// faces or supercompression. The payload must also be a format which
+		// can be handed directly to OpenGL without having to transcode it.
+		CompressedFormat format;
+		if(header.pixel_width == 0 || header.pixel_height == 0 || header.pixel_depth > 0
+		|| header.layer_count > 1 || header.face_count != 1 || header.supercompression_scheme != 0
+		|| !to_compressed_format(header.vk_format, format))
+			return nullptr;
+
+		// A level count of zero means that the file only contains the base level. There can be no 
+		// more levels than it takes to reach 1x1, which also keeps the shifts below in range.
+		const uint32_t level_count = std::max(header.level_count, 1u);
+		if(level_count > static_cast<uint32_t>(std::bit_width(std::max(header.pixel_width, header.pixel_height)))
+		|| data.size() < sizeof(KTX2Header) + level_count * sizeof(KTX2Level))
+			return nullptr;
+
+		std::vector<Level> levels(level_count);
+		for(uint32_t l = 0; l < level_count; l++)
+		{
+			KTX2Level level;
+			std::memcpy(&level, data.data() + sizeof(KTX2Header) + l * sizeof(KTX2Level), sizeof(KTX2Level));
+
+			// Every level must contain all of the blocks needed to cover its
+			// resolution, and must lie entirely within the bounds of the file.
+			const uint64_t level_width = std::max(header.pixel_width >> l, 1u);
+			const uint64_t level_height = std::max(header.pixel_height >> l, 1u);
+			const uint64_t level_size = ((level_width + 3) / 4) * ((level_height + 3) / 4) * BlockSize(format);
+
+			if(level.byte_length < level_size || level.byte_offset > data.size() || level.byte_length > data.size() - level.byte_offset)
+				return nullptr;
+
+			levels[l] = {level.byte_offset, level_size};
+		}
+
+		return Resource::WrapShared(new CompressedImage(format, {header.pixel_width, header.pixel_height}, std::move(data), std::move(levels)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<CompressedImage> CompressedImage::Encode(const ImageView& image, const CompressedFormat format, const CompressionQuality quality, const bool mipmaps, const unsigned thread_count)
+	{
+		if(image.width() == 0 || image.height() == 0 || !can_compress(format))
+			return nullptr;
+
+		const unsigned level_count = mipmaps ? std::bit_width(std::max(image.width(), image.height())) : 1;
+
+		std::vector<Level> levels;
+		uint64_t data_size = 0;
+		for(unsigned l = 0; l < level_count; l++)
+		{
+			const uint64_t level_size = compressed_size(format, std::max(image.width() >> l, 1u), std::max(image.height() >> l, 1u));
+			levels.push_back({data_size, level_size});
+			data_size += level_size;
+		}
+
+		// Each level is downsampled from the one before it, so only two levels are held at once
+		std::vector<uint8_t> data(data_size);
+		std::vector<Colour> current, next;
+		ImageView level = image;
+		for(unsigned l = 0; l < level_count; l++)
+		{
+			compress_pixels(data.data() + levels[l].offset, level.data(), level.stride(), level.width(), level.height(), format, quality, thread_count);
+			if(l + 1 == level_count)
+				break;
+
+			const unsigned next_width = std::max(level.width() / 2, 1u);
+			const unsigned next_height = std::max(level.height() / 2, 1u);
+			next.resize(static_cast<size_t>(next_width) * next_height);
+			downsample_pixels(next.data(), next_width, level.data(), level.stride(), level.width(), level.height());
+
+			std::swap(current, next);
+			level = ImageView(current.data(), next_width, next_height, next_width);
+		}
+
+		return Resource::WrapShared(new CompressedImage(format, image.resolution(), std::move(data), std::move(levels)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t CompressedImage::BlockSize(const CompressedFormat format)
+	{
+		// All supported formats use 4x4 blocks of either 8 or 16 bytes
+		switch(format)
+		{
+			case CompressedFormat::BC1_RGB:
+			case CompressedFormat::BC1_RGBA:
+			case CompressedFormat::BC1_SRGB:
+			case CompressedFormat::BC1_SRGB_ALPHA:
+			case CompressedFormat::BC4:
+			case CompressedFormat::BC4_SIGNED:
+			case CompressedFormat::ETC2_RGB:
+			case CompressedFormat::ETC2_SRGB:
+			case CompressedFormat::ETC2_RGB_A1:
+			case CompressedFormat::ETC2_SRGB_A1:
+			case CompressedFormat::EAC_R11:
+			case CompressedFormat::EAC_R11_SIGNED:
+				return 8;
+			default:
+				return 16;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool CompressedImage::IsCompressedFormat(const uint32_t value)
+	{
+		switch(static_cast<CompressedFormat>(value))
+		{
+			case CompressedFormat::BC1_RGB:
+			case CompressedFormat::BC1_RGBA:
+			case CompressedFormat::BC1_SRGB:
+			case CompressedFormat::BC1_SRGB_ALPHA:
+			case CompressedFormat::BC2:
+			case CompressedFormat::BC2_SRGB:
+			case CompressedFormat::BC3:
+			case CompressedFormat::BC3_SRGB:
+			case CompressedFormat::BC4:
+			case CompressedFormat::BC4_SIGNED:
+			case CompressedFormat::BC5:
+			case CompressedFormat::BC5_SIGNED:
+			case CompressedFormat::BC6H_SIGNED:
+			case CompressedFormat::BC6H_UNSIGNED:
+			case CompressedFormat::BC7:
+			case CompressedFormat::BC7_SRGB:
+			case CompressedFormat::ETC2_RGB:
+			case CompressedFormat::ETC2_SRGB:
+			case CompressedFormat::ETC2_RGB_A1:
+			case CompressedFormat::ETC2_SRGB_A1:
+			case CompressedFormat::ETC2_RGBA:
+			case CompressedFormat::ETC2_SRGB_ALPHA:
+			case CompressedFormat::EAC_R11:
+			case CompressedFormat::EAC_R11_SIGNED:
+			case CompressedFormat::EAC_RG11:
+			case CompressedFormat::EAC_RG11_SIGNED:
+				return true;
+			default:
+				return false;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool CompressedImage::to_compressed_format(const uint32_t vk_format, CompressedFormat& format)
+	{
+		// KTX2 identifies formats by their Vulkan VkFormat value
+		switch(vk_format)
+		{
+			case 131: format = CompressedFormat::BC1_RGB; return true;
+			case 132: format = CompressedFormat::BC1_SRGB; return true;
+			case 133: format = CompressedFormat::BC1_RGBA; return true;
+			case 134: format = CompressedFormat::BC1_SRGB_ALPHA; return true;
+			case 135: format = CompressedFormat::BC2; return true;
+			case 136: format = CompressedFormat::BC2_SRGB; return true;
+			case 137: format = CompressedFormat::BC3; return true;
+			case 138: format = CompressedFormat::BC3_SRGB; return true;
+			case 139: format = CompressedFormat::BC4; return true;
+			case 140: format = CompressedFormat::BC4_SIGNED; return true;
+			case 141: format = CompressedFormat::BC5; return true;
+			case 142: format = CompressedFormat::BC5_SIGNED; return true;
+			case 143: format = CompressedFormat::BC6H_UNSIGNED; return true;
+			case 144: format = CompressedFormat::BC6H_SIGNED; return true;
+			case 145: format = CompressedFormat::BC7; return true;
+			case 146: format = CompressedFormat::BC7_SRGB; return true;
+			case 147: format = CompressedFormat::ETC2_RGB; return true;
+			case 148: format = CompressedFormat::ETC2_SRGB; return true;
+			case 149: format = CompressedFormat::ETC2_RGB_A1; return true;
+			case 150: format = CompressedFormat::ETC2_SRGB_A1; return true;
+			case 151: format = CompressedFormat::ETC2_RGBA; return true;
+			case 152: format = CompressedFormat::ETC2_SRGB_ALPHA; return true;
+			case 153: format = CompressedFormat::EAC_R11; return true;
+			case 154: format = CompressedFormat::EAC_R11_SIGNED; return true;
+			case 155: format = CompressedFormat::EAC_RG11; return true;
+			case 156: format = CompressedFormat::EAC_RG11_SIGNED; return true;
+			default: return false;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	CompressedImage::CompressedImage(const CompressedFormat format, const glm::uvec2& resolution, std::vector<uint8_t>&& data, std::vector<Level>&& levels)
+		: m_Format(format),
+		m_Resolution(resolution),
+		m_Data(std::move(data)),
+		m_Levels(std::move(levels))
+	{}
+
+	//-------------------------------------------------------------------------------------
+
+	CompressedFormat CompressedImage::format() const
+	{
+		return m_Format;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const unsigned CompressedImage::width() const
+	{
+		return m_Resolution.x;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const unsigned CompressedImage::height() const
+	{
+		return m_Resolution.y;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	glm::uvec2 CompressedImage::resolution() const
+	{
+		return m_Resolution;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	unsigned CompressedImage::levels() const
+	{
+		return m_Levels.size();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	glm::uvec2 CompressedImage::level_resolution(const unsigned level) const
+	{
+		CBN_Assert(level < levels(), "Level is out of range");
+
+		return {std::max(m_Resolution.x >> level, 1u), std::max(m_Resolution.y >> level, 1u)};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const uint8_t* CompressedImage::level_data(const unsigned level) const
+	{
+		CBN_Assert(level < levels(), "Level is out of range");
+
+		return m_Data.data() + m_Levels[level].offset;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t CompressedImage::level_size(const unsigned level) const
+	{
+		CBN_Assert(level < levels(), "Level is out of range");
+
+		return m_Levels[level].length;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t CompressedImage::byte_size() const
+	{
+		uint64_t byte_size = 0;
+		for(const auto& level : m_Levels)
+			byte_size += level.length;
+
+		return byte_size;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
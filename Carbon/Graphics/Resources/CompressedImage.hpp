@@ -0,0 +1,111 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <filesystem>
+#include <stdint.h>
+#include <vector>
+
+#include "../../Memory/Resource.hpp"
+#include "../OpenGL/OpenGL.hpp"
+#include "ImageView.hpp"
+
+namespace cbn
+{
+
+	// The S3TC formats come from an extension, so their values are
+	// given explicitly in case the loader was generated without it.
+	enum class CompressedFormat : GLenum
+	{
+		BC1_RGB = 0x83F0,
+		BC1_RGBA = 0x83F1,
+		BC1_SRGB = 0x8C4C,
+		BC1_SRGB_ALPHA = 0x8C4D,
+		BC2 = 0x83F2,
+		BC2_SRGB = 0x8C4E,
+		BC3 = 0x83F3,
+		BC3_SRGB = 0x8C4F,
+		BC4 = 0x8DBB,
+		BC4_SIGNED = 0x8DBC,
+		BC5 = 0x8DBD,
+		BC5_SIGNED = 0x8DBE,
+		BC6H_SIGNED = 0x8E8E,
+		BC6H_UNSIGNED = 0x8E8F,
+		BC7 = 0x8E8C,
+		BC7_SRGB = 0x8E8D,
+		ETC2_RGB = 0x9274,
+		ETC2_SRGB = 0x9275,
+		ETC2_RGB_A1 = 0x9276,
+		ETC2_SRGB_A1 = 0x9277,
+		ETC2_RGBA = 0x9278,
+		ETC2_SRGB_ALPHA = 0x9279,
+		EAC_R11 = 0x9270,
+		EAC_R11_SIGNED = 0x9271,
+		EAC_RG11 = 0x9272,
+		EAC_RG11_SIGNED = 0x9273
+	};
+
+	// Block compression trades encoding speed for quality, see BlockCompression.hpp
+	enum class CompressionQuality
+	{
+		FAST,
+		BALANCED,
+		BEST
+	};
+
+	class CompressedImage
+	{
+	public:
+
+		static SRes<CompressedImage> Open(const std::filesystem::path& path);
+
+		// Block compresses the image, along with its full chain of mipmaps if requested. The
+		// mipmaps are downsampled on the CPU, as they cannot be generated on the GPU for
+		// compressed textures. Returns nullptr if the image is empty or the format cannot be
+		// encoded.
+		static SRes<CompressedImage> Encode(const ImageView& image, const CompressedFormat format, const CompressionQuality quality = CompressionQuality::FAST, const bool mipmaps = true, const unsigned thread_count = 0);
+
+		static uint64_t BlockSize(const CompressedFormat format);
+
+		// Checks whether the value is one of the compressed formats, such as one read from a file
+		static bool IsCompressedFormat(const uint32_t value);
+
+	private:
+
+		struct Level
+		{
+			uint64_t offset;
+			uint64_t length;
+		};
+
+		const CompressedFormat m_Format;
+		const glm::uvec2 m_Resolution;
+		const std::vector<uint8_t> m_Data;
+		const std::vector<Level> m_Levels;
+
+		static bool to_compressed_format(const uint32_t vk_format, CompressedFormat& format);
+
+		CompressedImage(const CompressedFormat format, const glm::uvec2& resolution, std::vector<uint8_t>&& data, std::vector<Level>&& levels);
+
+	public:
+
+		CompressedFormat format() const;
+
+		const unsigned width() const;
+
+		const unsigned height() const;
+
+		glm::uvec2 resolution() const;
+
+		unsigned levels() const;
+
+		glm::uvec2 level_resolution(const unsigned level) const;
+
+		const uint8_t* level_data(const unsigned level) const;
+
+		uint64_t level_size(const unsigned level) const;
+
+		uint64_t byte_size() const;
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,427 @@
+#include "DynamicTextureAtlas.hpp"
+
+#include <algorithm>
+
+#include "../../Diagnostics/Assert.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	DynamicTextureAtlas::Repack DynamicTextureAtlas::pack_page(const glm::uvec2& size, const unsigned padding, std::vector<std::pair<uint32_t, SRes<Image>>> images)
+	{
+		// Inserting the tallest images first gives the skyline a much flatter
+		// profile than the order in which they originally arrived in.
+		std::sort(images.begin(), images.end(), [](const auto& left, const auto& right){
+			if(left.second->height() != right.second->height())
+				return left.second->height() > right.second->height();
+			return left.second->width() > right.second->width();
+		});
+
+		Repack repack;
+		SkylinePacker packer(size);
+		repack.placements.reserve(images.size());
+		for(const auto& [handle, image] : images)
+		{
+			const auto rect = packer.insert(image->width() + padding, image->height() + padding);
+			if(!rect.has_value())
+				return {};
+
+			repack.placements.push_back({handle, {rect->x, rect->y, static_cast<int>(image->width()), static_cast<int>(image->height())}});
+		}
+
+		// The whole page is composed on the CPU, so that
+		// applying the repack only takes a single upload.
+		repack.image = Image::Create(size.x, size.y);
+		repack.image->fill(Colour(0, 0, 0, 0));
+		for(int i = 0; i < images.size(); i++)
+			repack.image->insert(repack.placements[i].rect.x, repack.placements[i].rect.y, images[i].second);
+
+		repack.packer = packer;
+		return repack;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t DynamicTextureAtlas::padded_area(const SRes<Image>& image) const
+	{
+		return static_cast<uint64_t>(image->width() + m_Properties.padding) * (image->height() + m_Properties.padding);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	TextureUVMap DynamicTextureAtlas::calculate_uvs(const Rect<int>& rect) const
+	{
+		const glm::vec2 page_resolution = m_Properties.page_size;
+		return {
+			glm::vec2{rect.x, rect.y} / page_resolution,
+			glm::vec2{rect.x, rect.y + rect.height} / page_resolution,
+			glm::vec2{rect.x + rect.width, rect.y + rect.height} / page_resolution,
+			glm::vec2{rect.x + rect.width, rect.y} / page_resolution
+		};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool DynamicTextureAtlas::create_page()
+	{
+		auto texture = Texture::Create(m_Properties.page_size.x, m_Properties.page_size.y, m_Properties.texture_settings);
+		if(!texture)
+			return false;
+
+		// Pages start out transparent so that the padding between images stays empty. They are
+		// cleared a band of rows at a time, rather than from a transparent image of the whole page.
+		const unsigned band_height = std::min(m_ClearRows, m_Properties.page_size.y);
+		const auto band = Image::Create(m_Properties.page_size.x, band_height);
+		band->fill(Colour(0, 0, 0, 0));
+		for(unsigned y = 0; y < m_Properties.page_size.y; y += band_height)
+			texture->upload(band->data(), 0, y, m_Properties.page_size.x, std::min(band_height, m_Properties.page_size.y - y));
+
+		// The mipmaps are left uninitialized, so they are generated on the next update
+		m_Pages.push_back({texture, SkylinePacker(m_Properties.page_size), 0, true});
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<Rect<int>> DynamicTextureAtlas::allocate(const unsigned page, const SRes<Image>& image)
+	{
+		auto& target = m_Pages[page];
+
+		const auto rect = target.packer.insert(image->width() + m_Properties.padding, image->height() + m_Properties.padding);
+		if(!rect.has_value())
+			return std::nullopt;
+
+		// Only the region covered by the new image needs to be uploaded
+		target.texture->upload(image->data(), rect->x, rect->y, image->width(), image->height());
+		target.dirty = true;
+
+		return Rect<int>{rect->x, rect->y, static_cast<int>(image->width()), static_cast<int>(image->height())};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint32_t DynamicTextureAtlas::add_entry(const SRes<Image>& image, const unsigned page, const Rect<int>& rect)
+	{
+		const uint32_t handle = m_NextHandle++;
+
+		m_LRU.push_back(handle);
+		m_Entries[handle] = {image, page, rect, m_Frame, std::prev(m_LRU.end())};
+		m_Pages[page].live_area += padded_area(image);
+
+		return handle;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void DynamicTextureAtlas::erase_entry(const uint32_t handle)
+	{
+		const auto& entry = m_Entries.at(handle);
+
+		// The page's layout has changed, so it's worth trying to repack it again
+		auto& page = m_Pages[entry.page];
+		page.live_area -= padded_area(entry.image);
+		page.repack_failed = false;
+
+		m_LRU.erase(entry.lru_position);
+		m_Entries.erase(handle);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::vector<std::pair<uint32_t, SRes<Image>>> DynamicTextureAtlas::collect_images(const unsigned page) const
+	{
+		std::vector<std::pair<uint32_t, SRes<Image>>> images;
+		for(const auto& [handle, entry] : m_Entries)
+			if(entry.page == page)
+				images.emplace_back(handle, entry.image);
+
+		return images;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void DynamicTextureAtlas::apply_repack(const unsigned page, Repack& repack)
+	{
+		auto& target = m_Pages[page];
+		if(!repack.packer.has_value())
+		{
+			target.repack_failed = true;
+			return;
+		}
+
+		target.texture->upload(repack.image->data(), 0, 0, repack.image->width(), repack.image->height());
+		target.packer = *repack.packer;
+		target.dirty = true;
+
+		// Images may have been removed while the repack was running in the background,
+		// these are still in the packed layout but their space is now counted as waste.
+		target.live_area = 0;
+		for(const auto& placement : repack.placements)
+		{
+			if(auto entry = m_Entries.find(placement.handle); entry != m_Entries.end() && entry->second.page == page)
+			{
+				entry->second.rect = placement.rect;
+				target.live_area += padded_area(entry->second.image);
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void DynamicTextureAtlas::finish_repack(const unsigned page)
+	{
+		Repack repack = m_Pages[page].repack.get();
+		apply_repack(page, repack);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool DynamicTextureAtlas::is_fragmented(const unsigned page) const
+	{
+		const auto& target = m_Pages[page];
+		if(target.repack_failed)
+			return false;
+
+		const uint64_t page_area = static_cast<uint64_t>(m_Properties.page_size.x) * m_Properties.page_size.y;
+		const uint64_t wasted_area = target.packer.covered_area() - target.live_area;
+
+		return wasted_area > m_Properties.repack_threshold * page_area;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::vector<bool> DynamicTextureAtlas::find_pages_in_use() const
+	{
+		std::vector<bool> in_use(m_Pages.size(), false);
+		for(const auto& [handle, entry] : m_Entries)
+			if(entry.last_used >= m_Frame)
+				in_use[entry.page] = true;
+
+		return in_use;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<uint32_t> DynamicTextureAtlas::evict_and_insert(const SRes<Image>& image)
+	{
+		const uint64_t page_area = static_cast<uint64_t>(m_Properties.page_size.x) * m_Properties.page_size.y;
+		const uint64_t required_area = padded_area(image);
+
+		// Repacking a page moves all of its images, so pages with images that have been used 
+		// this frame are left alone, as those images might already be part of a batch. Their
+		// unused images are not evicted either, as the space could not be reclaimed until the
+		// page is repacked in the background during an update. 
+		const std::vector<bool> pages_in_use = find_pages_in_use();
+
+		auto victim = m_LRU.begin();
+		while(victim != m_LRU.end())
+		{
+			// Since the list is in order, no image after one used this frame can be evicted
+			const auto& entry = m_Entries.at(*victim);
+			if(entry.last_used >= m_Frame)
+				return std::nullopt;
+
+			const unsigned page = entry.page;
+			if(pages_in_use[page])
+			{
+				++victim;
+				continue;
+			}
+
+			erase_entry(*(victim++));
+
+			auto& target = m_Pages[page];
+			if(page_area - target.live_area < required_area)
+				continue;
+
+			// The image needs a place right now, so the page must be repacked immediately.
+			// Any repack already running in the background is out of date, so it's discarded.
+			if(target.repack.valid())
+				target.repack.get();
+
+			auto images = collect_images(page);
+			images.emplace_back(m_NextHandle, image);
+
+			Repack repack = pack_page(m_Properties.page_size, m_Properties.padding, std::move(images));
+			if(!repack.packer.has_value())
+				continue;
+
+			// The entry is added before applying the repack, so that it receives its placement
+			const uint32_t handle = add_entry(image, page, {});
+			apply_repack(page, repack);
+			return handle;
+		}
+
+		return std::nullopt;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	DynamicTextureAtlas::DynamicTextureAtlas(const DynamicAtlasProperties& properties)
+		: m_Properties(properties),
+		m_NextHandle(0),
+		m_Frame(0)
+	{
+		CBN_Assert(properties.page_size.x > 0 && properties.page_size.y > 0, "Atlas pages must be non-empty");
+		CBN_Assert(properties.max_pages > 0, "Atlas needs at least one page");
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	DynamicTextureAtlas::~DynamicTextureAtlas()
+	{
+		for(auto& page : m_Pages)
+			if(page.repack.valid())
+				page.repack.wait();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<uint32_t> DynamicTextureAtlas::insert(const SRes<Image>& image)
+	{
+		if(!image || image->width() + m_Properties.padding > m_Properties.page_size.x
+		|| image->height() + m_Properties.padding > m_Properties.page_size.y)
+			return std::nullopt;
+
+		// Pages which are being repacked are skipped, as any new
+		// images would not be a part of the repacked layout.
+		for(unsigned p = 0; p < m_Pages.size(); p++)
+		{
+			if(m_Pages[p].repack.valid())
+				continue;
+
+			if(const auto rect = allocate(p, image); rect.has_value())
+				return add_entry(image, p, *rect);
+		}
+
+		if(m_Pages.size() < m_Properties.max_pages && create_page())
+		{
+			const unsigned page = m_Pages.size() - 1;
+			if(const auto rect = allocate(page, image); rect.has_value())
+				return add_entry(image, page, *rect);
+		}
+
+		return evict_and_insert(image);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void DynamicTextureAtlas::remove(const uint32_t handle)
+	{
+		if(contains(handle))
+			erase_entry(handle);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void DynamicTextureAtlas::touch(const uint32_t handle)
+	{
+		CBN_Assert(contains(handle), "Handle does not belong to an image in this atlas");
+
+		auto& entry = m_Entries.at(handle);
+		entry.last_used = m_Frame;
+		m_LRU.splice(m_LRU.end(), m_LRU, entry.lru_position);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void DynamicTextureAtlas::update()
+	{
+		m_Frame++;
+
+		for(unsigned p = 0; p < m_Pages.size(); p++)
+		{
+			auto& page = m_Pages[p];
+
+			// Finished repacks are applied here on the GL thread, while new ones are launched
+			// for any page which has wasted too much space underneath its skyline.
+			if(page.repack.valid())
+			{
+				if(page.repack.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+					finish_repack(p);
+			}
+			else if(is_fragmented(p))
+			{
+				page.repack = std::async(std::launch::async, &DynamicTextureAtlas::pack_page, m_Properties.page_size, m_Properties.padding, collect_images(p));
+			}
+
+			// Mipmaps are regenerated at most once a frame, rather than after every upload
+			if(page.dirty)
+			{
+				page.texture->generate_mipmaps();
+				page.dirty = false;
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool DynamicTextureAtlas::contains(const uint32_t handle) const
+	{
+		return m_Entries.count(handle);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	DynamicSubTexture DynamicTextureAtlas::get_subtexture(const uint32_t handle) const
+	{
+		CBN_Assert(contains(handle), "Handle does not belong to an image in this atlas");
+
+		const auto& entry = m_Entries.at(handle);
+		return {entry.page, entry.rect, calculate_uvs(entry.rect)};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const SRes<Texture>& DynamicTextureAtlas::page_texture(const unsigned page) const
+	{
+		CBN_Assert(page < m_Pages.size(), "Page is out of range");
+
+		return m_Pages[page].texture;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool DynamicTextureAtlas::is_repacking() const
+	{
+		return std::any_of(m_Pages.begin(), m_Pages.end(), [](const Page& page){
+			return page.repack.valid();
+		});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	int DynamicTextureAtlas::entry_count() const
+	{
+		return m_Entries.size();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	int DynamicTextureAtlas::page_count() const
+	{
+		return m_Pages.size();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t DynamicTextureAtlas::used_area() const
+	{
+		uint64_t used_area = 0;
+		for(const auto& [handle, entry] : m_Entries)
+			used_area += static_cast<uint64_t>(entry.rect.width) * entry.rect.height;
+
+		return used_area;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	DynamicAtlasProperties DynamicTextureAtlas::properties() const
+	{
+		return m_Properties;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <unordered_map>
+#include <optional>
+#include <stdint.h>
+#include <future>
+#include <vector>
+#include <list>
+
+#include "../../Algorithms/BinPacking.hpp"
+#include "../../Memory/Resource.hpp"
+#include "Texture.hpp"
+#include "Image.hpp"
+
+namespace cbn
+{
+
+	struct DynamicAtlasProperties
+	{
+		glm::uvec2 page_size = {2048, 2048};
+		unsigned max_pages = 4;
+		unsigned padding = 1;
+		float repack_threshold = 0.25f;
+		TextureSettings texture_settings = {};
+	};
+
+	struct DynamicSubTexture
+	{
+		unsigned page;
+		Rect<int> rect;
+		TextureUVMap uvs;
+	};
+
+	// An atlas which images can be inserted into and removed from at runtime. Each page packs
+	// its images with a skyline, and only the newly inserted sub-rectangle is uploaded. When the
+	// atlas is full the least recently used images are evicted, and pages which have wasted too
+	// much space are repacked in the background. Images are referenced by stable handles, but
+	// a handle's location may change after a repack so it should be looked up when it is used.
+	// Images which are touched or inserted during a frame never move until the next update, so
+	// that batches can reference them safely. A full page is only repacked mid-frame if none of
+	// its images have been used that frame, and otherwise waits for its background repack.
+	// Inserted images are kept for repacking, so they must not be modified after insertion.
+	class DynamicTextureAtlas
+	{
+	private:
+
+		struct Entry
+		{
+			SRes<Image> image;
+			unsigned page;
+			Rect<int> rect;
+			uint64_t last_used;
+			std::list<uint32_t>::iterator lru_position;
+		};
+
+		struct Placement
+		{
+			uint32_t handle;
+			Rect<int> rect;
+		};
+
+		struct Repack
+		{
+			std::optional<SkylinePacker> packer;
+			SRes<Image> image;
+			std::vector<Placement> placements;
+		};
+
+		struct Page
+		{
+			SRes<Texture> texture;
+			SkylinePacker packer;
+			uint64_t live_area = 0;
+			bool dirty = false;
+			bool repack_failed = false;
+			std::future<Repack> repack;
+		};
+
+		static constexpr unsigned m_ClearRows = 64;
+
+		const DynamicAtlasProperties m_Properties;
+
+		std::vector<Page> m_Pages;
+		std::unordered_map<uint32_t, Entry> m_Entries;
+		std::list<uint32_t> m_LRU;
+		uint32_t m_NextHandle;
+		uint64_t m_Frame;
+
+		static Repack pack_page(const glm::uvec2& size, const unsigned padding, std::vector<std::pair<uint32_t, SRes<Image>>> images);
+
+		uint64_t padded_area(const SRes<Image>& image) const;
+
+		TextureUVMap calculate_uvs(const Rect<int>& rect) const;
+
+		bool create_page();
+
+		std::optional<Rect<int>> allocate(const unsigned page, const SRes<Image>& image);
+
+		uint32_t add_entry(const SRes<Image>& image, const unsigned page, const Rect<int>& rect);
+
+		void erase_entry(const uint32_t handle);
+
+		std::vector<std::pair<uint32_t, SRes<Image>>> collect_images(const unsigned page) const;
+
+		void apply_repack(const unsigned page, Repack& repack);
+
+		void finish_repack(const unsigned page);
+
+		bool is_fragmented(const unsigned page) const;
+
+		std::vector<bool> find_pages_in_use() const;
+
+		std::optional<uint32_t> evict_and_insert(const SRes<Image>& image);
+
+	public:
+
+		DynamicTextureAtlas(const DynamicAtlasProperties& properties = {});
+
+		~DynamicTextureAtlas();
+
+		std::optional<uint32_t> insert(const SRes<Image>& image);
+
+		void remove(const uint32_t handle);
+
+		void touch(const uint32_t handle);
+
+		void update();
+
+		bool contains(const uint32_t handle) const;
+
+		DynamicSubTexture get_subtexture(const uint32_t handle) const;
+
+		const SRes<Texture>& page_texture(const unsigned page) const;
+
+		bool is_repacking() const;
+
+		int entry_count() const;
+
+		int page_count() const;
+
+		uint64_t used_area() const;
+
+		DynamicAtlasProperties properties() const;
+
+	};
+
+}
\ No newline at end of file
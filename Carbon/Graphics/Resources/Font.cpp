@@ -0,0 +1,212 @@
+#include "Font.hpp"
+
+#include <algorithm>
+#include <fstream>
+
+#define STB_TRUETYPE_IMPLEMENTATION
+#include <stb_truetype.h>
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	constexpr uint32_t c_ReplacementCharacter = 0xFFFD;
+
+	//-------------------------------------------------------------------------------------
+
+	// Decodes the codepoint starting at the given position, and moves the position past it
+	uint32_t decode_utf8(const std::string_view& text, size_t& position)
+	{
+		const uint8_t lead = static_cast<uint8_t>(text[position++]);
+		if(lead < 0x80)
+			return lead;
+
+		unsigned length;
+		uint32_t codepoint, minimum;
+		if((lead & 0xE0) == 0xC0)
+		{
+			length = 1;
+			codepoint = lead & 0x1F;
+			minimum = 0x80;
+		}
+		else if((lead & 0xF0) == 0xE0)
+		{
+			length = 2;
+			codepoint = lead & 0x0F;
+			minimum = 0x800;
+		}
+		else if((lead & 0xF8) == 0xF0)
+		{
+			length = 3;
+			codepoint = lead & 0x07;
+			minimum = 0x10000;
+		}
+		else return c_ReplacementCharacter;
+
+		// Truncated sequences only skip their lead byte, so the bytes after it are not lost
+		for(unsigned i = 0; i < length; i++)
+		{
+			if(position + i >= text.size() || (static_cast<uint8_t>(text[position + i]) & 0xC0) != 0x80)
+				return c_ReplacementCharacter;
+
+			codepoint = (codepoint << 6) | (static_cast<uint8_t>(text[position + i]) & 0x3F);
+		}
+		position += length;
+
+		// Overlong encodings, surrogates and values past the end of unicode are invalid
+		if(codepoint < minimum || codepoint > 0x10FFFF || (codepoint >= 0xD800 && codepoint <= 0xDFFF))
+			return c_ReplacementCharacter;
+
+		return codepoint;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	float FontMetrics::line_height() const
+	{
+		return ascent - descent + line_gap;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<Font> Font::Open(const std::filesystem::path& path, const unsigned face)
+	{
+		if(!std::filesystem::is_regular_file(path))
+			return nullptr;
+
+		std::ifstream file(path, std::ios::binary | std::ios::ate);
+		if(!file)
+			return nullptr;
+
+		std::vector<uint8_t> data(static_cast<size_t>(file.tellg()));
+		file.seekg(0);
+		file.read(reinterpret_cast<char*>(data.data()), data.size());
+		if(!file)
+			return nullptr;
+
+		return Create(std::move(data), face);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<Font> Font::Create(std::vector<uint8_t>&& data, const unsigned face)
+	{
+		if(data.empty())
+			return nullptr;
+
+		const int offset = stbtt_GetFontOffsetForIndex(data.data(), static_cast<int>(face));
+		if(offset < 0)
+			return nullptr;
+
+		// The font info points into the data, which is safe to move as its buffer stays put
+		auto info = std::make_unique<stbtt_fontinfo>();
+		if(!stbtt_InitFont(info.get(), data.data(), offset))
+			return nullptr;
+
+		return Resource::WrapShared(new Font(std::move(data), std::move(info)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	Font::Font(std::vector<uint8_t>&& data, std::unique_ptr<stbtt_fontinfo>&& info)
+		: m_Data(std::move(data)),
+		m_Info(std::move(info))
+	{}
+
+	//-------------------------------------------------------------------------------------
+
+	Font::~Font() = default;
+
+	//-------------------------------------------------------------------------------------
+
+	uint32_t Font::glyph_index(const uint32_t codepoint) const
+	{
+		return static_cast<uint32_t>(stbtt_FindGlyphIndex(m_Info.get(), static_cast<int>(codepoint)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	FontMetrics Font::metrics(const float pixel_height) const
+	{
+		int ascent, descent, line_gap;
+		stbtt_GetFontVMetrics(m_Info.get(), &ascent, &descent, &line_gap);
+
+		const float scale = stbtt_ScaleForPixelHeight(m_Info.get(), pixel_height);
+		return {ascent * scale, descent * scale, line_gap * scale};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	ShapedText Font::shape(const std::string_view& text, const float pixel_height) const
+	{
+		const float scale = stbtt_ScaleForPixelHeight(m_Info.get(), pixel_height);
+		const FontMetrics metrics = this->metrics(pixel_height);
+
+		ShapedText shaped;
+		shaped.glyphs.reserve(text.size());
+
+		glm::vec2 pen = {0.0f, metrics.ascent};
+		float width = 0.0f;
+		bool has_previous = false;
+		int previous = 0;
+		for(size_t position = 0; position < text.size();)
+		{
+			const uint32_t codepoint = decode_utf8(text, position);
+			if(codepoint == '\n')
+			{
+				width = std::max(width, pen.x);
+				pen.x = 0.0f;
+				pen.y += metrics.line_height();
+				has_previous = false;
+				continue;
+			}
+
+			const int glyph = stbtt_FindGlyphIndex(m_Info.get(), static_cast<int>(codepoint));
+			if(has_previous)
+				pen.x += stbtt_GetGlyphKernAdvance(m_Info.get(), previous, glyph) * scale;
+
+			shaped.glyphs.push_back({static_cast<uint32_t>(glyph), pen});
+
+			int advance, left_bearing;
+			stbtt_GetGlyphHMetrics(m_Info.get(), glyph, &advance, &left_bearing);
+			pen.x += advance * scale;
+
+			previous = glyph;
+			has_previous = true;
+		}
+
+		shaped.size = {std::max(width, pen.x), pen.y - metrics.ascent + metrics.line_height()};
+		return shaped;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<Image> Font::rasterize(const uint32_t glyph, const float pixel_height, glm::ivec2& offset) const
+	{
+		if(stbtt_IsGlyphEmpty(m_Info.get(), static_cast<int>(glyph)))
+			return nullptr;
+
+		const float scale = stbtt_ScaleForPixelHeight(m_Info.get(), pixel_height);
+
+		int x0, y0, x1, y1;
+		stbtt_GetGlyphBitmapBox(m_Info.get(), static_cast<int>(glyph), scale, scale, &x0, &y0, &x1, &y1);
+		if(x1 <= x0 || y1 <= y0)
+			return nullptr;
+
+		const int width = x1 - x0, height = y1 - y0;
+		std::vector<uint8_t> coverage(static_cast<size_t>(width) * height);
+		stbtt_MakeGlyphBitmap(m_Info.get(), coverage.data(), width, height, width, scale, scale, static_cast<int>(glyph));
+
+		std::vector<Colour> pixels(coverage.size());
+		std::transform(coverage.begin(), coverage.end(), pixels.begin(), [](const uint8_t alpha)
+		{
+			return Colour(255, 255, 255, alpha);
+		});
+
+		offset = {x0, y0};
+		return Image::Create(width, height, std::move(pixels));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
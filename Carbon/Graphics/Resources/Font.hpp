@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string_view>
+#include <filesystem>
+#include <stdint.h>
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../../Memory/Resource.hpp"
+#include "Image.hpp"
+
+struct stbtt_fontinfo;
+
+namespace cbn
+{
+
+	struct FontMetrics
+	{
+		float ascent;
+		float descent;
+		float line_gap;
+
+		float line_height() const;
+	};
+
+	struct ShapedGlyph
+	{
+		uint32_t glyph;
+		glm::vec2 position;
+	};
+
+	// A run of text laid out into glyphs. Positions are the pen position of each glyph on its
+	// baseline, relative to the top left corner of the text with y pointing down. 
+	struct ShapedText
+	{
+		std::vector<ShapedGlyph> glyphs;
+		glm::vec2 size;
+	};
+
+	// A TrueType or OpenType font, which shapes text and rasterizes its glyphs at any size.
+	class Font
+	{
+	public:
+
+		static SRes<Font> Open(const std::filesystem::path& path, const unsigned face = 0);
+
+		static SRes<Font> Create(std::vector<uint8_t>&& data, const unsigned face = 0);
+
+	private:
+
+		std::vector<uint8_t> m_Data;
+		std::unique_ptr<stbtt_fontinfo> m_Info;
+
+		Font(std::vector<uint8_t>&& data, std::unique_ptr<stbtt_fontinfo>&& info);
+
+	public:
+
+		~Font();
+
+		uint32_t glyph_index(const uint32_t codepoint) const;
+
+		FontMetrics metrics(const float pixel_height) const;
+
+		// Lays out UTF-8 text, starting a new line at each newline and applying the font's kerning.
+		// Invalid UTF-8 is shaped as the replacement character.
+		ShapedText shape(const std::string_view& text, const float pixel_height) const;
+
+		// Rasterizes the glyph as white with its coverage in the alpha. The offset is set to 
+		// the position of the image's top left corner relative to the glyph's pen position.
+		// Glyphs with no outline, such as spaces, have no image and return nullptr. 
+		SRes<Image> rasterize(const uint32_t glyph, const float pixel_height, glm::ivec2& offset) const;
+
+	};
+
+}
\ No newline at end of file
@@ -1,5 +1,18 @@
 #include "Image.hpp"
 
+#include <condition_variable>
+#include <algorithm>
+#include <optional>
+#include <fstream>
+#include <cstring>
+#include <limits>
+#include <atomic>
+#include <thread>
+#include <mutex>
+
+#include "../../Memory/MappedFile.hpp"
+#include "QOI.hpp"
+
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
@@ -10,6 +23,52 @@ namespace cbn
 {
     //-------------------------------------------------------------------------------------
 
+    constexpr uint8_t c_RawIdentifier[8] = {'C', 'B', 'N', 'I', 'M', 'A', 'G', 'E'};
+    constexpr uint32_t c_RawVersion = 1;
+    constexpr char c_RawExtension[] = ".cbnimg";
+
+    // Raw images are laid out as the header, followed by the rows of RGBA pixels from top
+    // to bottom. The pixels are aligned to a page, so that they start on a page boundary 
+    // of the mapping and can be uploaded straight from it. 
+#pragma pack(push, 1)
+
+    struct RawImageHeader
+    {
+        uint8_t identifier[8];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint64_t pixel_offset;
+    };
+
+#pragma pack(pop)
+
+    //-------------------------------------------------------------------------------------
+
+    std::optional<RawImageHeader> read_raw_header(const uint8_t* data, const uint64_t size)
+    {
+        if(size < sizeof(RawImageHeader))
+            return std::nullopt;
+
+        RawImageHeader header;
+        std::memcpy(&header, data, sizeof(RawImageHeader));
+        if(std::memcmp(header.identifier, c_RawIdentifier, sizeof(c_RawIdentifier)) != 0 || header.version != c_RawVersion)
+            return std::nullopt;
+
+        // The pixel count of an image is 32 bit, so larger images cannot be represented
+        const uint64_t pixel_count = static_cast<uint64_t>(header.width) * header.height;
+        if(pixel_count == 0 || pixel_count > std::numeric_limits<unsigned>::max())
+            return std::nullopt;
+
+        // The pixels must be aligned and lie entirely within the data
+        if(header.pixel_offset % alignof(Colour) != 0 || header.pixel_offset > size || pixel_count * sizeof(Colour) > size - header.pixel_offset)
+            return std::nullopt;
+
+        return header;
+    }
+
+    //-------------------------------------------------------------------------------------
+
     SRes<Image> Image::Create(const unsigned width, const unsigned height, std::vector<Colour>& data)
     {
         // If the given data does not exactly match the resolution 
@@ -31,10 +90,9 @@ namespace cbn
             return nullptr;
 
         // If we are here, everything went fine so create the image 
-        // Since we are moving the data, shrink the vector 
-        // then take ownership of the internal pointer
-        data.shrink_to_fit();
-        return Resource::WrapShared(new Image(width, height, data.data(), true));
+        // Note that a vector cannot give up ownership of its internal
+        // pointer, so the data has to be copied just like the lvalue overload. 
+        return Resource::WrapShared(new Image(width, height, data.data(), false));
     }
     
     //-------------------------------------------------------------------------------------
@@ -44,6 +102,19 @@ namespace cbn
         return Resource::WrapShared(new Image(width, height));
     }
     
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> Image::Create(const ImageView& image)
+    {
+        if(image.is_empty())
+            return nullptr;
+
+        // Copies the pixels of the view, so that the image no longer depends on their source
+        SRes<Image> result = Create(image.width(), image.height());
+        result->insert_pixels(0, 0, image);
+        return result;
+    }
+    
     //-------------------------------------------------------------------------------------
     
     SRes<Image> Image::Open(const std::filesystem::path& path)
@@ -52,62 +123,325 @@ namespace cbn
         if(!std::filesystem::exists(path) && !std::filesystem::is_regular_file(path))
             return nullptr;
 
+        // QOI images are decoded by our own codec, straight from the mapped file
+        if(path.extension() == ".qoi")
+        {
+            const SRes<MappedFile> file = MappedFile::Open(path);
+            if(!file)
+                return nullptr;
+
+            return decode_qoi(file->data(), file->size());
+        }
+
+        // Raw images do not need decoding, so they are mapped instead
+        if(path.extension() == c_RawExtension)
+            return map_raw(path);
+
         // Load image using stb_image
         int width, height, components;
         stbi_uc* image_data = stbi_load(path.string().c_str(), &width, &height, &components, m_Components);
         if(image_data == NULL)
             return nullptr;
 
-        // When we create the image, take ownership of the data
-        // Note that stb_image expects you to call stbi_free on the
-        // image_data, but we will instead deallocate it normally since
-        // thats all it does in this version of stb_image and it will provide
-        // a performance boost since we dont need to copy the data. 
-        return Resource::WrapShared(new Image(width, height, reinterpret_cast<Colour*>(image_data), true));
+        // Take ownership of the decoded data without copying it, freeing it through stb_image as it was allocated there
+        const std::shared_ptr<Colour> pixels(reinterpret_cast<Colour*>(image_data), [](Colour* data){ stbi_image_free(data); });
+        return Resource::WrapShared(new Image(width, height, pixels));
     }
 
     //-------------------------------------------------------------------------------------
-    
-    void Image::insert_pixels(const unsigned x_offset, const unsigned y_offset, const Colour* pixels, const unsigned width, const unsigned height)
+
+    std::vector<std::tuple<SRes<Image>, String>> Image::OpenMany(std::span<const std::filesystem::path> paths, const bool read_ahead, const unsigned thread_count)
     {
-        // Clip the pixels if they extend out of the image
-        const unsigned end_x = std::min(x_offset + width, this->width());
-        const unsigned end_y = std::min(y_offset + height, this->height());
+        std::vector<std::tuple<SRes<Image>, String>> results(paths.size());
+        if(paths.empty())
+            return results;
 
-        // Copy over all pixels to the image
-        for(unsigned y = y_offset; y < end_y; y++)
+        struct FileData
         {
-            for(unsigned x = x_offset; x < end_x; x++)
+            std::vector<uint8_t> bytes;
+            uint64_t reserved = 0;
+            bool read = false, failed = false;
+        };
+
+        std::vector<FileData> files(read_ahead ? paths.size() : 0);
+        std::condition_variable file_read, file_decoded;
+        uint64_t buffered_bytes = 0;
+        std::mutex file_mutex;
+
+        // The files are read in the same order they are decoded, and reading stops once too many
+        // bytes are waiting to be decoded. At least one file is always let through, so that files 
+        // larger than the budget are still read.
+        const auto read_files = [&]()
+        {
+            for(size_t i = 0; i < paths.size(); i++)
+            {
+                // Raw images are mapped by the decoding threads rather than read
+                if(paths[i].extension() == c_RawExtension)
+                    continue;
+
+                std::error_code error;
+                const uint64_t size = std::filesystem::file_size(paths[i], error);
+                const uint64_t reserved = error ? 0 : size;
+
+                std::unique_lock lock(file_mutex);
+                file_decoded.wait(lock, [&](){
+                    return buffered_bytes == 0 || buffered_bytes + reserved <= m_ReadAheadBudget;
+                });
+                buffered_bytes += reserved;
+                lock.unlock();
+
+                std::vector<uint8_t> bytes;
+                std::ifstream file(paths[i], std::ios::binary);
+                if(!error && file)
+                {
+                    bytes.resize(size);
+                    file.read(reinterpret_cast<char*>(bytes.data()), size);
+                }
+                const bool failed = error || !file || file.gcount() != static_cast<std::streamsize>(size);
+
+                lock.lock();
+                files[i].bytes = std::move(bytes);
+                files[i].reserved = reserved;
+                files[i].failed = failed;
+                files[i].read = true;
+                lock.unlock();
+                file_read.notify_all();
+            }
+        };
+
+        // Images are claimed in order, so each decoding thread waits
+        // on the file that the reading thread will provide soonest.
+        std::atomic<size_t> next_image = 0;
+        const auto decode_files = [&]()
+        {
+            for(size_t i = next_image++; i < paths.size(); i = next_image++)
             {
-                set_pixel(x, y, pixels[coord_to_index(x - x_offset, y - y_offset, width)]);
+                if(!read_ahead || paths[i].extension() == c_RawExtension)
+                {
+                    results[i] = load(paths[i]);
+                    continue;
+                }
+
+                std::unique_lock lock(file_mutex);
+                file_read.wait(lock, [&](){ return files[i].read; });
+                const std::vector<uint8_t> bytes = std::move(files[i].bytes);
+                const bool failed = files[i].failed;
+                lock.unlock();
+
+                if(failed)
+                    results[i] = {nullptr, "Could not read file"};
+                else
+                    results[i] = decode(bytes);
+
+                lock.lock();
+                buffered_bytes -= files[i].reserved;
+                lock.unlock();
+                file_decoded.notify_one();
             }
+        };
+
+        const unsigned hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+        const unsigned threads = static_cast<unsigned>(std::min<size_t>(thread_count == 0 ? hardware_threads : thread_count, paths.size()));
+
+        std::thread reader;
+        if(read_ahead)
+            reader = std::thread(read_files);
+
+        // The calling thread also decodes, rather than waiting idle on the others
+        std::vector<std::thread> workers;
+        for(unsigned t = 1; t < threads; t++)
+            workers.emplace_back(decode_files);
+        decode_files();
+
+        for(auto& worker : workers)
+            worker.join();
+
+        if(reader.joinable())
+            reader.join();
+
+        return results;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    std::tuple<SRes<Image>, String> Image::decode(const std::vector<uint8_t>& file)
+    {
+        if(QOIDecoder::ReadHeader(file.data(), file.size()))
+        {
+            SRes<Image> image = decode_qoi(file.data(), file.size());
+            if(!image)
+                return {nullptr, "Could not decode QOI file"};
+
+            return {image, ""};
+        }
+
+        // Raw images that were read into memory cannot reference it, so their pixels are copied
+        if(const auto header = read_raw_header(file.data(), file.size()))
+        {
+            Colour* pixels = reinterpret_cast<Colour*>(const_cast<uint8_t*>(file.data() + header->pixel_offset));
+            return {Resource::WrapShared(new Image(header->width, header->height, pixels, false)), ""};
+        }
+
+        if(file.empty() || file.size() > static_cast<size_t>(std::numeric_limits<int>::max()))
+            return {nullptr, "Could not decode file"};
+
+        int width, height, components;
+        stbi_uc* image_data = stbi_load_from_memory(file.data(), static_cast<int>(file.size()), &width, &height, &components, m_Components);
+        if(image_data == NULL)
+            return {nullptr, String{stbi_failure_reason()}};
+
+        // Take ownership of the decoded data without copying it, freeing it through stb_image as it was allocated there
+        const std::shared_ptr<Colour> pixels(reinterpret_cast<Colour*>(image_data), [](Colour* data){ stbi_image_free(data); });
+        return {Resource::WrapShared(new Image(width, height, pixels)), ""};
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    std::tuple<SRes<Image>, String> Image::load(const std::filesystem::path& path)
+    {
+        if(!std::filesystem::is_regular_file(path))
+            return {nullptr, "Could not find file"};
+
+        SRes<Image> image = Open(path);
+        if(!image)
+        {
+            if(path.extension() == ".qoi")
+                return {nullptr, "Could not decode QOI file"};
+
+            if(path.extension() == c_RawExtension)
+                return {nullptr, "Could not map raw image file"};
+
+            return {nullptr, String{stbi_failure_reason()}};
+        }
+
+        return {image, ""};
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> Image::decode_qoi(const uint8_t* data, const uint64_t size)
+    {
+        const auto header = QOIDecoder::ReadHeader(data, size);
+        if(!header)
+            return nullptr;
+
+        SRes<Image> image = Create(header->width, header->height);
+        if(!QOIDecoder::Decode(data, size, image->m_Data.get(), image->size()))
+            return nullptr;
+
+        return image;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool Image::save_qoi(const std::filesystem::path& path) const
+    {
+        std::ofstream file(path, std::ios::binary);
+        if(!file)
+            return false;
+
+        // The image is encoded in batches into a fixed size buffer,
+        // which is written out to the file after each batch. 
+        constexpr uint64_t batch_size = 16 * 1024;
+        std::vector<uint8_t> buffer(batch_size * QOIEncoder::MaxPixelSize + QOIEncoder::MaxTrailerSize);
+
+        QOIEncoder encoder;
+        file.write(reinterpret_cast<const char*>(buffer.data()), encoder.begin(width(), height(), buffer.data()));
+        for(uint64_t offset = 0; offset < size(); offset += batch_size)
+        {
+            const uint64_t count = std::min<uint64_t>(batch_size, size() - offset);
+            file.write(reinterpret_cast<const char*>(buffer.data()), encoder.encode(m_Data.get() + offset, count, buffer.data()));
         }
+        file.write(reinterpret_cast<const char*>(buffer.data()), encoder.finish(buffer.data()));
+
+        return file.good();
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> Image::map_raw(const std::filesystem::path& path)
+    {
+        // The mapping is copy-on-write, so the image can be modified without changing the file
+        const SRes<MappedFile> file = MappedFile::Open(path, true);
+        if(!file)
+            return nullptr;
+
+        const auto header = read_raw_header(file->data(), file->size());
+        if(!header)
+            return nullptr;
+
+        // Start paging in the pixels in the background, so that they are mostly resident by the
+        // time that they are uploaded, instead of the upload faulting in one page at a time.
+        file->prefetch();
+
+        // The pixels share ownership of the mapping, so that it 
+        // is only unmapped once the image no longer needs them.
+        Colour* pixels = reinterpret_cast<Colour*>(file->writable_data() + header->pixel_offset);
+        return Resource::WrapShared(new Image(header->width, header->height, std::shared_ptr<Colour>(file, pixels)));
     }
 
     //-------------------------------------------------------------------------------------
 
-    void Image::insert_pixels_rotated(const unsigned x_offset, const unsigned y_offset, const Colour* pixels, const unsigned width, const unsigned height)
+    bool Image::save_raw(const std::filesystem::path& path) const
+    {
+        RawImageHeader header;
+        std::memcpy(header.identifier, c_RawIdentifier, sizeof(c_RawIdentifier));
+        header.version = c_RawVersion;
+        header.width = width();
+        header.height = height();
+        header.pixel_offset = m_RawPixelAlignment;
+
+        // The image is written to a temporary file first and then moved over the old file,
+        // as the old file may still be mapped by this image or another, and must not be
+        // truncated from underneath it. If it is mapped, it is replaced on its next load.
+        const auto temporary_path = std::filesystem::path(path).concat(".tmp");
+        {
+            std::ofstream file(temporary_path, std::ios::binary | std::ios::trunc);
+            if(!file)
+                return false;
+
+            const std::vector<char> padding(m_RawPixelAlignment - sizeof(RawImageHeader), 0);
+            file.write(reinterpret_cast<const char*>(&header), sizeof(RawImageHeader));
+            file.write(padding.data(), padding.size());
+            file.write(reinterpret_cast<const char*>(m_Data.get()), byte_size());
+
+            if(!file)
+                return false;
+        }
+
+        return MappedFile::Replace(temporary_path, path);
+    }
+
+    //-------------------------------------------------------------------------------------
+    
+    void Image::insert_pixels(const unsigned x_offset, const unsigned y_offset, const ImageView& pixels)
+    {
+        // Clip the pixels if they extend out of the image
+        const unsigned end_x = std::min(x_offset + pixels.width(), width());
+        const unsigned end_y = std::min(y_offset + pixels.height(), height());
+        if(end_x <= x_offset || end_y <= y_offset)
+            return;
+
+        // Copy over all pixels to the image, one row at a time
+        copy_pixels(m_Data.get() + coord_to_index(x_offset, y_offset), width(), pixels.data(), pixels.stride(), end_x - x_offset, end_y - y_offset);
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    void Image::insert_pixels_rotated(const unsigned x_offset, const unsigned y_offset, const ImageView& pixels)
     {
         // Clip the pixels if they extend out of the image
         // Note that we are rotating the pixels, so we compare the 
         // height of the pixels with the width of this image vice-versa. 
-        const unsigned end_x = std::min(x_offset + height, this->width());
-        const unsigned end_y = std::min(y_offset + width, this->height());
-
-        // Copy over all pixels to the image
-        // Note that we are retrieving values from the pixels
-        // array with a switched x and y coord, so to avoid 
-        // cache misses, we actually want to loop x first. 
-        for(unsigned x = x_offset; x < end_x; x++)
-        {
-            for(unsigned y = y_offset; y < end_y; y++)
-            {
-                // The image is being inserted with a rotation, so the x and y
-                // are swapped between the coordinated of this image and the pixels
-                // being inserted. 
-                set_pixel(x, y, pixels[coord_to_index(y - y_offset, x - x_offset, width)]);
-            }
-        }
+        const unsigned end_x = std::min(x_offset + pixels.height(), width());
+        const unsigned end_y = std::min(y_offset + pixels.width(), height());
+        if(end_x <= x_offset || end_y <= y_offset)
+            return;
+
+        // The image is being inserted with a rotation, so the x and y are swapped 
+        // between the coordinates of this image and the pixels being inserted. 
+        // This makes the inserted region the transpose of the clipped pixels. 
+        transpose_pixels(m_Data.get() + coord_to_index(x_offset, y_offset), width(), pixels.data(), pixels.stride(), end_y - y_offset, end_x - x_offset);
     }
     
     //-------------------------------------------------------------------------------------
@@ -115,9 +449,9 @@ namespace cbn
     void Image::allocate(const unsigned width, const unsigned height, bool set_to_zero)
     {
         if(set_to_zero)
-            m_Data = std::unique_ptr<Colour>(new Colour[static_cast<uint64_t>(width) * height]);
+            m_Data = std::shared_ptr<Colour>(new Colour[static_cast<uint64_t>(width) * height], std::default_delete<Colour[]>());
         else
-            m_Data = std::unique_ptr<Colour>(new Colour[static_cast<uint64_t>(width) * height]);
+            m_Data = std::shared_ptr<Colour>(new Colour[static_cast<uint64_t>(width) * height], std::default_delete<Colour[]>());
     }
  
     //-------------------------------------------------------------------------------------
@@ -147,7 +481,7 @@ namespace cbn
         else
         {
             allocate(width, height, false);
-            insert_pixels(0, 0, data, width, height);
+            insert_pixels(0, 0, ImageView(data, width, height, width));
         }
     }
     
@@ -159,15 +493,19 @@ namespace cbn
         allocate(width, height, true);
     }
     
+    //-------------------------------------------------------------------------------------
+
+    Image::Image(const unsigned width, const unsigned height, const std::shared_ptr<Colour>& data)
+        : m_Data(data),
+        m_Resolution(width, height)
+    {}
+    
     //-------------------------------------------------------------------------------------
     
     void Image::fill(const Colour& colour)
     {
         // Replace all pixels with the given colour
-        for(unsigned i = 0; i < size(); i++)
-        {
-            *(m_Data.get() + i) = colour;
-        }
+        fill_pixels(m_Data.get(), width(), colour, width(), height());
     }
     
     //-------------------------------------------------------------------------------------
@@ -180,7 +518,7 @@ namespace cbn
         {
             for(unsigned x = 0; x < width(); x += image->width())
             {
-                insert_pixels(x, y, image->m_Data.get(), image->width(), image->height());
+                insert_pixels(x, y, image->view());
             }
         }
     }
@@ -188,11 +526,66 @@ namespace cbn
     //-------------------------------------------------------------------------------------
 
     void Image::insert(const unsigned x, const unsigned y, const SRes<Image>& image, const bool rotate)
+    {
+        insert(x, y, image->view(), rotate);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    void Image::insert(const unsigned x, const unsigned y, const ImageView& image, const bool rotate)
     {
         if(rotate)
-            insert_pixels_rotated(x, y, image->m_Data.get(), image->width(), image->height());
+            insert_pixels_rotated(x, y, image);
         else
-            insert_pixels(x, y, image->m_Data.get(), image->width(), image->height());
+            insert_pixels(x, y, image);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    void Image::blend(const unsigned x, const unsigned y, const SRes<Image>& image)
+    {
+        blend(x, y, image->view());
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    void Image::blend(const unsigned x, const unsigned y, const ImageView& image)
+    {
+        // Clip the image if it extends out of this image
+        const unsigned end_x = std::min(x + image.width(), width());
+        const unsigned end_y = std::min(y + image.height(), height());
+        if(end_x <= x || end_y <= y)
+            return;
+
+        blend_pixels(m_Data.get() + coord_to_index(x, y), width(), image.data(), image.stride(), end_x - x, end_y - y);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    void Image::tint(const Colour& colour)
+    {
+        tint_pixels(m_Data.get(), width(), colour, width(), height());
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    void Image::rotate_hue(const float degrees, const unsigned thread_count)
+    {
+        rotate_hue_pixels(m_Data.get(), width(), width(), height(), degrees, thread_count);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    void Image::premultiply(const unsigned thread_count)
+    {
+        premultiply_pixels(m_Data.get(), width(), width(), height(), thread_count);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    void Image::unpremultiply(const unsigned thread_count)
+    {
+        unpremultiply_pixels(m_Data.get(), width(), width(), height(), thread_count);
     }
     
     //-------------------------------------------------------------------------------------
@@ -215,9 +608,95 @@ namespace cbn
     
     //-------------------------------------------------------------------------------------
     
+    SRes<Image> Image::downsample() const
+    {
+        return Downsample(view());
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> Image::Downsample(const ImageView& image)
+    {
+        if(image.is_empty())
+            return nullptr;
+
+        const unsigned half_width = std::max(image.width() / 2, 1u);
+        const unsigned half_height = std::max(image.height() / 2, 1u);
+        SRes<Image> result = Create(half_width, half_height);
+
+        // Each pixel is the rounded average of a 2x2 box of pixels from the image,
+        // with the colours weighted by their alpha so transparent pixels do not bleed.
+        // If a dimension is odd, the last row or column is clamped to the edge of the
+        // image so that it still contributes, but the extra pixel is not averaged in.
+        downsample_pixels(result->m_Data.get(), half_width, image.data(), image.stride(), image.width(), image.height());
+
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> Image::resize(const unsigned width, const unsigned height, const ResampleFilter filter, const unsigned thread_count) const
+    {
+        if(width == 0 || height == 0)
+            return nullptr;
+
+        SRes<Image> result = Create(width, height);
+        resample_pixels(result->m_Data.get(), width, width, height, m_Data.get(), this->width(), this->width(), this->height(), filter, thread_count);
+
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> Image::distance_field(const float spread, const unsigned downscale, const unsigned thread_count) const
+    {
+        return DistanceField(view(), spread, downscale, thread_count);
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> Image::DistanceField(const ImageView& image, const float spread, const unsigned downscale, const unsigned thread_count)
+    {
+        if(image.is_empty() || spread <= 0.0f || downscale == 0)
+            return nullptr;
+
+        // The field is stored in the alpha of white pixels, so a single channel of distances
+        // can be packed into atlases alongside regular sprites and tinted when rendered.
+        const unsigned field_width = (image.width() + downscale - 1) / downscale;
+        const unsigned field_height = (image.height() + downscale - 1) / downscale;
+        SRes<Image> result = Create(field_width, field_height);
+        distance_field_pixels(result->m_Data.get(), field_width, image.data(), image.stride(), image.width(), image.height(), spread, downscale, thread_count);
+
+        return result;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    ImageView Image::view() const
+    {
+        return ImageView(m_Data.get(), width(), height(), width());
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    ImageView Image::view(const unsigned x, const unsigned y, const unsigned width, const unsigned height) const
+    {
+        CBN_Assert(x + width <= this->width() && y + height <= this->height(), "View is outside of the image");
+
+        return ImageView(m_Data.get() + coord_to_index(x, y), width, height, this->width());
+    }
+    
+    //-------------------------------------------------------------------------------------
+    
     bool Image::save(const std::filesystem::path& path) const
     {
-        // Use stb_image_write to save the image to a png file
+        if(path.extension() == ".qoi")
+            return save_qoi(path);
+
+        if(path.extension() == c_RawExtension)
+            return save_raw(path);
+
+        // Otherwise use stb_image_write to save the image to a png file
         return stbi_write_png(path.string().c_str(), width(), height(), m_Components, m_Data.get(), sizeof(Colour) * width());
     }
     
@@ -3,10 +3,15 @@
 #include <glm/glm.hpp>
 #include <filesystem>
 #include <vector>
+#include <tuple>
+#include <span>
 
 #include "../../Data/Identity/Identifiable.hpp"
+#include "../../Data/String.hpp"
 #include "../../Memory/Resource.hpp"
 #include "../../Utility/Colour.hpp"
+#include "ImageKernels.hpp"
+#include "ImageView.hpp"
 
 namespace cbn
 {
@@ -22,18 +27,48 @@ namespace cbn
 
 		static SRes<Image> Create(const unsigned width, const unsigned height);
 
+		static SRes<Image> Create(const ImageView& image);
+
+		// Opens an image file, which is decoded into memory unless it is a raw image. Raw images 
+		// hold uncompressed RGBA rows, so they are memory mapped and the image references the 
+		// mapping directly instead of copying it. Their pixels are paged in by the OS as they are
+		// accessed, and the mapping is copy-on-write so that the image can still be modified.
 		static SRes<Image> Open(const std::filesystem::path& path);
 
+		// Decodes a batch of images across a pool of threads, returning each image in the same
+		// order as its path, along with the reason it failed to load if it is null. When reading
+		// ahead, a dedicated thread reads each file into memory with a single sequential read so
+		// that the decoding threads never wait on the disk. 
+		static std::vector<std::tuple<SRes<Image>, String>> OpenMany(std::span<const std::filesystem::path> paths, const bool read_ahead = true, const unsigned thread_count = 0);
+
+		static SRes<Image> Downsample(const ImageView& image);
+
+		static SRes<Image> DistanceField(const ImageView& image, const float spread, const unsigned downscale = 1, const unsigned thread_count = 0);
+
 	private:
 
 		static constexpr int m_Components = 4;
+		static constexpr uint64_t m_ReadAheadBudget = 256 * 1024 * 1024;
+		static constexpr uint64_t m_RawPixelAlignment = 4096;
+
+		static std::tuple<SRes<Image>, String> decode(const std::vector<uint8_t>& file);
+
+		static std::tuple<SRes<Image>, String> load(const std::filesystem::path& path);
+
+		static SRes<Image> decode_qoi(const uint8_t* data, const uint64_t size);
+
+		bool save_qoi(const std::filesystem::path& path) const;
+
+		static SRes<Image> map_raw(const std::filesystem::path& path);
+
+		bool save_raw(const std::filesystem::path& path) const;
 
 		std::shared_ptr<Colour> m_Data;
 		glm::uvec2 m_Resolution;
 
-		void insert_pixels(const unsigned x_offset, const unsigned y_offset, const Colour* pixels, const unsigned width, const unsigned height);
+		void insert_pixels(const unsigned x_offset, const unsigned y_offset, const ImageView& pixels);
 
-		void insert_pixels_rotated(const unsigned x_offset, const unsigned y_offset, const Colour* pixels, const unsigned width, const unsigned height);
+		void insert_pixels_rotated(const unsigned x_offset, const unsigned y_offset, const ImageView& pixels);
 
 		void allocate(const unsigned width, const unsigned height, bool set_to_zero);
 
@@ -45,6 +80,8 @@ namespace cbn
 
 		Image(const unsigned width, const unsigned height);
 
+		Image(const unsigned width, const unsigned height, const std::shared_ptr<Colour>& data);
+
 	public:
 
 		void fill(const Colour& colour);
@@ -52,11 +89,35 @@ namespace cbn
 		void fill(const SRes<Image>& image);
 
 		void insert(const unsigned x, const unsigned y, const SRes<Image>& image, const bool rotate_90_degrees = false);
+
+		void insert(const unsigned x, const unsigned y, const ImageView& image, const bool rotate_90_degrees = false);
+
+		void blend(const unsigned x, const unsigned y, const SRes<Image>& image);
+
+		void blend(const unsigned x, const unsigned y, const ImageView& image);
+
+		void tint(const Colour& colour);
+
+		void rotate_hue(const float degrees, const unsigned thread_count = 0);
+
+		void premultiply(const unsigned thread_count = 0);
+
+		void unpremultiply(const unsigned thread_count = 0);
 		
 		void set_pixel(const unsigned x, const unsigned y, const Colour& pixel);
 
 		Colour get_pixel(const unsigned x, const unsigned y) const;
 
+		SRes<Image> downsample() const;
+
+		SRes<Image> resize(const unsigned width, const unsigned height, const ResampleFilter filter = ResampleFilter::LANCZOS, const unsigned thread_count = 0) const;
+
+		SRes<Image> distance_field(const float spread, const unsigned downscale = 1, const unsigned thread_count = 0) const;
+
+		ImageView view() const;
+
+		ImageView view(const unsigned x, const unsigned y, const unsigned width, const unsigned height) const;
+
 		//TODO: draw(x, y, shape, colour)
 
 		bool save(const std::filesystem::path& path) const;
@@ -0,0 +1,1376 @@
+#include "ImageKernels.hpp"
+
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <vector>
+#include <array>
+#include <cmath>
+
+#include "../../Diagnostics/Assert.hpp"
+#include "../../Maths/Maths.hpp"
+
+#if defined(__AVX2__)
+	#include <immintrin.h>
+	#define CBN_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define CBN_SSE2
+#endif
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	// Transposes are done in blocks whose source and destination both fit in the L1 cache,
+	// so that the strided writes of a block keep hitting the same cache lines. Within each
+	// block, square tiles of pixels are transposed entirely in registers.
+	constexpr unsigned c_TransposeBlock = 32;
+
+	// Resampling splits rows across threads, but only if each thread gets enough rows
+	constexpr unsigned c_MinParallelRows = 16;
+
+	// Distance transforms run down columns in groups that share cache lines, and treat 
+	// pixels without a seed as being further away than any real distance could be. 
+	constexpr unsigned c_DistanceColumns = 16;
+	constexpr float c_DistanceFar = 1e20f;
+
+#if defined(CBN_AVX2)
+	constexpr unsigned c_TransposeTile = 8;
+#elif defined(CBN_SSE2)
+	constexpr unsigned c_TransposeTile = 4;
+#else
+	constexpr unsigned c_TransposeTile = 1;
+#endif
+
+	//-------------------------------------------------------------------------------------
+
+	void transpose_tile(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride)
+	{
+#if defined(CBN_AVX2)
+		__m256i r[8];
+		for(unsigned i = 0; i < 8; i++)
+			r[i] = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + static_cast<size_t>(i) * src_stride));
+
+		// Interleave pairs of rows, then pairs of pairs. This transposes the 4x4 quadrants
+		// held in each 128-bit lane, which are then swapped across the lanes.
+		const __m256i t0 = _mm256_unpacklo_epi32(r[0], r[1]);
+		const __m256i t1 = _mm256_unpackhi_epi32(r[0], r[1]);
+		const __m256i t2 = _mm256_unpacklo_epi32(r[2], r[3]);
+		const __m256i t3 = _mm256_unpackhi_epi32(r[2], r[3]);
+		const __m256i t4 = _mm256_unpacklo_epi32(r[4], r[5]);
+		const __m256i t5 = _mm256_unpackhi_epi32(r[4], r[5]);
+		const __m256i t6 = _mm256_unpacklo_epi32(r[6], r[7]);
+		const __m256i t7 = _mm256_unpackhi_epi32(r[6], r[7]);
+
+		const __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+		const __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+		const __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+		const __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+		const __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+		const __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+		const __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+		const __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+
+		r[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+		r[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+		r[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+		r[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+		r[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+		r[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+		r[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+		r[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+
+		for(unsigned i = 0; i < 8; i++)
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + static_cast<size_t>(i) * dst_stride), r[i]);
+#elif defined(CBN_SSE2)
+		const __m128i r0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		const __m128i r1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + src_stride));
+		const __m128i r2 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + static_cast<size_t>(src_stride) * 2));
+		const __m128i r3 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + static_cast<size_t>(src_stride) * 3));
+
+		const __m128i t0 = _mm_unpacklo_epi32(r0, r1);
+		const __m128i t1 = _mm_unpacklo_epi32(r2, r3);
+		const __m128i t2 = _mm_unpackhi_epi32(r0, r1);
+		const __m128i t3 = _mm_unpackhi_epi32(r2, r3);
+
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_unpacklo_epi64(t0, t1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + dst_stride), _mm_unpackhi_epi64(t0, t1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + static_cast<size_t>(dst_stride) * 2), _mm_unpacklo_epi64(t2, t3));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + static_cast<size_t>(dst_stride) * 3), _mm_unpackhi_epi64(t2, t3));
+#else
+		*dst = *src;
+#endif
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void transpose_block(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height)
+	{
+		const unsigned tiled_width = width - width % c_TransposeTile;
+		const unsigned tiled_height = height - height % c_TransposeTile;
+
+		for(unsigned y = 0; y < tiled_height; y += c_TransposeTile)
+		{
+			for(unsigned x = 0; x < tiled_width; x += c_TransposeTile)
+			{
+				transpose_tile(
+					dst + static_cast<size_t>(x) * dst_stride + y, dst_stride,
+					src + static_cast<size_t>(y) * src_stride + x, src_stride
+				);
+			}
+		}
+
+		// Transpose the pixels along the right and bottom edges which
+		// did not fill a whole tile one at a time.
+		for(unsigned y = 0; y < height; y++)
+		{
+			for(unsigned x = (y < tiled_height ? tiled_width : 0); x < width; x++)
+			{
+				dst[static_cast<size_t>(x) * dst_stride + y] = src[static_cast<size_t>(y) * src_stride + x];
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void fill_row(Colour* dst, const Colour colour, const size_t count)
+	{
+		size_t i = 0;
+
+#if defined(CBN_SSE2)
+		const __m128i value = _mm_set1_epi32(static_cast<int>(colour.hex));
+		for(; i + 4 <= count; i += 4)
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), value);
+#endif
+
+		for(; i < count; i++)
+			dst[i] = colour;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Divides a product of two 8-bit values by 255, rounding to the nearest integer.
+	uint8_t div_255(const unsigned value)
+	{
+		const unsigned rounded = value + 128;
+		return static_cast<uint8_t>((rounded + (rounded >> 8)) >> 8);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	Colour blend_pixel(const Colour dst, const Colour src)
+	{
+		if(src.alpha == 0)
+			return dst;
+
+		const float source_weight = src.alpha / 255.0f;
+		const float dest_weight = (dst.alpha / 255.0f) * (1.0f - source_weight);
+		const float alpha = source_weight + dest_weight;
+
+		return Colour(
+			static_cast<uint8_t>((src.red * source_weight + dst.red * dest_weight) / alpha + 0.5f),
+			static_cast<uint8_t>((src.green * source_weight + dst.green * dest_weight) / alpha + 0.5f),
+			static_cast<uint8_t>((src.blue * source_weight + dst.blue * dest_weight) / alpha + 0.5f),
+			static_cast<uint8_t>(alpha * 255.0f + 0.5f)
+		);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void blend_row(Colour* dst, const Colour* src, const unsigned count)
+	{
+		unsigned i = 0;
+
+#if defined(CBN_SSE2)
+		const __m128i byte_mask = _mm_set1_epi32(0xFF);
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 max_value = _mm_set1_ps(255.0f);
+		const __m128 min_alpha = _mm_set1_ps(1.0f / 1024.0f);
+
+		// Blend four pixels at a time, with each channel split into its own register so
+		// that every lane holds the same channel of a different pixel.
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+			const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+
+			const __m128i source_alpha = _mm_srli_epi32(s, 24);
+			const __m128i transparent = _mm_cmpeq_epi32(source_alpha, _mm_setzero_si128());
+			if(_mm_movemask_epi8(transparent) == 0xFFFF)
+				continue;
+
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(source_alpha, _mm_set1_epi32(255))) == 0xFFFF)
+			{
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), s);
+				continue;
+			}
+
+			const __m128 source_weight = _mm_div_ps(_mm_cvtepi32_ps(source_alpha), max_value);
+			const __m128 dest_weight = _mm_mul_ps(
+				_mm_div_ps(_mm_cvtepi32_ps(_mm_srli_epi32(d, 24)), max_value),
+				_mm_sub_ps(one, source_weight)
+			);
+			const __m128 alpha = _mm_add_ps(source_weight, dest_weight);
+
+			// The alpha is only zero for transparent source pixels, which are discarded below,
+			// so clamp it to avoid dividing by zero.
+			const __m128 safe_alpha = _mm_max_ps(alpha, min_alpha);
+
+			__m128i result = _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(alpha, max_value), half)), 24);
+			for(int shift = 0; shift < 24; shift += 8)
+			{
+				const __m128 source_channel = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(s, shift), byte_mask));
+				const __m128 dest_channel = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(d, shift), byte_mask));
+
+				const __m128 channel = _mm_div_ps(
+					_mm_add_ps(_mm_mul_ps(source_channel, source_weight), _mm_mul_ps(dest_channel, dest_weight)),
+					safe_alpha
+				);
+
+				result = _mm_or_si128(result, _mm_slli_epi32(_mm_cvttps_epi32(_mm_add_ps(channel, half)), shift));
+			}
+
+			// Keep the destination pixel wherever the source pixel is transparent
+			result = _mm_or_si128(_mm_and_si128(transparent, d), _mm_andnot_si128(transparent, result));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+		}
+#endif
+
+		for(; i < count; i++)
+			dst[i] = blend_pixel(dst[i], src[i]);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void tint_row(Colour* dst, const Colour tint, const unsigned count)
+	{
+		unsigned i = 0;
+
+#if defined(CBN_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rounding = _mm_set1_epi16(128);
+		const __m128i factor = _mm_unpacklo_epi8(_mm_set1_epi32(static_cast<int>(tint.hex)), zero);
+
+		// Widen each channel to 16 bits so the products fit, then divide by 255
+		// with the same rounding as div_255, two pixels per register.
+		const auto multiply = [&](const __m128i channels)
+		{
+			__m128i product = _mm_add_epi16(_mm_mullo_epi16(channels, factor), rounding);
+			return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+		};
+
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+			const __m128i low = multiply(_mm_unpacklo_epi8(pixels, zero));
+			const __m128i high = multiply(_mm_unpackhi_epi8(pixels, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+		}
+#endif
+
+		for(; i < count; i++)
+		{
+			dst[i] = Colour(
+				div_255(dst[i].red * tint.red),
+				div_255(dst[i].green * tint.green),
+				div_255(dst[i].blue * tint.blue),
+				div_255(dst[i].alpha * tint.alpha)
+			);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	Colour downsample_pixel(const Colour p_00, const Colour p_01, const Colour p_10, const Colour p_11)
+	{
+		const unsigned alpha = p_00.alpha + p_01.alpha + p_10.alpha + p_11.alpha;
+
+		// A fully transparent block has no alpha to weight the colours by, so they are averaged
+		const auto average = [&](const unsigned c_00, const unsigned c_01, const unsigned c_10, const unsigned c_11)
+		{
+			if(alpha == 0)
+				return static_cast<uint8_t>((c_00 + c_01 + c_10 + c_11 + 2) / 4);
+
+			const unsigned weighted = c_00 * p_00.alpha + c_01 * p_01.alpha + c_10 * p_10.alpha + c_11 * p_11.alpha;
+			return static_cast<uint8_t>(static_cast<float>(weighted) / static_cast<float>(alpha) + 0.5f);
+		};
+
+		return Colour(
+			average(p_00.red, p_01.red, p_10.red, p_11.red),
+			average(p_00.green, p_01.green, p_10.green, p_11.green),
+			average(p_00.blue, p_01.blue, p_10.blue, p_11.blue),
+			static_cast<uint8_t>((alpha + 2) / 4)
+		);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void downsample_row(Colour* dst, const Colour* row_0, const Colour* row_1, const unsigned width, const unsigned half_width)
+	{
+		unsigned x = 0;
+
+#if defined(CBN_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i two = _mm_set1_epi16(2);
+		const __m128i byte_mask = _mm_set1_epi32(0xFF);
+		const __m128i opaque = _mm_set1_epi32(255);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 one = _mm_set1_ps(1.0f);
+
+		// Splits eight consecutive pixels into the even and odd pixels, which 
+		// are the left and right pixels of four neighbouring 2x2 blocks. 
+		const auto split = [](const Colour* pixels, __m128i& even, __m128i& odd)
+		{
+			const __m128 left = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels)));
+			const __m128 right = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + 4)));
+			even = _mm_castps_si128(_mm_shuffle_ps(left, right, _MM_SHUFFLE(2, 0, 2, 0)));
+			odd = _mm_castps_si128(_mm_shuffle_ps(left, right, _MM_SHUFFLE(3, 1, 3, 1)));
+		};
+
+		// Four blocks are downsampled at a time, as long as all their pixels lie within the row
+		for(; x + 4 <= width / 2; x += 4)
+		{
+			__m128i p_00, p_01, p_10, p_11;
+			split(row_0 + x * 2, p_00, p_01);
+			split(row_1 + x * 2, p_10, p_11);
+
+			const __m128i a_00 = _mm_srli_epi32(p_00, 24);
+			const __m128i a_01 = _mm_srli_epi32(p_01, 24);
+			const __m128i a_10 = _mm_srli_epi32(p_10, 24);
+			const __m128i a_11 = _mm_srli_epi32(p_11, 24);
+
+			// If every pixel is opaque the weights are all equal, so the 
+			// channels can be averaged directly in 16-bit lanes.
+			const __m128i min_alpha = _mm_and_si128(_mm_and_si128(p_00, p_01), _mm_and_si128(p_10, p_11));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_srli_epi32(min_alpha, 24), opaque)) == 0xFFFF)
+			{
+				const auto average = [&](const auto unpack)
+				{
+					const __m128i sum = _mm_add_epi16(
+						_mm_add_epi16(unpack(p_00, zero), unpack(p_01, zero)),
+						_mm_add_epi16(unpack(p_10, zero), unpack(p_11, zero))
+					);
+					return _mm_srli_epi16(_mm_add_epi16(sum, two), 2);
+				};
+
+				const __m128i low = average([](const __m128i a, const __m128i b){ return _mm_unpacklo_epi8(a, b); });
+				const __m128i high = average([](const __m128i a, const __m128i b){ return _mm_unpackhi_epi8(a, b); });
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), _mm_packus_epi16(low, high));
+				continue;
+			}
+
+			const __m128i alpha = _mm_add_epi32(_mm_add_epi32(a_00, a_01), _mm_add_epi32(a_10, a_11));
+			const __m128i transparent = _mm_cmpeq_epi32(alpha, _mm_setzero_si128());
+			const __m128 alpha_sum = _mm_max_ps(_mm_cvtepi32_ps(alpha), one);
+
+			const __m128 w_00 = _mm_cvtepi32_ps(a_00);
+			const __m128 w_01 = _mm_cvtepi32_ps(a_01);
+			const __m128 w_10 = _mm_cvtepi32_ps(a_10);
+			const __m128 w_11 = _mm_cvtepi32_ps(a_11);
+
+			__m128i result = _mm_slli_epi32(_mm_srli_epi32(_mm_add_epi32(alpha, _mm_set1_epi32(2)), 2), 24);
+			for(int shift = 0; shift < 24; shift += 8)
+			{
+				const __m128i c_00 = _mm_and_si128(_mm_srli_epi32(p_00, shift), byte_mask);
+				const __m128i c_01 = _mm_and_si128(_mm_srli_epi32(p_01, shift), byte_mask);
+				const __m128i c_10 = _mm_and_si128(_mm_srli_epi32(p_10, shift), byte_mask);
+				const __m128i c_11 = _mm_and_si128(_mm_srli_epi32(p_11, shift), byte_mask);
+
+				// The products and their sum are exact in single precision, 
+				// so this matches the scalar path to the bit. 
+				const __m128 weighted = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(c_00), w_00), _mm_mul_ps(_mm_cvtepi32_ps(c_01), w_01)),
+					_mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(c_10), w_10), _mm_mul_ps(_mm_cvtepi32_ps(c_11), w_11))
+				);
+				const __m128i weighted_average = _mm_cvttps_epi32(_mm_add_ps(_mm_div_ps(weighted, alpha_sum), half));
+
+				const __m128i sum = _mm_add_epi32(_mm_add_epi32(c_00, c_01), _mm_add_epi32(c_10, c_11));
+				const __m128i plain_average = _mm_srli_epi32(_mm_add_epi32(sum, _mm_set1_epi32(2)), 2);
+
+				const __m128i channel = _mm_or_si128(_mm_and_si128(transparent, plain_average), _mm_andnot_si128(transparent, weighted_average));
+				result = _mm_or_si128(result, _mm_slli_epi32(channel, shift));
+			}
+
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + x), result);
+		}
+#endif
+
+		for(; x < half_width; x++)
+		{
+			const unsigned x_0 = std::min(x * 2, width - 1);
+			const unsigned x_1 = std::min(x * 2 + 1, width - 1);
+			dst[x] = downsample_pixel(row_0[x_0], row_0[x_1], row_1[x_0], row_1[x_1]);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// The taps of a separable filter along one axis. Each destination pixel has its 
+	// own run of source pixels, with weights stored in a fixed number of slots. 
+	struct ResampleWeights
+	{
+		std::vector<unsigned> first;
+		std::vector<unsigned> count;
+		std::vector<float> weights;
+		unsigned slots;
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	float filter_support(const ResampleFilter filter)
+	{
+		switch(filter)
+		{
+			case ResampleFilter::BOX: return 0.5f;
+			case ResampleFilter::BILINEAR: return 1.0f;
+			case ResampleFilter::LANCZOS: return 3.0f;
+		}
+		return 0.0f;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	float filter_weight(const ResampleFilter filter, const float x)
+	{
+		switch(filter)
+		{
+			case ResampleFilter::BOX: 
+				return (x >= -0.5f && x < 0.5f) ? 1.0f : 0.0f;
+			case ResampleFilter::BILINEAR: 
+				return std::max(1.0f - std::abs(x), 0.0f);
+			case ResampleFilter::LANCZOS:
+			{
+				if(x == 0.0f)
+					return 1.0f;
+				if(std::abs(x) >= 3.0f)
+					return 0.0f;
+
+				const float px = PI * x;
+				return 3.0f * std::sin(px) * std::sin(px / 3.0f) / (px * px);
+			}
+		}
+		return 0.0f;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	ResampleWeights resample_weights(const unsigned src_size, const unsigned dst_size, const ResampleFilter filter)
+	{
+		// When shrinking, the filter is widened so that every source pixel
+		// contributes to the destination pixels that cover it. 
+		const float scale = static_cast<float>(src_size) / static_cast<float>(dst_size);
+		const float filter_scale = std::max(scale, 1.0f);
+		const float support = filter_support(filter) * filter_scale;
+
+		ResampleWeights result;
+		result.slots = static_cast<unsigned>(std::ceil(support * 2.0f)) + 2;
+		result.first.resize(dst_size);
+		result.count.resize(dst_size);
+		result.weights.resize(static_cast<size_t>(dst_size) * result.slots, 0.0f);
+
+		for(unsigned x = 0; x < dst_size; x++)
+		{
+			const float center = (x + 0.5f) * scale;
+			const int first = std::max(static_cast<int>(std::floor(center - support)), 0);
+			const int last = std::min({static_cast<int>(std::ceil(center + support)), static_cast<int>(src_size), first + static_cast<int>(result.slots)});
+
+			float* weights = result.weights.data() + static_cast<size_t>(x) * result.slots;
+			float total = 0.0f;
+			for(int i = first; i < last; i++)
+			{
+				weights[i - first] = filter_weight(filter, (i + 0.5f - center) / filter_scale);
+				total += weights[i - first];
+			}
+
+			// Normalize the weights, so that the taps cut off at the
+			// edges of the image do not darken or brighten it. 
+			if(total != 0.0f)
+			{
+				for(int i = first; i < last; i++)
+					weights[i - first] /= total;
+			}
+			else weights[std::min(static_cast<int>(center), last - 1) - first] = 1.0f;
+
+			result.first[x] = first;
+			result.count[x] = last - first;
+		}
+
+		return result;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void premultiply_row(float* dst, const Colour* src, const unsigned count)
+	{
+#if defined(CBN_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128 alpha_lane = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 inverse_max = _mm_set1_ps(1.0f / 255.0f);
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			const __m128i channels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(static_cast<int>(src[i].hex)), zero), zero);
+			const __m128 pixel = _mm_cvtepi32_ps(channels);
+			const __m128 alpha = _mm_mul_ps(_mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3)), inverse_max);
+			const __m128 factor = _mm_or_ps(_mm_andnot_ps(alpha_lane, alpha), _mm_and_ps(alpha_lane, one));
+			_mm_storeu_ps(dst + static_cast<size_t>(i) * 4, _mm_mul_ps(pixel, factor));
+		}
+#else
+		for(unsigned i = 0; i < count; i++)
+		{
+			const float alpha = src[i].alpha / 255.0f;
+			dst[i * 4 + 0] = src[i].red * alpha;
+			dst[i * 4 + 1] = src[i].green * alpha;
+			dst[i * 4 + 2] = src[i].blue * alpha;
+			dst[i * 4 + 3] = src[i].alpha;
+		}
+#endif
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void unpremultiply_row(Colour* dst, const float* src, const unsigned count)
+	{
+		// Pixels which are almost fully transparent have no meaningful colour left to
+		// recover, so they are cleared rather than amplifying their rounding error. 
+		constexpr float min_alpha = 1.0f / 256.0f;
+
+#if defined(CBN_SSE2)
+		const __m128 alpha_lane = _mm_castsi128_ps(_mm_set_epi32(-1, 0, 0, 0));
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 max_value = _mm_set1_ps(255.0f);
+		const __m128 threshold = _mm_set1_ps(min_alpha);
+
+		for(unsigned i = 0; i < count; i++)
+		{
+			const __m128 pixel = _mm_loadu_ps(src + static_cast<size_t>(i) * 4);
+			const __m128 alpha = _mm_shuffle_ps(pixel, pixel, _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128 scale = _mm_and_ps(_mm_cmpge_ps(alpha, threshold), _mm_div_ps(max_value, _mm_max_ps(alpha, threshold)));
+			const __m128 factor = _mm_or_ps(_mm_andnot_ps(alpha_lane, scale), _mm_and_ps(alpha_lane, one));
+
+			const __m128 clamped = _mm_min_ps(_mm_max_ps(_mm_mul_ps(pixel, factor), _mm_setzero_ps()), max_value);
+			const __m128i channels = _mm_cvttps_epi32(_mm_add_ps(clamped, half));
+			const __m128i words = _mm_packs_epi32(channels, channels);
+			dst[i].hex = static_cast<uint32_t>(_mm_cvtsi128_si32(_mm_packus_epi16(words, words)));
+		}
+#else
+		for(unsigned i = 0; i < count; i++)
+		{
+			const float* pixel = src + static_cast<size_t>(i) * 4;
+			const float scale = pixel[3] >= min_alpha ? 255.0f / pixel[3] : 0.0f;
+			const auto channel = [](const float value){
+				return static_cast<uint8_t>(std::clamp(value, 0.0f, 255.0f) + 0.5f);
+			};
+
+			dst[i] = Colour(channel(pixel[0] * scale), channel(pixel[1] * scale), channel(pixel[2] * scale), channel(pixel[3]));
+		}
+#endif
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void filter_row(float* dst, const float* src, const ResampleWeights& weights)
+	{
+		for(unsigned x = 0; x < weights.first.size(); x++)
+		{
+			const float* taps = src + static_cast<size_t>(weights.first[x]) * 4;
+			const float* tap_weights = weights.weights.data() + static_cast<size_t>(x) * weights.slots;
+
+#if defined(CBN_SSE2)
+			// Each register holds all four channels of a pixel
+			__m128 sum = _mm_setzero_ps();
+			for(unsigned k = 0; k < weights.count[x]; k++)
+				sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(tap_weights[k]), _mm_loadu_ps(taps + k * 4)));
+			_mm_storeu_ps(dst + static_cast<size_t>(x) * 4, sum);
+#else
+			float sum[4] = {};
+			for(unsigned k = 0; k < weights.count[x]; k++)
+				for(unsigned c = 0; c < 4; c++)
+					sum[c] += tap_weights[k] * taps[k * 4 + c];
+			std::copy(sum, sum + 4, dst + static_cast<size_t>(x) * 4);
+#endif
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void accumulate_row(float* dst, const float* src, const float weight, const size_t count)
+	{
+		size_t i = 0;
+
+#if defined(CBN_AVX2)
+		const __m256 wide_weight = _mm256_set1_ps(weight);
+		for(; i + 8 <= count; i += 8)
+			_mm256_storeu_ps(dst + i, _mm256_add_ps(_mm256_loadu_ps(dst + i), _mm256_mul_ps(wide_weight, _mm256_loadu_ps(src + i))));
+#endif
+
+#if defined(CBN_SSE2)
+		const __m128 narrow_weight = _mm_set1_ps(weight);
+		for(; i + 4 <= count; i += 4)
+			_mm_storeu_ps(dst + i, _mm_add_ps(_mm_loadu_ps(dst + i), _mm_mul_ps(narrow_weight, _mm_loadu_ps(src + i))));
+#endif
+
+		for(; i < count; i++)
+			dst[i] += weight * src[i];
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// The sRGB transfer function is applied through lookup tables. Decoding has one entry for 
+	// each 8-bit value. Encoding splits [0, 1] into buckets which are narrower than the gap
+	// between any two of the points where the encoded value rounds up, so the table gives the
+	// encoded value at the start of each bucket and one comparison finds the correct rounding.
+	constexpr unsigned c_SRGBEncodeBuckets = 4096;
+
+	struct SRGBTables
+	{
+		std::array<float, 256> decode;
+		std::array<uint8_t, c_SRGBEncodeBuckets + 1> encode;
+		std::array<float, 257> thresholds;
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	const SRGBTables& srgb_tables()
+	{
+		static const SRGBTables tables = []()
+		{
+			const auto decode = [](const double value)
+			{
+				return value <= 0.04045 ? value / 12.92 : std::pow((value + 0.055) / 1.055, 2.4);
+			};
+
+			SRGBTables tables;
+			for(unsigned i = 0; i < 256; i++)
+				tables.decode[i] = static_cast<float>(decode(i / 255.0));
+
+			// The threshold of each value is the smallest float for which it is the nearest
+			tables.thresholds[0] = -std::numeric_limits<float>::infinity();
+			tables.thresholds[256] = std::numeric_limits<float>::infinity();
+			for(unsigned i = 1; i < 256; i++)
+			{
+				const double threshold = decode((i - 0.5) / 255.0);
+				float& rounded = tables.thresholds[i] = static_cast<float>(threshold);
+				if(rounded < threshold)
+					rounded = std::nextafter(rounded, 1.0f);
+			}
+
+			unsigned value = 0;
+			for(unsigned i = 0; i <= c_SRGBEncodeBuckets; i++)
+			{
+				const float start = static_cast<float>(i) / c_SRGBEncodeBuckets;
+				while(start >= tables.thresholds[value + 1])
+					value++;
+
+				tables.encode[i] = static_cast<uint8_t>(value);
+			}
+
+			return tables;
+		}();
+
+		return tables;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint8_t encode_srgb(const SRGBTables& tables, const float value)
+	{
+		const float clamped = std::clamp(value, 0.0f, 1.0f);
+		const uint8_t lower = tables.encode[static_cast<unsigned>(clamped * c_SRGBEncodeBuckets)];
+		return lower + (clamped >= tables.thresholds[lower + 1] ? 1 : 0);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+#if defined(CBN_SSE2)
+
+	// Four pixels with their colour channels split into separate registers, scaled to [0, 1]
+	struct PixelChannels
+	{
+		__m128 red, green, blue;
+		__m128i alpha;
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	PixelChannels load_channels(const Colour* src)
+	{
+		const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		const __m128i mask = _mm_set1_epi32(0xFF);
+		const __m128 scale = _mm_set1_ps(1.0f / 255.0f);
+
+		return {
+			_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(pixels, mask)), scale),
+			_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 8), mask)), scale),
+			_mm_mul_ps(_mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, 16), mask)), scale),
+			_mm_srli_epi32(pixels, 24)
+		};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void store_channels(Colour* dst, const PixelChannels& channels)
+	{
+		// The channels are always within [0, 1], so they round to valid 8-bit values
+		const __m128 scale = _mm_set1_ps(255.0f);
+		const __m128i red = _mm_cvtps_epi32(_mm_mul_ps(channels.red, scale));
+		const __m128i green = _mm_cvtps_epi32(_mm_mul_ps(channels.green, scale));
+		const __m128i blue = _mm_cvtps_epi32(_mm_mul_ps(channels.blue, scale));
+
+		const __m128i pixels = _mm_or_si128(
+			_mm_or_si128(red, _mm_slli_epi32(green, 8)),
+			_mm_or_si128(_mm_slli_epi32(blue, 16), _mm_slli_epi32(channels.alpha, 24))
+		);
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dst), pixels);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	__m128 select(const __m128 mask, const __m128 if_true, const __m128 if_false)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, if_true), _mm_andnot_ps(mask, if_false));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Converts four colours to HSL with the same steps as Colour::to_hsl, but without branching
+	void channels_to_hsl(const PixelChannels& channels, __m128& hue, __m128& saturation, __m128& luminance)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 sign = _mm_set1_ps(-0.0f);
+
+		const __m128 c_max = _mm_max_ps(channels.red, _mm_max_ps(channels.green, channels.blue));
+		const __m128 c_min = _mm_min_ps(channels.red, _mm_min_ps(channels.green, channels.blue));
+		const __m128 delta = _mm_sub_ps(c_max, c_min);
+		luminance = _mm_mul_ps(_mm_add_ps(c_max, c_min), _mm_set1_ps(0.5f));
+
+		// Greys would divide by zero, so their divisors are replaced and their results discarded
+		const __m128 chromatic = _mm_cmpgt_ps(delta, zero);
+		const __m128 divisor = _mm_sub_ps(one, _mm_andnot_ps(sign, _mm_sub_ps(_mm_mul_ps(luminance, two), one)));
+		saturation = _mm_and_ps(chromatic, _mm_min_ps(_mm_div_ps(delta, select(chromatic, divisor, one)), one));
+		const __m128 inverse_delta = _mm_and_ps(chromatic, _mm_div_ps(one, select(chromatic, delta, one)));
+
+		__m128 red_hue = _mm_mul_ps(_mm_sub_ps(channels.green, channels.blue), inverse_delta);
+		red_hue = _mm_add_ps(red_hue, _mm_and_ps(_mm_cmplt_ps(red_hue, zero), _mm_set1_ps(6.0f)));
+		const __m128 green_hue = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(channels.blue, channels.red), inverse_delta), two);
+		const __m128 blue_hue = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(channels.red, channels.green), inverse_delta), _mm_set1_ps(4.0f));
+
+		hue = select(_mm_cmpeq_ps(c_max, channels.red), red_hue, select(_mm_cmpeq_ps(c_max, channels.green), green_hue, blue_hue));
+		hue = _mm_and_ps(chromatic, _mm_mul_ps(hue, _mm_set1_ps(60.0f)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Converts four HSL colours to RGB with the same steps as HSLColour::to_rgba
+	void hsl_to_channels(const __m128 hue, const __m128 saturation, const __m128 luminance, PixelChannels& channels)
+	{
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 twelve = _mm_set1_ps(12.0f);
+
+		const __m128 H = _mm_max_ps(_mm_min_ps(hue, _mm_set1_ps(360.0f)), zero);
+		const __m128 S = _mm_max_ps(_mm_min_ps(saturation, one), zero);
+		const __m128 L = _mm_max_ps(_mm_min_ps(luminance, one), zero);
+
+		const __m128 A = _mm_mul_ps(S, _mm_min_ps(L, _mm_sub_ps(one, L)));
+		const __m128 sector = _mm_mul_ps(H, _mm_set1_ps(1.0f / 30.0f));
+		const auto channel = [&](const float offset)
+		{
+			__m128 k = _mm_add_ps(_mm_set1_ps(offset), sector);
+			k = _mm_sub_ps(k, _mm_and_ps(_mm_cmpge_ps(k, twelve), twelve));
+
+			const __m128 ramp = _mm_min_ps(_mm_min_ps(_mm_sub_ps(k, _mm_set1_ps(3.0f)), _mm_sub_ps(_mm_set1_ps(9.0f), k)), one);
+			return _mm_sub_ps(L, _mm_mul_ps(A, _mm_max_ps(ramp, _mm_set1_ps(-1.0f))));
+		};
+
+		channels.red = channel(0.0f);
+		channels.green = channel(8.0f);
+		channels.blue = channel(4.0f);
+	}
+
+#endif
+
+	//-------------------------------------------------------------------------------------
+
+	void premultiply_colours(Colour* dst, const unsigned count)
+	{
+		unsigned i = 0;
+
+#if defined(CBN_SSE2)
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i rounding = _mm_set1_epi16(128);
+		const __m128i colour_mask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+		const __m128i alpha_factor = _mm_setr_epi16(0, 0, 0, 255, 0, 0, 0, 255);
+		const __m128i opaque = _mm_set1_epi32(static_cast<int>(0xFF000000));
+
+		// Each colour channel is multiplied by the alpha of its pixel, while the 
+		// alpha is multiplied by 255 so that it is unchanged by the division.
+		const auto multiply = [&](const __m128i channels)
+		{
+			const __m128i alphas = _mm_shufflehi_epi16(_mm_shufflelo_epi16(channels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+			const __m128i factor = _mm_or_si128(_mm_and_si128(alphas, colour_mask), alpha_factor);
+
+			__m128i product = _mm_add_epi16(_mm_mullo_epi16(channels, factor), rounding);
+			return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+		};
+
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+
+			// Opaque pixels are unchanged, which covers most of a typical sprite
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(_mm_and_si128(pixels, opaque), opaque)) == 0xFFFF)
+				continue;
+
+			const __m128i low = multiply(_mm_unpacklo_epi8(pixels, zero));
+			const __m128i high = multiply(_mm_unpackhi_epi8(pixels, zero));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_packus_epi16(low, high));
+		}
+#endif
+
+		for(; i < count; i++)
+		{
+			const unsigned alpha = dst[i].alpha;
+			dst[i] = Colour(div_255(dst[i].red * alpha), div_255(dst[i].green * alpha), div_255(dst[i].blue * alpha), dst[i].alpha);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void unpremultiply_colours(Colour* dst, const unsigned count)
+	{
+		unsigned i = 0;
+
+#if defined(CBN_SSE2)
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 maximum = _mm_set1_ps(255.0f);
+
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+			const __m128i alpha = _mm_srli_epi32(pixels, 24);
+			const __m128 alpha_float = _mm_cvtepi32_ps(alpha);
+
+			// Transparent pixels have no colour to recover, so they become transparent black
+			const __m128 visible = _mm_cmpgt_ps(alpha_float, zero);
+			const __m128 scale = _mm_and_ps(visible, _mm_div_ps(maximum, select(visible, alpha_float, maximum)));
+
+			const __m128i mask = _mm_set1_epi32(0xFF);
+			const auto channel = [&](const int shift)
+			{
+				const __m128 value = _mm_cvtepi32_ps(_mm_and_si128(_mm_srli_epi32(pixels, shift), mask));
+				return _mm_slli_epi32(_mm_cvtps_epi32(_mm_min_ps(_mm_mul_ps(value, scale), maximum)), shift);
+			};
+
+			const __m128i result = _mm_or_si128(
+				_mm_or_si128(channel(0), channel(8)),
+				_mm_or_si128(channel(16), _mm_slli_epi32(alpha, 24))
+			);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+		}
+#endif
+
+		for(; i < count; i++)
+		{
+			if(dst[i].alpha == 0)
+			{
+				dst[i] = Colour(0, 0, 0, 0);
+				continue;
+			}
+
+			const float scale = 255.0f / dst[i].alpha;
+			const auto channel = [&](const uint8_t value)
+			{
+				return static_cast<uint8_t>(std::lrint(std::min(value * scale, 255.0f)));
+			};
+			dst[i] = Colour(channel(dst[i].red), channel(dst[i].green), channel(dst[i].blue), dst[i].alpha);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Rotates the hue of the colours by the given number of degrees, which must be within [0, 360)
+	void rotate_hue_row(Colour* dst, const float degrees, const unsigned count)
+	{
+		unsigned i = 0;
+
+#if defined(CBN_SSE2)
+		const __m128 rotation = _mm_set1_ps(degrees);
+		const __m128 full_turn = _mm_set1_ps(360.0f);
+
+		for(; i + 4 <= count; i += 4)
+		{
+			PixelChannels channels = load_channels(dst + i);
+
+			__m128 hue, saturation, luminance;
+			channels_to_hsl(channels, hue, saturation, luminance);
+
+			hue = _mm_add_ps(hue, rotation);
+			hue = _mm_sub_ps(hue, _mm_and_ps(_mm_cmpge_ps(hue, full_turn), full_turn));
+
+			hsl_to_channels(hue, saturation, luminance, channels);
+			store_channels(dst + i, channels);
+		}
+#endif
+
+		for(; i < count; i++)
+		{
+			HSLColour hsl = dst[i].to_hsl();
+			hsl.hue += degrees;
+			if(hsl.hue >= 360.0f)
+				hsl.hue -= 360.0f;
+
+			Colour rotated = hsl.to_rgba();
+			rotated.alpha = dst[i].alpha;
+			dst[i] = rotated;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Finds the squared distance from each sample to the nearest seed in a single row or column,
+	// given the squared distance of each sample to its own seed, which is zero for the seeds 
+	// themselves. The lower envelope of the parabolas rooted at each sample is traced in linear 
+	// time, as described by Felzenszwalb and Huttenlocher. The envelope buffers must have room
+	// for count + 1 values, and the distances are transformed in place, stride floats apart.
+	void distance_transform(float* distances, const unsigned count, const unsigned stride, float* seeds, int* roots, float* boundaries)
+	{
+		bool uniform = true;
+		for(unsigned i = 0; i < count; i++)
+		{
+			seeds[i] = distances[static_cast<size_t>(i) * stride];
+			uniform &= seeds[i] == seeds[0];
+		}
+
+		// Every sample is nearest to itself when they are all the same, which is
+		// common in the empty margins around sprites, so there is nothing to do. 
+		if(uniform)
+			return;
+
+		int k = 0;
+		roots[0] = 0;
+		boundaries[0] = -std::numeric_limits<float>::infinity();
+		boundaries[1] = std::numeric_limits<float>::infinity();
+
+		for(int q = 1; q < static_cast<int>(count); q++)
+		{
+			// Parabolas which are entirely above the new one are removed from the envelope
+			float intersection;
+			while(true)
+			{
+				const int r = roots[k];
+				const float q_float = static_cast<float>(q), r_float = static_cast<float>(r);
+				intersection = ((seeds[q] + q_float * q_float) - (seeds[r] + r_float * r_float)) / (2.0f * (q_float - r_float));
+				if(intersection > boundaries[k])
+					break;
+				k--;
+			}
+
+			k++;
+			roots[k] = q;
+			boundaries[k] = intersection;
+			boundaries[k + 1] = std::numeric_limits<float>::infinity();
+		}
+
+		k = 0;
+		for(int q = 0; q < static_cast<int>(count); q++)
+		{
+			while(boundaries[k + 1] < q)
+				k++;
+
+			const float offset = static_cast<float>(q - roots[k]);
+			distances[static_cast<size_t>(q) * stride] = offset * offset + seeds[roots[k]];
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void parallel_rows(const unsigned rows, const unsigned thread_count, const std::function<void(const unsigned, const unsigned)>& process)
+	{
+		// Small images are not worth the cost of starting threads
+		const unsigned hardware_threads = std::max(std::thread::hardware_concurrency(), 1u);
+		const unsigned max_threads = std::max(rows / c_MinParallelRows, 1u);
+		const unsigned threads = std::min(thread_count == 0 ? hardware_threads : thread_count, max_threads);
+		const unsigned rows_per_thread = (rows + threads - 1) / threads;
+
+		// The calling thread also processes rows, rather than waiting idle on the others
+		std::vector<std::thread> workers;
+		for(unsigned t = 1; t < threads; t++)
+		{
+			const unsigned begin = t * rows_per_thread;
+			const unsigned end = std::min(begin + rows_per_thread, rows);
+			if(begin < end)
+				workers.emplace_back(process, begin, end);
+		}
+		process(0, std::min(rows_per_thread, rows));
+
+		for(auto& worker : workers)
+			worker.join();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void copy_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height)
+	{
+		// If both blocks are contiguous, they can be copied all at once
+		if(dst_stride == width && src_stride == width)
+		{
+			std::memcpy(static_cast<void*>(dst), src, static_cast<size_t>(width) * height * sizeof(Colour));
+			return;
+		}
+
+		for(unsigned y = 0; y < height; y++)
+		{
+			std::memcpy(
+				static_cast<void*>(dst + static_cast<size_t>(y) * dst_stride),
+				src + static_cast<size_t>(y) * src_stride,
+				width * sizeof(Colour)
+			);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void transpose_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height)
+	{
+		for(unsigned y = 0; y < height; y += c_TransposeBlock)
+		{
+			const unsigned block_height = std::min(c_TransposeBlock, height - y);
+			for(unsigned x = 0; x < width; x += c_TransposeBlock)
+			{
+				const unsigned block_width = std::min(c_TransposeBlock, width - x);
+				transpose_block(
+					dst + static_cast<size_t>(x) * dst_stride + y, dst_stride,
+					src + static_cast<size_t>(y) * src_stride + x, src_stride,
+					block_width, block_height
+				);
+			}
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void fill_pixels(Colour* dst, const unsigned dst_stride, const Colour colour, const unsigned width, const unsigned height)
+	{
+		if(dst_stride == width)
+		{
+			fill_row(dst, colour, static_cast<size_t>(width) * height);
+			return;
+		}
+
+		for(unsigned y = 0; y < height; y++)
+			fill_row(dst + static_cast<size_t>(y) * dst_stride, colour, width);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void blend_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height)
+	{
+		for(unsigned y = 0; y < height; y++)
+			blend_row(dst + static_cast<size_t>(y) * dst_stride, src + static_cast<size_t>(y) * src_stride, width);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void tint_pixels(Colour* dst, const unsigned dst_stride, const Colour tint, const unsigned width, const unsigned height)
+	{
+		for(unsigned y = 0; y < height; y++)
+			tint_row(dst + static_cast<size_t>(y) * dst_stride, tint, width);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void downsample_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height)
+	{
+		const unsigned half_width = std::max(width / 2, 1u);
+		const unsigned half_height = std::max(height / 2, 1u);
+
+		for(unsigned y = 0; y < half_height; y++)
+		{
+			const unsigned y_0 = std::min(y * 2, height - 1);
+			const unsigned y_1 = std::min(y * 2 + 1, height - 1);
+
+			downsample_row(
+				dst + static_cast<size_t>(y) * dst_stride,
+				src + static_cast<size_t>(y_0) * src_stride,
+				src + static_cast<size_t>(y_1) * src_stride,
+				width, half_width
+			);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void resample_pixels(Colour* dst, const unsigned dst_stride, const unsigned dst_width, const unsigned dst_height, const Colour* src, const unsigned src_stride, const unsigned src_width, const unsigned src_height, const ResampleFilter filter, const unsigned thread_count)
+	{
+		if(dst_width == 0 || dst_height == 0 || src_width == 0 || src_height == 0)
+			return;
+
+		const ResampleWeights horizontal = resample_weights(src_width, dst_width, filter);
+		const ResampleWeights vertical = resample_weights(src_height, dst_height, filter);
+
+		// The horizontal pass filters every source row into an intermediate image which 
+		// is as wide as the destination, with the channels held as premultiplied floats. 
+		const size_t intermediate_stride = static_cast<size_t>(dst_width) * 4;
+		std::vector<float> intermediate(intermediate_stride * src_height);
+		parallel_rows(src_height, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			std::vector<float> row(static_cast<size_t>(src_width) * 4);
+			for(unsigned y = begin; y < end; y++)
+			{
+				premultiply_row(row.data(), src + static_cast<size_t>(y) * src_stride, src_width);
+				filter_row(intermediate.data() + y * intermediate_stride, row.data(), horizontal);
+			}
+		});
+
+		// The vertical pass then sums whole rows of the intermediate image at a time
+		parallel_rows(dst_height, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			std::vector<float> row(intermediate_stride);
+			for(unsigned y = begin; y < end; y++)
+			{
+				std::fill(row.begin(), row.end(), 0.0f);
+
+				const float* weights = vertical.weights.data() + static_cast<size_t>(y) * vertical.slots;
+				for(unsigned k = 0; k < vertical.count[y]; k++)
+				{
+					const float* source_row = intermediate.data() + (vertical.first[y] + k) * intermediate_stride;
+					accumulate_row(row.data(), source_row, weights[k], intermediate_stride);
+				}
+
+				unpremultiply_row(dst + static_cast<size_t>(y) * dst_stride, row.data(), dst_width);
+			}
+		});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void rgba_to_hsl(std::span<const Colour> src, std::span<HSLColour> dst)
+	{
+		CBN_Assert(src.size() == dst.size(), "The spans must be the same length");
+
+		size_t i = 0;
+
+#if defined(CBN_SSE2)
+		alignas(16) float hues[4], saturations[4], luminances[4];
+		for(; i + 4 <= src.size(); i += 4)
+		{
+			__m128 hue, saturation, luminance;
+			channels_to_hsl(load_channels(src.data() + i), hue, saturation, luminance);
+
+			_mm_store_ps(hues, hue);
+			_mm_store_ps(saturations, saturation);
+			_mm_store_ps(luminances, luminance);
+			for(size_t j = 0; j < 4; j++)
+				dst[i + j] = {hues[j], saturations[j], luminances[j]};
+		}
+#endif
+
+		for(; i < src.size(); i++)
+			dst[i] = src[i].to_hsl();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void hsl_to_rgba(std::span<const HSLColour> src, std::span<Colour> dst)
+	{
+		CBN_Assert(src.size() == dst.size(), "The spans must be the same length");
+
+		size_t i = 0;
+
+#if defined(CBN_SSE2)
+		PixelChannels channels;
+		channels.alpha = _mm_set1_epi32(255);
+		for(; i + 4 <= src.size(); i += 4)
+		{
+			const HSLColour* hsl = src.data() + i;
+			const __m128 hue = _mm_setr_ps(hsl[0].hue, hsl[1].hue, hsl[2].hue, hsl[3].hue);
+			const __m128 saturation = _mm_setr_ps(hsl[0].saturation, hsl[1].saturation, hsl[2].saturation, hsl[3].saturation);
+			const __m128 luminance = _mm_setr_ps(hsl[0].luminance, hsl[1].luminance, hsl[2].luminance, hsl[3].luminance);
+
+			hsl_to_channels(hue, saturation, luminance, channels);
+			store_channels(dst.data() + i, channels);
+		}
+#endif
+
+		for(; i < src.size(); i++)
+			dst[i] = src[i].to_rgba();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void srgb_to_linear(std::span<const Colour> src, std::span<glm::vec4> dst)
+	{
+		CBN_Assert(src.size() == dst.size(), "The spans must be the same length");
+
+		const SRGBTables& tables = srgb_tables();
+		for(size_t i = 0; i < src.size(); i++)
+		{
+			dst[i] = {
+				tables.decode[src[i].red],
+				tables.decode[src[i].green],
+				tables.decode[src[i].blue],
+				src[i].alpha * (1.0f / 255.0f)
+			};
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void linear_to_srgb(std::span<const glm::vec4> src, std::span<Colour> dst)
+	{
+		CBN_Assert(src.size() == dst.size(), "The spans must be the same length");
+
+		const SRGBTables& tables = srgb_tables();
+		for(size_t i = 0; i < src.size(); i++)
+		{
+			dst[i] = Colour(
+				encode_srgb(tables, src[i].x),
+				encode_srgb(tables, src[i].y),
+				encode_srgb(tables, src[i].z),
+				static_cast<uint8_t>(std::lrint(std::clamp(src[i].w, 0.0f, 1.0f) * 255.0f))
+			);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void premultiply_pixels(Colour* dst, const unsigned dst_stride, const unsigned width, const unsigned height, const unsigned thread_count)
+	{
+		parallel_rows(height, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			for(unsigned y = begin; y < end; y++)
+				premultiply_colours(dst + static_cast<size_t>(y) * dst_stride, width);
+		});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void unpremultiply_pixels(Colour* dst, const unsigned dst_stride, const unsigned width, const unsigned height, const unsigned thread_count)
+	{
+		parallel_rows(height, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			for(unsigned y = begin; y < end; y++)
+				unpremultiply_colours(dst + static_cast<size_t>(y) * dst_stride, width);
+		});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void rotate_hue_pixels(Colour* dst, const unsigned dst_stride, const unsigned width, const unsigned height, const float degrees, const unsigned thread_count)
+	{
+		float rotation = std::fmod(degrees, 360.0f);
+		if(rotation < 0.0f)
+			rotation += 360.0f;
+
+		parallel_rows(height, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			for(unsigned y = begin; y < end; y++)
+				rotate_hue_row(dst + static_cast<size_t>(y) * dst_stride, rotation, width);
+		});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void distance_field_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height, const float spread, const unsigned downscale, const unsigned thread_count)
+	{
+		// Two fields of squared distances are found at once, the distance to the nearest
+		// pixel inside the shape and the distance to the nearest pixel outside of it.
+		const size_t size = static_cast<size_t>(width) * height;
+		std::vector<float> to_inside(size), to_outside(size);
+
+		// The rows are transformed first, seeded from the alpha of the source
+		parallel_rows(height, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			std::vector<float> seeds(width), boundaries(width + 1);
+			std::vector<int> roots(width);
+			for(unsigned y = begin; y < end; y++)
+			{
+				const Colour* row = src + static_cast<size_t>(y) * src_stride;
+				float* inside_row = to_inside.data() + static_cast<size_t>(y) * width;
+				float* outside_row = to_outside.data() + static_cast<size_t>(y) * width;
+				for(unsigned x = 0; x < width; x++)
+				{
+					const bool inside = row[x].alpha >= 128;
+					inside_row[x] = inside ? 0.0f : c_DistanceFar;
+					outside_row[x] = inside ? c_DistanceFar : 0.0f;
+				}
+
+				distance_transform(inside_row, width, 1, seeds.data(), roots.data(), boundaries.data());
+				distance_transform(outside_row, width, 1, seeds.data(), roots.data(), boundaries.data());
+			}
+		});
+
+		// Then the columns, which are copied out in groups so that each row is read a cache line 
+		// at a time. Combining the passes gives the exact Euclidean distance to the nearest seed.
+		const unsigned groups = (width + c_DistanceColumns - 1) / c_DistanceColumns;
+		parallel_rows(groups, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			std::vector<float> columns(static_cast<size_t>(height) * c_DistanceColumns);
+			std::vector<float> seeds(height), boundaries(height + 1);
+			std::vector<int> roots(height);
+			for(unsigned group = begin; group < end; group++)
+			{
+				const unsigned x_begin = group * c_DistanceColumns;
+				const unsigned group_width = std::min(c_DistanceColumns, width - x_begin);
+				for(float* field : {to_inside.data(), to_outside.data()})
+				{
+					for(unsigned y = 0; y < height; y++)
+						std::copy_n(field + static_cast<size_t>(y) * width + x_begin, group_width, columns.data() + y * c_DistanceColumns);
+
+					for(unsigned c = 0; c < group_width; c++)
+						distance_transform(columns.data() + c, height, c_DistanceColumns, seeds.data(), roots.data(), boundaries.data());
+
+					for(unsigned y = 0; y < height; y++)
+						std::copy_n(columns.data() + y * c_DistanceColumns, group_width, field + static_cast<size_t>(y) * width + x_begin);
+				}
+			}
+		});
+
+		// Distances are measured between pixel centres, so the edge of the shape is half
+		// a pixel from the centres on either side of it. The alpha reaches its limits at 
+		// the spread, and is half way between them at the edge. 
+		const unsigned dst_width = (width + downscale - 1) / downscale;
+		const unsigned dst_height = (height + downscale - 1) / downscale;
+		const float scale = 0.5f / spread;
+		parallel_rows(dst_height, thread_count, [&](const unsigned begin, const unsigned end)
+		{
+			for(unsigned y = begin; y < end; y++)
+			{
+				Colour* dst_row = dst + static_cast<size_t>(y) * dst_stride;
+				const unsigned y_end = std::min((y + 1) * downscale, height);
+				for(unsigned x = 0; x < dst_width; x++)
+				{
+					const unsigned x_end = std::min((x + 1) * downscale, width);
+
+					float total = 0.0f;
+					for(unsigned sy = y * downscale; sy < y_end; sy++)
+					{
+						for(unsigned sx = x * downscale; sx < x_end; sx++)
+						{
+							const size_t i = static_cast<size_t>(sy) * width + sx;
+							total += to_inside[i] == 0.0f ? std::sqrt(to_outside[i]) - 0.5f : 0.5f - std::sqrt(to_inside[i]);
+						}
+					}
+
+					const float distance = total / static_cast<float>((y_end - y * downscale) * (x_end - x * downscale));
+					const float alpha = std::clamp(0.5f + distance * scale, 0.0f, 1.0f);
+					dst_row[x] = Colour(255, 255, 255, static_cast<uint8_t>(std::lrint(alpha * 255.0f)));
+				}
+			}
+		});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <functional>
+#include <stdint.h>
+#include <span>
+
+#include <glm/glm.hpp>
+
+#include "../../Utility/Colour.hpp"
+
+namespace cbn
+{
+
+	enum class ResampleFilter
+	{
+		BOX,
+		BILINEAR,
+		LANCZOS
+	};
+
+	// Bulk pixel operations over rectangular blocks of RGBA pixels. Each block is addressed by
+	// a pointer to its first pixel and a stride, which is the number of pixels between the start
+	// of consecutive rows, so the kernels work on sub-regions of larger images. The blocks must
+	// not overlap. SSE2 and AVX2 paths are used when the target supports them, with scalar
+	// fallbacks otherwise.
+
+	void copy_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height);
+
+	// Writes the transpose of the width x height source block, so that dst(x, y) = src(y, x)
+	// and the destination block is height pixels wide and width pixels tall.
+	void transpose_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height);
+
+	void fill_pixels(Colour* dst, const unsigned dst_stride, const Colour colour, const unsigned width, const unsigned height);
+
+	// Composites the source block over the destination block with the source-over operator,
+	// treating both as having straight (non-premultiplied) alpha.
+	void blend_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height);
+
+	// Multiplies every channel of the block by the matching channel of the tint colour.
+	void tint_pixels(Colour* dst, const unsigned dst_stride, const Colour tint, const unsigned width, const unsigned height);
+
+	// Halves the width x height source block with a 2x2 box filter. Colours are weighted by their
+	// alpha, so that transparent pixels do not bleed into their neighbours. If a dimension is odd,
+	// the last row or column is clamped. The destination is max(width / 2, 1) pixels wide and 
+	// max(height / 2, 1) pixels tall.
+	void downsample_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height);
+
+	// Resamples the source block to the size of the destination block with a separable filter, 
+	// which is applied in premultiplied alpha. The rows of each pass are split across the given 
+	// number of threads, or one per hardware thread if it is zero.
+	void resample_pixels(Colour* dst, const unsigned dst_stride, const unsigned dst_width, const unsigned dst_height, const Colour* src, const unsigned src_stride, const unsigned src_width, const unsigned src_height, const ResampleFilter filter, const unsigned thread_count = 0);
+
+	// Converts spans of colours between colour spaces, where both spans must be the same length. 
+	// The HSL conversions match Colour::to_hsl and HSLColour::to_rgba exactly, with converted RGB 
+	// colours being opaque. Linear colours are held as floats, as 8 bits are not enough to hold 
+	// dark linear colours without banding. Alpha is never transformed, only rescaled. 
+
+	void rgba_to_hsl(std::span<const Colour> src, std::span<HSLColour> dst);
+
+	void hsl_to_rgba(std::span<const HSLColour> src, std::span<Colour> dst);
+
+	void srgb_to_linear(std::span<const Colour> src, std::span<glm::vec4> dst);
+
+	void linear_to_srgb(std::span<const glm::vec4> src, std::span<Colour> dst);
+
+	// Converts the block between straight and premultiplied alpha in place. Fully transparent 
+	// pixels have no colour to recover, so unpremultiplying them gives transparent black.
+	// The rows are split across the given number of threads, or one per hardware thread if 
+	// it is zero. 
+
+	void premultiply_pixels(Colour* dst, const unsigned dst_stride, const unsigned width, const unsigned height, const unsigned thread_count = 0);
+
+	void unpremultiply_pixels(Colour* dst, const unsigned dst_stride, const unsigned width, const unsigned height, const unsigned thread_count = 0);
+
+	// Rotates the hue of every pixel in the block by the given number of degrees in HSL space,
+	// keeping its alpha. The rows are split across threads as above.
+	void rotate_hue_pixels(Colour* dst, const unsigned dst_stride, const unsigned width, const unsigned height, const float degrees, const unsigned thread_count = 0);
+
+	// Computes a signed distance field from the alpha of the source block, where pixels with an
+	// alpha of at least 128 are inside the shape. Exact Euclidean distances are found in linear
+	// time by transforming the rows and then the columns, with each pass split across threads
+	// as above. Each destination pixel averages the distances of a downscale x downscale block
+	// of source pixels, and is written as white with the distance in its alpha so that it can
+	// be packed and tinted like any other sprite. The edge of the shape has an alpha of one half,
+	// which falls to zero outside and rises to one inside at spread source pixels from the edge.
+	// The destination is ceil(width / downscale) by ceil(height / downscale) pixels.
+	void distance_field_pixels(Colour* dst, const unsigned dst_stride, const Colour* src, const unsigned src_stride, const unsigned width, const unsigned height, const float spread, const unsigned downscale = 1, const unsigned thread_count = 0);
+
+	// Splits rows of work across the given number of threads, or one per hardware thread if it
+	// is zero, calling the process function with the begin and end row of each thread. Small
+	// jobs are not worth starting threads for, so they are processed on the calling thread.
+	void parallel_rows(const unsigned rows, const unsigned thread_count, const std::function<void(const unsigned, const unsigned)>& process);
+
+}
\ No newline at end of file
@@ -0,0 +1,108 @@
+#include "ImageView.hpp"
+
+#include "../../Diagnostics/Assert.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	ImageView::ImageView()
+		: m_Data(nullptr),
+		m_Resolution(0, 0),
+		m_Stride(0)
+	{}
+
+	//-------------------------------------------------------------------------------------
+
+	ImageView::ImageView(const Colour* data, const unsigned width, const unsigned height, const unsigned stride)
+		: m_Data(data),
+		m_Resolution(width, height),
+		m_Stride(stride)
+	{
+		CBN_Assert(stride >= width, "Stride must be at least as large as the width");
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	ImageView ImageView::subview(const unsigned x, const unsigned y, const unsigned width, const unsigned height) const
+	{
+		CBN_Assert(x + width <= m_Resolution.x && y + height <= m_Resolution.y, "Sub-view is outside of the view");
+
+		return ImageView(m_Data + static_cast<uint64_t>(y) * m_Stride + x, width, height, m_Stride);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	Colour ImageView::get_pixel(const unsigned x, const unsigned y) const
+	{
+		CBN_Assert(x < m_Resolution.x && y < m_Resolution.y, "Coordinate out of bounds");
+
+		return row(y)[x];
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const Colour* ImageView::row(const unsigned y) const
+	{
+		return m_Data + static_cast<uint64_t>(y) * m_Stride;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const Colour* ImageView::data() const
+	{
+		return m_Data;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const unsigned ImageView::width() const
+	{
+		return m_Resolution.x;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const unsigned ImageView::height() const
+	{
+		return m_Resolution.y;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	glm::uvec2 ImageView::resolution() const
+	{
+		return m_Resolution;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	unsigned ImageView::stride() const
+	{
+		return m_Stride;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	unsigned ImageView::size() const
+	{
+		return m_Resolution.x * m_Resolution.y;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool ImageView::is_contiguous() const
+	{
+		return m_Stride == m_Resolution.x || m_Resolution.y <= 1;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool ImageView::is_empty() const
+	{
+		return m_Resolution.x == 0 || m_Resolution.y == 0;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
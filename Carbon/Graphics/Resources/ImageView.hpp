@@ -0,0 +1,53 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+
+#include "../../Utility/Colour.hpp"
+
+namespace cbn
+{
+
+	// A non-owning view of a rectangular region of pixels within an image. The stride is the 
+	// number of pixels between the start of consecutive rows, so a view of a sub-region keeps 
+	// the stride of the whole image. Views do not keep the pixels alive, so they must not 
+	// outlive the image that they were taken from. 
+	class ImageView
+	{
+	private:
+
+		const Colour* m_Data;
+		glm::uvec2 m_Resolution;
+		unsigned m_Stride;
+
+	public:
+
+		ImageView();
+
+		ImageView(const Colour* data, const unsigned width, const unsigned height, const unsigned stride);
+
+		ImageView subview(const unsigned x, const unsigned y, const unsigned width, const unsigned height) const;
+
+		Colour get_pixel(const unsigned x, const unsigned y) const;
+
+		const Colour* row(const unsigned y) const;
+
+		const Colour* data() const;
+
+		const unsigned width() const;
+
+		const unsigned height() const;
+
+		glm::uvec2 resolution() const;
+
+		unsigned stride() const;
+
+		unsigned size() const;
+
+		bool is_contiguous() const;
+
+		bool is_empty() const;
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "IndexedImage.hpp"
+
+#include <unordered_map>
+#include <algorithm>
+#include <limits>
+#include <array>
+
+#include "../../Diagnostics/Assert.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	struct ColourCount
+	{
+		Colour colour;
+		uint64_t count;
+	};
+
+	// A range of colours for median cut, along with the channel they are most spread out in
+	struct ColourBox
+	{
+		unsigned begin, end;
+		unsigned channel;
+		int range;
+	};
+
+	//-------------------------------------------------------------------------------------
+
+	uint8_t channel_value(const Colour colour, const unsigned channel)
+	{
+		switch(channel)
+		{
+			case 0: return colour.red;
+			case 1: return colour.green;
+			case 2: return colour.blue;
+			default: return colour.alpha;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Counts the pixels of each colour in the order that the colours first appear, and fills 
+	// the lookup with the position of each colour in the returned counts. 
+	std::vector<ColourCount> count_colours(const ImageView& image, std::unordered_map<uint32_t, unsigned>& lookup)
+	{
+		std::vector<ColourCount> colours;
+		for(unsigned y = 0; y < image.height(); y++)
+		{
+			const Colour* row = image.row(y);
+
+			// Sprites are made of runs of the same colour, so each run is only looked up once
+			for(unsigned x = 0; x < image.width();)
+			{
+				const uint32_t colour = row[x].hex;
+				const unsigned start = x;
+				while(x < image.width() && row[x].hex == colour)
+					x++;
+
+				const auto [entry, inserted] = lookup.try_emplace(colour, static_cast<unsigned>(colours.size()));
+				if(inserted)
+					colours.push_back({row[start], 0});
+
+				colours[entry->second].count += x - start;
+			}
+		}
+		return colours;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::vector<uint8_t> map_pixels(const ImageView& image, const std::unordered_map<uint32_t, unsigned>& lookup)
+	{
+		std::vector<uint8_t> indices(static_cast<size_t>(image.width()) * image.height());
+
+		uint8_t* output = indices.data();
+		for(unsigned y = 0; y < image.height(); y++)
+		{
+			const Colour* row = image.row(y);
+			for(unsigned x = 0; x < image.width();)
+			{
+				const uint32_t colour = row[x].hex;
+				const uint8_t index = static_cast<uint8_t>(lookup.at(colour));
+				while(x < image.width() && row[x].hex == colour)
+				{
+					*output++ = index;
+					x++;
+				}
+			}
+		}
+		return indices;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	ColourBox make_box(const std::vector<ColourCount>& colours, const unsigned begin, const unsigned end)
+	{
+		std::array<int, 4> minimum = {255, 255, 255, 255}, maximum = {0, 0, 0, 0};
+		for(unsigned i = begin; i < end; i++)
+		{
+			for(unsigned c = 0; c < 4; c++)
+			{
+				minimum[c] = std::min<int>(minimum[c], channel_value(colours[i].colour, c));
+				maximum[c] = std::max<int>(maximum[c], channel_value(colours[i].colour, c));
+			}
+		}
+
+		ColourBox box = {begin, end, 0, maximum[0] - minimum[0]};
+		for(unsigned c = 1; c < 4; c++)
+		{
+			if(maximum[c] - minimum[c] > box.range)
+			{
+				box.channel = c;
+				box.range = maximum[c] - minimum[c];
+			}
+		}
+		return box;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Splits the colours into boxes by repeatedly cutting the widest box at its median pixel,
+	// then averages each box into a palette colour. The lookup is updated to map each colour
+	// to the palette colour of its box. 
+	Palette median_cut(std::vector<ColourCount>& colours, const unsigned max_colours, std::unordered_map<uint32_t, unsigned>& lookup)
+	{
+		std::vector<ColourBox> boxes = {make_box(colours, 0, static_cast<unsigned>(colours.size()))};
+		while(boxes.size() < max_colours)
+		{
+			// A box with no range only holds a single colour, so if the widest 
+			// box has no range then every colour already has its own box. 
+			const auto widest = std::max_element(boxes.begin(), boxes.end(), [](const ColourBox& a, const ColourBox& b){
+				return a.range < b.range;
+			});
+			if(widest->range == 0)
+				break;
+
+			const ColourBox box = *widest;
+			std::sort(colours.begin() + box.begin, colours.begin() + box.end, [&](const ColourCount& a, const ColourCount& b){
+				return channel_value(a.colour, box.channel) < channel_value(b.colour, box.channel);
+			});
+
+			uint64_t total = 0;
+			for(unsigned i = box.begin; i < box.end; i++)
+				total += colours[i].count;
+
+			// Both halves must keep at least one colour
+			unsigned split = box.begin + 1;
+			for(uint64_t count = colours[box.begin].count; split < box.end - 1 && count * 2 < total; split++)
+				count += colours[split].count;
+
+			*widest = make_box(colours, box.begin, split);
+			boxes.push_back(make_box(colours, split, box.end));
+		}
+
+		Palette palette;
+		for(const ColourBox& box : boxes)
+		{
+			std::array<uint64_t, 4> sums = {0, 0, 0, 0};
+			uint64_t total = 0;
+			for(unsigned i = box.begin; i < box.end; i++)
+			{
+				for(unsigned c = 0; c < 4; c++)
+					sums[c] += channel_value(colours[i].colour, c) * colours[i].count;
+
+				total += colours[i].count;
+				lookup[colours[i].colour.hex] = static_cast<unsigned>(palette.size());
+			}
+
+			const auto average = [&](const unsigned c){
+				return static_cast<uint8_t>((sums[c] + total / 2) / total);
+			};
+			palette.emplace_back(average(0), average(1), average(2), average(3));
+		}
+		return palette;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	unsigned nearest_colour(const Palette& palette, const Colour colour)
+	{
+		unsigned nearest = 0, nearest_distance = std::numeric_limits<unsigned>::max();
+		for(unsigned i = 0; i < palette.size(); i++)
+		{
+			unsigned distance = 0;
+			for(unsigned c = 0; c < 4; c++)
+			{
+				const int difference = channel_value(palette[i], c) - channel_value(colour, c);
+				distance += difference * difference;
+			}
+
+			if(distance < nearest_distance)
+			{
+				nearest = i;
+				nearest_distance = distance;
+			}
+		}
+		return nearest;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<IndexedImage> IndexedImage::Quantize(const ImageView& image, const unsigned max_colours)
+	{
+		if(image.is_empty() || max_colours == 0 || max_colours > MaxColours)
+			return nullptr;
+
+		std::unordered_map<uint32_t, unsigned> lookup;
+		std::vector<ColourCount> colours = count_colours(image, lookup);
+
+		Palette palette;
+		if(colours.size() <= max_colours)
+		{
+			// The counts are already in palette order
+			for(const ColourCount& entry : colours)
+				palette.push_back(entry.colour);
+		}
+		else
+		{
+			// Fully transparent colours all look the same, so they are merged 
+			// into one colour to avoid wasting palette entries on them. 
+			std::vector<ColourCount> visible;
+			ColourCount transparent = {Colour(0, 0, 0, 0), 0};
+			for(const ColourCount& entry : colours)
+			{
+				if(entry.colour.alpha == 0)
+					transparent.count += entry.count;
+				else
+					visible.push_back(entry);
+			}
+
+			if(transparent.count > 0)
+				visible.push_back(transparent);
+
+			palette = median_cut(visible, max_colours, lookup);
+
+			if(transparent.count > 0)
+			{
+				const unsigned transparent_index = lookup.at(transparent.colour.hex);
+				for(auto& [colour, index] : lookup)
+					if(Colour(colour).alpha == 0)
+						index = transparent_index;
+			}
+		}
+
+		return Resource::WrapShared(new IndexedImage(image.width(), image.height(), map_pixels(image, lookup), std::move(palette)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<IndexedImage> IndexedImage::Quantize(const SRes<Image>& image, const unsigned max_colours)
+	{
+		return Quantize(image->view(), max_colours);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<IndexedImage> IndexedImage::Quantize(const ImageView& image, const Palette& palette)
+	{
+		if(image.is_empty() || palette.empty() || palette.size() > MaxColours)
+			return nullptr;
+
+		// Each distinct colour only needs to be matched against the palette once
+		std::unordered_map<uint32_t, unsigned> lookup;
+		count_colours(image, lookup);
+		for(auto& [colour, index] : lookup)
+			index = nearest_colour(palette, Colour(colour));
+
+		return Resource::WrapShared(new IndexedImage(image.width(), image.height(), map_pixels(image, lookup), Palette(palette)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<IndexedImage> IndexedImage::Create(const unsigned width, const unsigned height, const Palette& palette)
+	{
+		if(width == 0 || height == 0 || palette.size() > MaxColours)
+			return nullptr;
+
+		std::vector<uint8_t> indices(static_cast<size_t>(width) * height, 0);
+		return Resource::WrapShared(new IndexedImage(width, height, std::move(indices), Palette(palette)));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	IndexedImage::IndexedImage(const unsigned width, const unsigned height, std::vector<uint8_t>&& indices, Palette&& palette)
+		: m_Indices(std::move(indices)),
+		m_Resolution(width, height),
+		m_Palette(std::move(palette))
+	{}
+
+	//-------------------------------------------------------------------------------------
+
+	void IndexedImage::set_palette(const Palette& palette)
+	{
+		CBN_Assert(palette.size() <= MaxColours, "Palette has too many colours");
+
+		m_Palette = palette;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const Palette& IndexedImage::palette() const
+	{
+		return m_Palette;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void IndexedImage::set_index(const unsigned x, const unsigned y, const uint8_t index)
+	{
+		CBN_Assert(x < width() && y < height(), "Coordinate out of bounds");
+
+		m_Indices[static_cast<size_t>(y) * width() + x] = index;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint8_t IndexedImage::get_index(const unsigned x, const unsigned y) const
+	{
+		CBN_Assert(x < width() && y < height(), "Coordinate out of bounds");
+
+		return m_Indices[static_cast<size_t>(y) * width() + x];
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	Colour IndexedImage::get_pixel(const unsigned x, const unsigned y) const
+	{
+		const uint8_t index = get_index(x, y);
+		return index < m_Palette.size() ? m_Palette[index] : Colour(0, 0, 0, 0);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<Image> IndexedImage::to_image() const
+	{
+		return to_image(m_Palette);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<Image> IndexedImage::to_image(const Palette& palette) const
+	{
+		CBN_Assert(palette.size() <= MaxColours, "Palette has too many colours");
+
+		// Every index is given a colour, so that the lookup never has to check its bounds
+		std::array<Colour, MaxColours> colours;
+		colours.fill(Colour(0, 0, 0, 0));
+		std::copy(palette.begin(), palette.end(), colours.begin());
+
+		std::vector<Colour> pixels(m_Indices.size());
+		for(size_t i = 0; i < m_Indices.size(); i++)
+			pixels[i] = colours[m_Indices[i]];
+
+		return Image::Create(width(), height(), std::move(pixels));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const uint8_t* IndexedImage::data() const
+	{
+		return m_Indices.data();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const unsigned IndexedImage::width() const
+	{
+		return m_Resolution.x;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const unsigned IndexedImage::height() const
+	{
+		return m_Resolution.y;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	glm::uvec2 IndexedImage::resolution() const
+	{
+		return m_Resolution;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t IndexedImage::byte_size() const
+	{
+		return m_Indices.size() + m_Palette.size() * sizeof(Colour);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <glm/glm.hpp>
+#include <stdint.h>
+#include <vector>
+
+#include "../../Memory/Resource.hpp"
+#include "../../Utility/Colour.hpp"
+#include "ImageView.hpp"
+#include "Image.hpp"
+
+namespace cbn
+{
+
+	using Palette = std::vector<Colour>;
+
+	// An image which stores an 8-bit palette index for each pixel instead of its colour, which 
+	// takes a quarter of the memory of an RGBA image. The palette can be replaced at any time
+	// to recolour the image without touching its pixels. Indices outside of the palette are 
+	// treated as transparent.
+	class IndexedImage
+	{
+	public:
+
+		static constexpr unsigned MaxColours = 256;
+
+		// Quantizes the image to a palette of at most the given number of colours. Images which
+		// already use few enough colours are converted exactly, with the palette in the order that
+		// the colours first appear. Otherwise the palette is chosen by median cut, with all fully
+		// transparent pixels sharing a single entry. 
+		static SRes<IndexedImage> Quantize(const ImageView& image, const unsigned max_colours = MaxColours);
+
+		static SRes<IndexedImage> Quantize(const SRes<Image>& image, const unsigned max_colours = MaxColours);
+
+		// Quantizes the image to the given palette, giving each pixel the nearest palette colour.
+		static SRes<IndexedImage> Quantize(const ImageView& image, const Palette& palette);
+
+		static SRes<IndexedImage> Create(const unsigned width, const unsigned height, const Palette& palette);
+
+	private:
+
+		std::vector<uint8_t> m_Indices;
+		glm::uvec2 m_Resolution;
+		Palette m_Palette;
+
+		IndexedImage(const unsigned width, const unsigned height, std::vector<uint8_t>&& indices, Palette&& palette);
+
+	public:
+
+		void set_palette(const Palette& palette);
+
+		const Palette& palette() const;
+
+		void set_index(const unsigned x, const unsigned y, const uint8_t index);
+
+		uint8_t get_index(const unsigned x, const unsigned y) const;
+
+		Colour get_pixel(const unsigned x, const unsigned y) const;
+
+		// Expands the image back to RGBA, using the given palette instead of its own if provided.
+		SRes<Image> to_image() const;
+
+		SRes<Image> to_image(const Palette& palette) const;
+
+		const uint8_t* data() const;
+
+		const unsigned width() const;
+
+		const unsigned height() const;
+
+		glm::uvec2 resolution() const;
+
+		uint64_t byte_size() const;
+
+	};
+
+}
\ No newline at end of file
@@ -0,0 +1,325 @@
+#include "QOI.hpp"
+
+#include <algorithm>
+
+#include "ImageKernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define CBN_SSE2
+#endif
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	constexpr uint8_t c_Magic[4] = {'q', 'o', 'i', 'f'};
+	constexpr uint8_t c_EndMarker[8] = {0, 0, 0, 0, 0, 0, 0, 1};
+	constexpr uint64_t c_MaxPixels = 400'000'000;
+	constexpr unsigned c_MaxRun = 62;
+
+	constexpr uint8_t c_OpIndex = 0x00;
+	constexpr uint8_t c_OpDiff = 0x40;
+	constexpr uint8_t c_OpLuma = 0x80;
+	constexpr uint8_t c_OpRun = 0xC0;
+	constexpr uint8_t c_OpRGB = 0xFE;
+	constexpr uint8_t c_OpRGBA = 0xFF;
+	constexpr uint8_t c_OpMask = 0xC0;
+
+	//-------------------------------------------------------------------------------------
+
+	unsigned qoi_hash(const Colour pixel)
+	{
+		// Computes (red * 3 + green * 5 + blue * 7 + alpha * 11) % 64 with two multiplies, by
+		// spreading the channels into 16-bit lanes. The weighted sum of each pair of channels 
+		// lands in the upper lane, and the products cannot carry into it from the lower lane. 
+		const uint32_t red_blue = pixel.hex & 0x00FF00FF;
+		const uint32_t green_alpha = (pixel.hex >> 8) & 0x00FF00FF;
+		return (((red_blue * 0x00030007) >> 16) + ((green_alpha * 0x0005000B) >> 16)) % 64;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void write_u32_be(uint8_t* output, const uint32_t value)
+	{
+		output[0] = static_cast<uint8_t>(value >> 24);
+		output[1] = static_cast<uint8_t>(value >> 16);
+		output[2] = static_cast<uint8_t>(value >> 8);
+		output[3] = static_cast<uint8_t>(value);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint32_t read_u32_be(const uint8_t* input)
+	{
+		return (static_cast<uint32_t>(input[0]) << 24) | (static_cast<uint32_t>(input[1]) << 16)
+			 | (static_cast<uint32_t>(input[2]) << 8) | static_cast<uint32_t>(input[3]);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	// Counts how many pixels from the start of the given pixels are equal to the colour
+	uint64_t count_repeats(const Colour* pixels, const uint64_t count, const Colour colour)
+	{
+		uint64_t i = 0;
+
+#if defined(CBN_SSE2)
+		const __m128i value = _mm_set1_epi32(static_cast<int>(colour.hex));
+		for(; i + 4 <= count; i += 4)
+		{
+			const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels + i));
+			if(_mm_movemask_epi8(_mm_cmpeq_epi32(block, value)) != 0xFFFF)
+				break;
+		}
+#endif
+
+		while(i < count && pixels[i].hex == colour.hex)
+			i++;
+
+		return i;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	QOIEncoder::QOIEncoder()
+	{
+		reset();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void QOIEncoder::reset()
+	{
+		m_Index.fill(Colour(0u));
+		m_Previous = Colour(0, 0, 0, 255);
+		m_Run = 0;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t QOIEncoder::begin(const unsigned width, const unsigned height, uint8_t* output)
+	{
+		reset();
+
+		std::copy(c_Magic, c_Magic + 4, output);
+		write_u32_be(output + 4, width);
+		write_u32_be(output + 8, height);
+		output[12] = 4;
+		output[13] = 0;
+
+		return HeaderSize;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t QOIEncoder::encode(const Colour* pixels, const uint64_t count, uint8_t* output)
+	{
+		uint8_t* out = output;
+
+		for(uint64_t i = 0; i < count;)
+		{
+			const Colour pixel = pixels[i];
+
+			// Sprite art is full of runs, so the length of each run is found in bulk
+			// and then emitted in as many run chunks as it needs. A run which is not
+			// yet finished is kept pending, as it may continue into the next batch.
+			if(pixel.hex == m_Previous.hex)
+			{
+				uint64_t repeats = count_repeats(pixels + i, count - i, pixel);
+				i += repeats;
+
+				while(repeats > 0)
+				{
+					const unsigned length = static_cast<unsigned>(std::min<uint64_t>(repeats, c_MaxRun - m_Run));
+					m_Run += length;
+					repeats -= length;
+
+					if(m_Run == c_MaxRun)
+					{
+						*out++ = c_OpRun | static_cast<uint8_t>(m_Run - 1);
+						m_Run = 0;
+					}
+				}
+				continue;
+			}
+
+			if(m_Run > 0)
+			{
+				*out++ = c_OpRun | static_cast<uint8_t>(m_Run - 1);
+				m_Run = 0;
+			}
+
+			const unsigned index = qoi_hash(pixel);
+			if(m_Index[index].hex == pixel.hex)
+			{
+				*out++ = c_OpIndex | static_cast<uint8_t>(index);
+			}
+			else
+			{
+				m_Index[index] = pixel;
+
+				if(pixel.alpha == m_Previous.alpha)
+				{
+					// The differences wrap around, just like the channels do when decoding
+					const int dr = static_cast<int8_t>(pixel.red - m_Previous.red);
+					const int dg = static_cast<int8_t>(pixel.green - m_Previous.green);
+					const int db = static_cast<int8_t>(pixel.blue - m_Previous.blue);
+					const int dr_dg = dr - dg;
+					const int db_dg = db - dg;
+
+					if(dr >= -2 && dr <= 1 && dg >= -2 && dg <= 1 && db >= -2 && db <= 1)
+					{
+						*out++ = c_OpDiff | static_cast<uint8_t>((dr + 2) << 4 | (dg + 2) << 2 | (db + 2));
+					}
+					else if(dr_dg >= -8 && dr_dg <= 7 && dg >= -32 && dg <= 31 && db_dg >= -8 && db_dg <= 7)
+					{
+						*out++ = c_OpLuma | static_cast<uint8_t>(dg + 32);
+						*out++ = static_cast<uint8_t>((dr_dg + 8) << 4 | (db_dg + 8));
+					}
+					else
+					{
+						*out++ = c_OpRGB;
+						*out++ = pixel.red;
+						*out++ = pixel.green;
+						*out++ = pixel.blue;
+					}
+				}
+				else
+				{
+					*out++ = c_OpRGBA;
+					*out++ = pixel.red;
+					*out++ = pixel.green;
+					*out++ = pixel.blue;
+					*out++ = pixel.alpha;
+				}
+			}
+
+			m_Previous = pixel;
+			i++;
+		}
+
+		return out - output;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t QOIEncoder::finish(uint8_t* output)
+	{
+		uint8_t* out = output;
+
+		if(m_Run > 0)
+		{
+			*out++ = c_OpRun | static_cast<uint8_t>(m_Run - 1);
+			m_Run = 0;
+		}
+
+		out = std::copy(c_EndMarker, c_EndMarker + 8, out);
+		return out - output;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<QOIHeader> QOIDecoder::ReadHeader(const uint8_t* data, const uint64_t size)
+	{
+		if(size < QOIEncoder::HeaderSize + sizeof(c_EndMarker) || !std::equal(c_Magic, c_Magic + 4, data))
+			return std::nullopt;
+
+		const QOIHeader header = {read_u32_be(data + 4), read_u32_be(data + 8), data[12], data[13]};
+		if(header.width == 0 || header.height == 0 || static_cast<uint64_t>(header.width) * header.height > c_MaxPixels)
+			return std::nullopt;
+
+		if((header.channels != 3 && header.channels != 4) || header.colour_space > 1)
+			return std::nullopt;
+
+		return header;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool QOIDecoder::Decode(const uint8_t* data, const uint64_t size, Colour* pixels, const uint64_t pixel_count)
+	{
+		const auto header = ReadHeader(data, size);
+		if(!header || static_cast<uint64_t>(header->width) * header->height != pixel_count)
+			return false;
+
+		std::array<Colour, 64> index;
+		index.fill(Colour(0u));
+		Colour pixel(0, 0, 0, 255);
+
+		// Every chunk is at most five bytes and the file ends with an eight byte
+		// marker, so a chunk starting before the marker can be read without
+		// checking the bounds of each of its bytes.
+		const uint64_t chunks_end = size - sizeof(c_EndMarker);
+		uint64_t p = QOIEncoder::HeaderSize;
+
+		for(uint64_t i = 0; i < pixel_count;)
+		{
+			if(p >= chunks_end)
+				return false;
+
+			const uint8_t op = data[p++];
+			switch(op & c_OpMask)
+			{
+				case c_OpIndex:
+				{
+					pixel = index[op];
+					break;
+				}
+				case c_OpDiff:
+				{
+					pixel.red += ((op >> 4) & 0x03) - 2;
+					pixel.green += ((op >> 2) & 0x03) - 2;
+					pixel.blue += (op & 0x03) - 2;
+					break;
+				}
+				case c_OpLuma:
+				{
+					const uint8_t differences = data[p++];
+					const int dg = (op & 0x3F) - 32;
+					pixel.red += dg - 8 + ((differences >> 4) & 0x0F);
+					pixel.green += dg;
+					pixel.blue += dg - 8 + (differences & 0x0F);
+					break;
+				}
+				default:
+				{
+					// The full colour chunks share their tag with the run chunk
+					if(op == c_OpRGB)
+					{
+						pixel.red = data[p];
+						pixel.green = data[p + 1];
+						pixel.blue = data[p + 2];
+						p += 3;
+					}
+					else if(op == c_OpRGBA)
+					{
+						pixel.red = data[p];
+						pixel.green = data[p + 1];
+						pixel.blue = data[p + 2];
+						pixel.alpha = data[p + 3];
+						p += 4;
+					}
+					else
+					{
+						// Runs repeat the previous pixel. That is usually in the index already, 
+						// except when the image starts with a run of the initial pixel. 
+						const uint64_t length = std::min<uint64_t>((op & 0x3F) + 1, pixel_count - i);
+						std::fill_n(pixels + i, length, pixel);
+						index[qoi_hash(pixel)] = pixel;
+						i += length;
+						continue;
+					}
+					break;
+				}
+			}
+
+			index[qoi_hash(pixel)] = pixel;
+			pixels[i++] = pixel;
+		}
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
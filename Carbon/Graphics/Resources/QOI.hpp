@@ -0,0 +1,67 @@
+#pragma once
+
+#include <optional>
+#include <stdint.h>
+#include <array>
+
+#include "../../Utility/Colour.hpp"
+
+namespace cbn
+{
+
+	struct QOIHeader
+	{
+		uint32_t width;
+		uint32_t height;
+		uint8_t channels;
+		uint8_t colour_space;
+	};
+
+	// Encodes pixels in the QOI format. The encoding is streamed, so an image can be encoded in
+	// any number of batches into a small buffer which is flushed between batches, rather than
+	// building the whole file in memory. The encoder never allocates.
+	class QOIEncoder
+	{
+	public:
+
+		static constexpr uint64_t HeaderSize = 14;
+		static constexpr uint64_t MaxPixelSize = 5;
+		static constexpr uint64_t MaxTrailerSize = 9;
+
+	private:
+
+		std::array<Colour, 64> m_Index;
+		Colour m_Previous;
+		unsigned m_Run;
+
+		void reset();
+
+	public:
+
+		QOIEncoder();
+
+		// Starts a new image by writing its header, which takes HeaderSize bytes.
+		uint64_t begin(const unsigned width, const unsigned height, uint8_t* output);
+
+		// Encodes the next batch of pixels, returning the number of bytes written. The output
+		// must have room for count * MaxPixelSize + 1 bytes, as a pending run may be flushed.
+		uint64_t encode(const Colour* pixels, const uint64_t count, uint8_t* output);
+
+		// Ends the image by writing any pending run and the end marker, which takes at most
+		// MaxTrailerSize bytes.
+		uint64_t finish(uint8_t* output);
+
+	};
+
+	// Decodes QOI files straight into a caller provided pixel buffer, without allocating.
+	class QOIDecoder
+	{
+	public:
+
+		static std::optional<QOIHeader> ReadHeader(const uint8_t* data, const uint64_t size);
+
+		static bool Decode(const uint8_t* data, const uint64_t size, Colour* pixels, const uint64_t pixel_count);
+
+	};
+
+}
\ No newline at end of file
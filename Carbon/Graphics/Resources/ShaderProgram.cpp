@@ -3,6 +3,7 @@
 #include <glm/gtc/type_ptr.hpp>
 
 #include "../../Diagnostics/Assert.hpp"
+#include "../OpenGL/StateCache.hpp"
 
 
 //-------------------------------------------------------------------------------------
@@ -17,10 +18,6 @@ namespace cbn
 {
 	//-------------------------------------------------------------------------------------
 
-	GLuint ShaderProgram::s_BoundProgramID = 0;
-
-	//-------------------------------------------------------------------------------------
-
 	std::tuple<SRes<ShaderProgram>, String> ShaderProgram::Create(const SRes<Shader>& vertex_shader, const SRes<Shader>& geometry_shader, const SRes<Shader>& fragment_shader)
 	{
 		// Make sure that at least vertex shader and fragment shader have been supplied 
@@ -131,8 +128,8 @@ namespace cbn
 
 	ShaderProgram::~ShaderProgram()
 	{
-		// Before we destroy the object, we need to ensure the static bounded object tracker
-		// doesnt consider it as being bound. Otherwise issues will arise when a new object
+		// Before we destroy the object, we need to ensure the state cache doesnt consider
+		// it as being bound. Otherwise issues will arise when a new object
 		// takes its ID.
 		unbind();
 		glDeleteProgram(m_ProgramID);
@@ -142,11 +139,7 @@ namespace cbn
 
 	void ShaderProgram::bind() const
 	{
-		if(!is_bound())
-		{
-			s_BoundProgramID = m_ProgramID;
-			glUseProgram(m_ProgramID);
-		}
+		StateCache::UseProgram(m_ProgramID);
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -154,17 +147,14 @@ namespace cbn
 	void ShaderProgram::unbind() const
 	{
 		if(is_bound())
-		{
-			s_BoundProgramID = 0;
-			glUseProgram(0);
-		}
+			StateCache::UseProgram(0);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	bool ShaderProgram::is_bound() const
 	{
-		return s_BoundProgramID == m_ProgramID;
+		return StateCache::IsProgramBound(m_ProgramID);
 	}
 	
 	//-------------------------------------------------------------------------------------
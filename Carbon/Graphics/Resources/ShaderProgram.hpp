@@ -18,8 +18,6 @@ namespace cbn
 
 	private:
 
-		static GLuint s_BoundProgramID;
-
 		const GLuint m_ProgramID;
 		std::unordered_map<Identifier, GLint> m_UniformLocations;
 
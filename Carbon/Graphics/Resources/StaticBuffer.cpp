@@ -1,5 +1,8 @@
 #include "StaticBuffer.hpp"
 
+#include "../../Diagnostics/Assert.hpp"
+#include "../OpenGL/StateCache.hpp"
+
 namespace cbn
 {
 
@@ -15,30 +18,105 @@ namespace cbn
 	SRes<StaticBuffer> StaticBuffer::Allocate(const uint8_t* data, const uint64_t size, const BufferTarget target, const Version opengl_version)
 	{
 		// Create the buffer first to generate the OpenGL buffer object, then simply attach the required memory to it
-		auto static_buffer = SRes<StaticBuffer>(new StaticBuffer(target, size));
+		auto static_buffer = SRes<StaticBuffer>(new StaticBuffer(target, size, false, opengl_version));
+		static_buffer->create_storage(data, opengl_version);
+
+		return static_buffer;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<StaticBuffer> StaticBuffer::Reserve(const uint64_t byte_size, const BufferTarget target, const Version opengl_version)
+	{
+		// Reserved buffers start off uninitialized, and are filled in 
+		// afterwards by uploading or copying data into sub-ranges of it.
+		auto static_buffer = SRes<StaticBuffer>(new StaticBuffer(target, byte_size, true, opengl_version));
+		static_buffer->create_storage(nullptr, opengl_version);
+
+		// Reserved buffers are usually large, so make sure that 
+		// the graphics device was not out of memory. 
+		if(glGetError() == GL_OUT_OF_MEMORY)
+			return nullptr;
+
+		return static_buffer;
+	}
+
+	//-------------------------------------------------------------------------------------
 
-		static_buffer->bind();
+	void StaticBuffer::create_storage(const uint8_t* data, const Version& opengl_version)
+	{
+		// Immutable storage can only be written to after creation if it is dynamic
+		const GLbitfield storage_flags = m_Writable ? GL_DYNAMIC_STORAGE_BIT : 0;
 
-		// If OpenGL 4.4 is supported, create immutable storage otherwise use the normal buffer data.
-		if(opengl_version >= Version{4,4})
+		// If OpenGL 4.5 is supported, we can create the immutable storage with direct state access.
+		// Otherwise we have to bind the buffer first, and only use immutable storage on OpenGL 4.4.
+		if(m_DirectStateAccess)
 		{
-			glBufferStorage(to_opengl_target(target), size, data, NULL);
+			glNamedBufferStorage(m_BufferID, m_ByteSize, data, storage_flags);
 		}
 		else
 		{
-			glBufferData(to_opengl_target(target), size, data, GL_STATIC_DRAW);
+			bind();
+
+			if(opengl_version >= Version{4,4})
+			{
+				glBufferStorage(to_opengl_target(get_target()), m_ByteSize, data, storage_flags);
+			}
+			else
+			{
+				glBufferData(to_opengl_target(get_target()), m_ByteSize, data, GL_STATIC_DRAW);
+			}
+
+			unbind();
 		}
+	}
 
-		static_buffer->unbind();
+	//-------------------------------------------------------------------------------------
 
-		return static_buffer;
+	StaticBuffer::StaticBuffer(const BufferTarget target, const uint64_t byte_size, const bool writable, const Version& opengl_version)
+		: Buffer(target, opengl_version),
+		m_ByteSize(byte_size),
+		m_Writable(writable) {}
+
+	//-------------------------------------------------------------------------------------
+
+	void StaticBuffer::upload(const uint8_t* data, const uint64_t length, const uint64_t offset)
+	{
+		CBN_Assert(is_writable(), "Cannot upload to a static buffer which was not reserved");
+		CBN_Assert(offset + length <= m_ByteSize, "Upload exceeds the size of the buffer");
+
+		if(m_DirectStateAccess)
+		{
+			glNamedBufferSubData(m_BufferID, offset, length, data);
+		}
+		else
+		{
+			bind();
+			glBufferSubData(to_opengl_target(get_target()), offset, length, data);
+		}
 	}
 
 	//-------------------------------------------------------------------------------------
 
-	StaticBuffer::StaticBuffer(const BufferTarget target, const uint64_t byte_size)
-		: Buffer(target),
-		m_ByteSize(byte_size) {}
+	void StaticBuffer::copy(const StaticBuffer& source, const uint64_t source_offset, const uint64_t offset, const uint64_t length)
+	{
+		CBN_Assert(is_writable(), "Cannot copy to a static buffer which was not reserved");
+		CBN_Assert(source_offset + length <= source.m_ByteSize, "Copy exceeds the size of the source buffer");
+		CBN_Assert(offset + length <= m_ByteSize, "Copy exceeds the size of the buffer");
+
+		// Copies happen entirely on the GPU, so the data never has to come back to the CPU.
+		// Without direct state access, we use the copy targets so that no draw bindings change.
+		if(m_DirectStateAccess)
+		{
+			glCopyNamedBufferSubData(source.m_BufferID, m_BufferID, source_offset, offset, length);
+		}
+		else
+		{
+			StateCache::BindBuffer(GL_COPY_READ_BUFFER, source.m_BufferID);
+			StateCache::BindBuffer(GL_COPY_WRITE_BUFFER, m_BufferID);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, source_offset, offset, length);
+		}
+	}
 
 	//-------------------------------------------------------------------------------------
 
@@ -48,6 +126,13 @@ namespace cbn
 	}
 
 	//-------------------------------------------------------------------------------------
+
+	bool StaticBuffer::is_writable() const
+	{
+		return m_Writable;
+	}
+
+	//-------------------------------------------------------------------------------------
 	
 
 }
\ No newline at end of file
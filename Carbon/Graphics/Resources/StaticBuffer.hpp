@@ -19,16 +19,27 @@ namespace cbn
 		
 		static SRes<StaticBuffer> Allocate(const uint8_t* data, const uint64_t length, const BufferTarget target, const Version opengl_version);
 
+		static SRes<StaticBuffer> Reserve(const uint64_t byte_size, const BufferTarget target, const Version opengl_version);
+
 	private:
 
 		const uint64_t m_ByteSize;
+		const bool m_Writable;
+
+		void create_storage(const uint8_t* data, const Version& opengl_version);
 
-		StaticBuffer(const BufferTarget target, const uint64_t byte_size);
+		StaticBuffer(const BufferTarget target, const uint64_t byte_size, const bool writable, const Version& opengl_version);
 
 	public:
 
+		void upload(const uint8_t* data, const uint64_t length, const uint64_t offset);
+
+		void copy(const StaticBuffer& source, const uint64_t source_offset, const uint64_t offset, const uint64_t length);
+
 		uint64_t size() const;
 
+		bool is_writable() const;
+
 	};
 
 }
\ No newline at end of file
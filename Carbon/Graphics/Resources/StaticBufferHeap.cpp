@@ -0,0 +1,265 @@
+#include "StaticBufferHeap.hpp"
+
+#include <algorithm>
+
+#include "../../Diagnostics/Assert.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	uint64_t StaticBufferHeap::align(const uint64_t length) const
+	{
+		const uint64_t alignment = m_Properties.alignment;
+		return std::max(((length + alignment - 1) / alignment) * alignment, alignment);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StaticBufferHeap::create_page(const uint64_t byte_size)
+	{
+		auto buffer = StaticBuffer::Reserve(byte_size, m_Target, m_OpenGLVersion);
+		if(!buffer)
+			return false;
+
+		m_Pages.push_back({buffer, {}, 0});
+		insert_free_range(static_cast<uint32_t>(m_Pages.size() - 1), 0, byte_size);
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StaticBufferHeap::insert_free_range(const uint32_t page, uint64_t offset, uint64_t size)
+	{
+		auto& free_ranges = m_Pages[page].free_ranges;
+
+		// Merge the range with the free range directly after it, if they touch
+		auto next = free_ranges.lower_bound(offset);
+		if(next != free_ranges.end() && offset + size == next->first)
+		{
+			m_FreeRangesBySize.erase({next->second, page, next->first});
+			size += next->second;
+			next = free_ranges.erase(next);
+		}
+
+		// Merge the range with the free range directly before it, if they touch
+		if(next != free_ranges.begin())
+		{
+			const auto previous = std::prev(next);
+			if(previous->first + previous->second == offset)
+			{
+				m_FreeRangesBySize.erase({previous->second, page, previous->first});
+				offset = previous->first;
+				size += previous->second;
+				free_ranges.erase(previous);
+			}
+		}
+
+		free_ranges[offset] = size;
+		m_FreeRangesBySize.insert({size, page, offset});
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StaticBufferHeap::take_free_range(const uint32_t page, const uint64_t offset, const uint64_t range_size, const uint64_t size)
+	{
+		auto& free_ranges = m_Pages[page].free_ranges;
+
+		free_ranges.erase(offset);
+		m_FreeRangesBySize.erase({range_size, page, offset});
+
+		// Whatever is left over of the range stays free. It cannot touch
+		// any other free ranges, otherwise they would have been merged.
+		if(range_size > size)
+		{
+			free_ranges[offset + size] = range_size - size;
+			m_FreeRangesBySize.insert({range_size - size, page, offset + size});
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	StaticHeapAllocation StaticBufferHeap::describe(const uint32_t handle, const Allocation& allocation) const
+	{
+		return {handle, m_Pages[allocation.page].buffer, allocation.offset, allocation.size};
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	StaticBufferHeap::StaticBufferHeap(const BufferTarget target, const Version& opengl_version, const StaticHeapProperties& properties)
+		: m_Target(target),
+		m_OpenGLVersion(opengl_version),
+		m_Properties(properties),
+		m_NextHandle(1)
+	{
+		CBN_Assert(properties.alignment > 0, "Heap alignment must be non-zero");
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<StaticHeapAllocation> StaticBufferHeap::allocate(const std::vector<uint8_t>& data)
+	{
+		return allocate(data.data(), data.size());
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::optional<StaticHeapAllocation> StaticBufferHeap::allocate(const uint8_t* data, const uint64_t length)
+	{
+		CBN_Assert(length > 0, "Cannot allocate an empty range");
+
+		// All sizes are kept as multiples of the alignment, so every free range
+		// starts aligned and the smallest range which is large enough is a best fit.
+		const uint64_t size = align(length);
+		auto best_fit = m_FreeRangesBySize.lower_bound({size, 0, 0});
+
+		// If no range is large enough, we need a new page. Allocations which
+		// are larger than the page size are given a page of their own.
+		if(best_fit == m_FreeRangesBySize.end())
+		{
+			if(!create_page(std::max(align(m_Properties.page_size), size)))
+				return std::nullopt;
+
+			best_fit = m_FreeRangesBySize.lower_bound({size, 0, 0});
+		}
+
+		const auto [range_size, page, offset] = *best_fit;
+		take_free_range(page, offset, range_size, size);
+
+		const Allocation allocation = {page, offset, size};
+		m_Pages[page].used_bytes += size;
+
+		if(data != nullptr)
+			m_Pages[page].buffer->upload(data, length, offset);
+
+		const uint32_t handle = m_NextHandle++;
+		m_Allocations[handle] = allocation;
+		return describe(handle, allocation);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void StaticBufferHeap::release(const uint32_t handle)
+	{
+		CBN_Assert(contains(handle), "No allocation with the given handle exists");
+
+		const Allocation allocation = m_Allocations.at(handle);
+		m_Allocations.erase(handle);
+
+		m_Pages[allocation.page].used_bytes -= allocation.size;
+		insert_free_range(allocation.page, allocation.offset, allocation.size);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StaticBufferHeap::compact()
+	{
+		// Compaction copies every live allocation, in order, into a fresh set of tightly
+		// packed pages. We cannot compact a page into itself because overlapping copies
+		// within the same buffer are not allowed. Any empty pages will also be dropped.
+		std::vector<std::pair<uint32_t, Allocation>> live_allocations(m_Allocations.begin(), m_Allocations.end());
+		std::sort(live_allocations.begin(), live_allocations.end(), [](const auto& left, const auto& right)
+		{
+			return std::tie(left.second.page, left.second.offset) < std::tie(right.second.page, right.second.offset);
+		});
+
+		std::vector<Page> pages;
+		for(auto& [handle, allocation] : live_allocations)
+		{
+			if(pages.empty() || pages.back().used_bytes + allocation.size > pages.back().buffer->size())
+			{
+				// If we fail to create a page, the heap is left untouched
+				auto buffer = StaticBuffer::Reserve(std::max(align(m_Properties.page_size), allocation.size), m_Target, m_OpenGLVersion);
+				if(!buffer)
+					return false;
+
+				pages.push_back({buffer, {}, 0});
+			}
+
+			auto& page = pages.back();
+			page.buffer->copy(*m_Pages[allocation.page].buffer, allocation.offset, page.used_bytes, allocation.size);
+
+			allocation.page = static_cast<uint32_t>(pages.size() - 1);
+			allocation.offset = page.used_bytes;
+			page.used_bytes += allocation.size;
+		}
+
+		// Replace the old pages, which releases their buffers, and
+		// rebuild the free ranges from the tail end of each new page.
+		m_Pages = std::move(pages);
+		m_FreeRangesBySize.clear();
+		for(uint32_t p = 0; p < m_Pages.size(); p++)
+		{
+			const uint64_t page_size = m_Pages[p].buffer->size();
+			if(m_Pages[p].used_bytes < page_size)
+				insert_free_range(p, m_Pages[p].used_bytes, page_size - m_Pages[p].used_bytes);
+		}
+
+		for(const auto& [handle, allocation] : live_allocations)
+			m_Allocations[handle] = allocation;
+
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StaticBufferHeap::contains(const uint32_t handle) const
+	{
+		return m_Allocations.count(handle);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	StaticHeapAllocation StaticBufferHeap::allocation_of(const uint32_t handle) const
+	{
+		CBN_Assert(contains(handle), "No allocation with the given handle exists");
+
+		return describe(handle, m_Allocations.at(handle));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t StaticBufferHeap::reserved_bytes() const
+	{
+		uint64_t reserved = 0;
+		for(const auto& page : m_Pages)
+			reserved += page.buffer->size();
+
+		return reserved;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t StaticBufferHeap::used_bytes() const
+	{
+		uint64_t used = 0;
+		for(const auto& page : m_Pages)
+			used += page.used_bytes;
+
+		return used;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	int StaticBufferHeap::allocation_count() const
+	{
+		return m_Allocations.size();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	int StaticBufferHeap::page_count() const
+	{
+		return m_Pages.size();
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	StaticHeapProperties StaticBufferHeap::properties() const
+	{
+		return m_Properties;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
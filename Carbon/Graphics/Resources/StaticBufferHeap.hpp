@@ -0,0 +1,100 @@
+#pragma once
+
+#include <unordered_map>
+#include <optional>
+#include <stdint.h>
+#include <vector>
+#include <tuple>
+#include <map>
+#include <set>
+
+#include "../../Utility/Version.hpp"
+#include "../../Memory/Resource.hpp"
+#include "StaticBuffer.hpp"
+
+namespace cbn
+{
+
+	struct StaticHeapProperties
+	{
+		uint64_t page_size = 16 * 1024 * 1024;
+		uint64_t alignment = 16;
+	};
+
+	struct StaticHeapAllocation
+	{
+		uint32_t handle;
+		SRes<StaticBuffer> buffer;
+		uint64_t offset;
+		uint64_t size;
+	};
+
+	// Sub-allocates many small static allocations out of a few large static buffers, so that
+	// static geometry can share buffer objects and be drawn without re-binding. Free space is
+	// tracked per page as a set of coalesced ranges, and allocations use a best fit search.
+	class StaticBufferHeap
+	{
+	private:
+
+		struct Page
+		{
+			SRes<StaticBuffer> buffer;
+			std::map<uint64_t, uint64_t> free_ranges;
+			uint64_t used_bytes = 0;
+		};
+
+		struct Allocation
+		{
+			uint32_t page;
+			uint64_t offset;
+			uint64_t size;
+		};
+
+		const BufferTarget m_Target;
+		const Version m_OpenGLVersion;
+		const StaticHeapProperties m_Properties;
+
+		std::vector<Page> m_Pages;
+		std::set<std::tuple<uint64_t, uint32_t, uint64_t>> m_FreeRangesBySize;
+		std::unordered_map<uint32_t, Allocation> m_Allocations;
+		uint32_t m_NextHandle;
+
+		uint64_t align(const uint64_t length) const;
+
+		bool create_page(const uint64_t byte_size);
+
+		void insert_free_range(const uint32_t page, uint64_t offset, uint64_t size);
+
+		void take_free_range(const uint32_t page, const uint64_t offset, const uint64_t range_size, const uint64_t size);
+
+		StaticHeapAllocation describe(const uint32_t handle, const Allocation& allocation) const;
+
+	public:
+
+		StaticBufferHeap(const BufferTarget target, const Version& opengl_version, const StaticHeapProperties& properties = {});
+
+		std::optional<StaticHeapAllocation> allocate(const std::vector<uint8_t>& data);
+
+		std::optional<StaticHeapAllocation> allocate(const uint8_t* data, const uint64_t length);
+
+		void release(const uint32_t handle);
+
+		bool compact();
+
+		bool contains(const uint32_t handle) const;
+
+		StaticHeapAllocation allocation_of(const uint32_t handle) const;
+
+		uint64_t reserved_bytes() const;
+
+		uint64_t used_bytes() const;
+
+		int allocation_count() const;
+
+		int page_count() const;
+
+		StaticHeapProperties properties() const;
+
+	};
+
+}
\ No newline at end of file
@@ -6,26 +6,33 @@ namespace cbn
 
 	SRes<StreamBuffer> StreamBuffer::Allocate(const BufferTarget target, const uint64_t byte_size, const bool synchronized, const Version opengl_version)
 	{
-		//NOTE: we are not currently using the openGL version for optimisations, but we may in the future
-		
 		// Create the stream buffer now then allocate memory for it afterwards. 
-		auto stream_buffer = SRes<StreamBuffer>(new StreamBuffer(target, byte_size, synchronized));
-
-		stream_buffer->bind();
-		glBufferData(to_opengl_target(target), byte_size, NULL, GL_STREAM_DRAW);
-		stream_buffer->unbind();
+		auto stream_buffer = SRes<StreamBuffer>(new StreamBuffer(target, byte_size, synchronized, opengl_version));
+
+		// If OpenGL 4.5 is supported, use direct state access so that we dont disturb the binding.
+		// Note that the storage must stay mutable so that it can be orphaned on re-allocation. 
+		if(stream_buffer->m_DirectStateAccess)
+		{
+			glNamedBufferData(stream_buffer->m_BufferID, byte_size, NULL, GL_STREAM_DRAW);
+		}
+		else
+		{
+			stream_buffer->bind();
+			glBufferData(to_opengl_target(target), byte_size, NULL, GL_STREAM_DRAW);
+			stream_buffer->unbind();
+		}
 
 		return stream_buffer;
 	}
 
 	//-------------------------------------------------------------------------------------
 
-	StreamBuffer::StreamBuffer(const BufferTarget target, const uint64_t byte_size, const bool synchronized)
-		: Buffer(target),
-		m_Mapped(false),
-		m_ByteSize(byte_size),
+	StreamBuffer::StreamBuffer(const BufferTarget target, const uint64_t byte_size, const bool synchronized, const Version& opengl_version)
+		: Buffer(target, opengl_version),
 		m_Synchronized(synchronized),
-		m_MappingFlags(GL_MAP_WRITE_BIT | (synchronized ? NULL : GL_MAP_UNSYNCHRONIZED_BIT)) {}
+		m_MappingFlags(GL_MAP_WRITE_BIT | (synchronized ? NULL : GL_MAP_UNSYNCHRONIZED_BIT)),
+		m_ByteSize(byte_size),
+		m_Mapped(false) {}
 	
 	//-------------------------------------------------------------------------------------
 
@@ -33,8 +40,11 @@ namespace cbn
 	{
 		CBN_Assert(!is_mapped(), "Cannot map a buffer which is already mapped");
 
-		bind();
 		m_Mapped = true;
+		if(m_DirectStateAccess)
+			return glMapNamedBufferRange(m_BufferID, 0, m_ByteSize, m_MappingFlags);
+
+		bind();
 		return glMapBufferRange(to_opengl_target(get_target()), 0, m_ByteSize, m_MappingFlags);
 	}
 	
@@ -43,10 +53,13 @@ namespace cbn
 	void* StreamBuffer::map(const uint64_t offset, const uint64_t length)
 	{
 		CBN_Assert(!m_Mapped, "Cannot map a buffer which is already mapped");
-		CBN_Assert(offset + length < m_ByteSize, "Cannot map a buffer which is already mapped");
+		CBN_Assert(offset + length <= m_ByteSize, "Cannot map a range outside of the buffer");
 
-		bind();
 		m_Mapped = true;
+		if(m_DirectStateAccess)
+			return glMapNamedBufferRange(m_BufferID, offset, length, m_MappingFlags);
+
+		bind();
 		return glMapBufferRange(to_opengl_target(get_target()), offset, length, m_MappingFlags);
 	}
 
@@ -56,9 +69,16 @@ namespace cbn
 	{
 		CBN_Assert(is_mapped(), "Cannot unmap buffer which is not already mapped");
 		
-		bind();
 		m_Mapped = false;
-		glUnmapBuffer(to_opengl_target(get_target()));
+		if(m_DirectStateAccess)
+		{
+			glUnmapNamedBuffer(m_BufferID);
+		}
+		else
+		{
+			bind();
+			glUnmapBuffer(to_opengl_target(get_target()));
+		}
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -74,10 +94,16 @@ namespace cbn
 	{
 		CBN_Assert(!is_mapped(), "Cannot reallocate buffer while its mapped");
 
-		bind();
-
 		m_ByteSize = byte_size;
-		glBufferData(to_opengl_target(get_target()), byte_size, NULL, GL_DYNAMIC_DRAW);
+		if(m_DirectStateAccess)
+		{
+			glNamedBufferData(m_BufferID, byte_size, NULL, GL_STREAM_DRAW);
+		}
+		else
+		{
+			bind();
+			glBufferData(to_opengl_target(get_target()), byte_size, NULL, GL_STREAM_DRAW);
+		}
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -93,8 +119,15 @@ namespace cbn
 	{
 		CBN_Assert(!is_mapped(), "Cannot reallocate buffer while its mapped");
 
-		bind();
-		glBufferSubData(to_opengl_target(get_target()), offset, length, data);
+		if(m_DirectStateAccess)
+		{
+			glNamedBufferSubData(m_BufferID, offset, length, data);
+		}
+		else
+		{
+			bind();
+			glBufferSubData(to_opengl_target(get_target()), offset, length, data);
+		}
 	}
 	
 	//-------------------------------------------------------------------------------------
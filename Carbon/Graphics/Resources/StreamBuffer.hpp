@@ -23,7 +23,7 @@ namespace cbn
 		uint64_t m_ByteSize;
 		bool m_Mapped;
 
-		StreamBuffer(const BufferTarget target, const uint64_t byte_size, const bool unsynchronized);
+		StreamBuffer(const BufferTarget target, const uint64_t byte_size, const bool unsynchronized, const Version& opengl_version);
 
 	public:
 
@@ -1,21 +1,46 @@
 #include "Texture.hpp"
 
+#include <algorithm>
+
+#include "../../Diagnostics/Assert.hpp"
+#include "../OpenGL/StateCache.hpp"
+
 namespace cbn
 {
 
 	//-------------------------------------------------------------------------------------
-	
-	// Zero initialize a raw array then convert it to a std array. All texture units will
-	// be unbound initially. 
-	std::array<GLuint, 32> Texture::s_BoundTexture2Ds = std::to_array<GLuint, 32>({0});
+
+	SRes<Texture> Texture::Create(const SRes<Image>& image, const TextureSettings& settings)
+	{
+		return Create(image->view(), settings);
+	}
 	
 	//-------------------------------------------------------------------------------------
 
-	SRes<Texture> Texture::Create(const SRes<Image>& image, const TextureSettings& settings)
+	SRes<Texture> Texture::Create(const ImageView& image, const TextureSettings& settings)
 	{
+		const GLsizei levels = settings.mipmaps == TextureMipmaps::NONE ? 1 : full_mipmap_levels(image.width(), image.height());
+
 		// Create the texture. This can only fail if the graphics device is out of memory
 		// so we don't actually have to worry about validating any of the given parameters
-		SRes<Texture> texture = Resource::WrapShared(new Texture(image, settings));
+		SRes<Texture> texture = Resource::WrapShared(new Texture(image.width(), image.height(), GL_RGBA8, levels, settings));
+		texture->upload_level(0, image.data(), image.width(), image.height(), image.stride());
+
+		// The CPU path box filters each level from the one before it, which
+		// gives consistent results across drivers at the cost of load time. 
+		if(settings.mipmaps == TextureMipmaps::GENERATE_CPU)
+		{
+			SRes<Image> level_image;
+			for(GLint level = 1; level < levels; level++)
+			{
+				level_image = level == 1 ? Image::Downsample(image) : level_image->downsample();
+				texture->upload_level(level, level_image->data(), level_image->width(), level_image->height(), level_image->width());
+			}
+		}
+		else if(settings.mipmaps == TextureMipmaps::GENERATE_GPU)
+		{
+			texture->generate_mipmaps();
+		}
 
 		// If we could not properly create the texture due to 
 		// being out of memory, run the texture out of scope
@@ -30,8 +55,124 @@ namespace cbn
 	
 	//-------------------------------------------------------------------------------------
 
+	SRes<Texture> Texture::Create(const unsigned width, const unsigned height, const TextureSettings& settings)
+	{
+		const GLsizei levels = settings.mipmaps == TextureMipmaps::NONE ? 1 : full_mipmap_levels(width, height);
+
+		// The texture storage is allocated but left uninitialized, 
+		// its contents are expected to be uploaded later on. 
+		SRes<Texture> texture = Resource::WrapShared(new Texture(width, height, GL_RGBA8, levels, settings));
+		for(GLint level = 0; level < levels; level++)
+			texture->upload_level(level, nullptr, std::max(width >> level, 1u), std::max(height >> level, 1u), 0);
+
+		if(glGetError() == GL_OUT_OF_MEMORY)
+		{
+			return nullptr;
+		}
+
+		return texture;
+	}
+	
+	//-------------------------------------------------------------------------------------
+
+	SRes<Texture> Texture::Create(const SRes<CompressedImage>& image, const TextureSettings& settings)
+	{
+		std::vector<std::span<const uint8_t>> levels;
+		for(unsigned level = 0; level < image->levels(); level++)
+			levels.emplace_back(image->level_data(level), image->level_size(level));
+
+		return Create(image->format(), image->width(), image->height(), levels, settings);
+	}
+	
+	//-------------------------------------------------------------------------------------
+
+	SRes<Texture> Texture::Create(const CompressedFormat format, const unsigned width, const unsigned height, const std::vector<std::span<const uint8_t>>& levels, const TextureSettings& settings)
+	{
+		CBN_Assert(!levels.empty(), "Compressed textures need at least one level");
+
+		// Mipmaps cannot be generated for compressed formats, so 
+		// we use whichever levels were provided with the image.
+		SRes<Texture> texture = Resource::WrapShared(new Texture(width, height, value(format), static_cast<GLsizei>(levels.size()), settings));
+		for(unsigned level = 0; level < levels.size(); level++)
+		{
+			const unsigned level_width = std::max(width >> level, 1u);
+			const unsigned level_height = std::max(height >> level, 1u);
+			texture->upload_compressed_level(level, levels[level].data(), levels[level].size(), level_width, level_height);
+		}
+
+		if(glGetError() == GL_OUT_OF_MEMORY)
+		{
+			return nullptr;
+		}
+
+		return texture;
+	}
+	
+	//-------------------------------------------------------------------------------------
+
+	SRes<Texture> Texture::Create(const SRes<IndexedImage>& image, const TextureSettings& settings)
+	{
+		TextureSettings index_settings = settings;
+		index_settings.magnifying_filter = TextureFilter::NEAREST;
+		index_settings.minifying_filter = TextureFilter::NEAREST;
+		index_settings.mipmaps = TextureMipmaps::NONE;
+		index_settings.swizzle = TextureSwizzle::RGBA;
+
+		SRes<Texture> texture = Resource::WrapShared(new Texture(image->width(), image->height(), GL_R8, 1, index_settings));
+		texture->upload_level(0, image->data(), image->width(), image->height(), image->width());
+
+		if(glGetError() == GL_OUT_OF_MEMORY)
+		{
+			return nullptr;
+		}
+
+		return texture;
+	}
+	
+	//-------------------------------------------------------------------------------------
+
+	SRes<Texture> Texture::Create(const std::vector<Palette>& palettes)
+	{
+		CBN_Assert(!palettes.empty(), "Palette textures need at least one palette");
+
+		// Unused entries are transparent, matching how indexed images treat them
+		std::vector<Colour> texels(IndexedImage::MaxColours * palettes.size(), Colour(0, 0, 0, 0));
+		for(size_t row = 0; row < palettes.size(); row++)
+		{
+			CBN_Assert(palettes[row].size() <= IndexedImage::MaxColours, "Palette has too many colours");
+			std::copy(palettes[row].begin(), palettes[row].end(), texels.begin() + row * IndexedImage::MaxColours);
+		}
+
+		TextureSettings settings;
+		settings.minifying_filter = TextureFilter::NEAREST;
+
+		const unsigned height = static_cast<unsigned>(palettes.size());
+		SRes<Texture> texture = Resource::WrapShared(new Texture(IndexedImage::MaxColours, height, GL_RGBA8, 1, settings));
+		texture->upload_level(0, texels.data(), IndexedImage::MaxColours, height, IndexedImage::MaxColours);
+
+		if(glGetError() == GL_OUT_OF_MEMORY)
+		{
+			return nullptr;
+		}
+
+		return texture;
+	}
+	
+	//-------------------------------------------------------------------------------------
+
 	SRes<Texture> Texture::Open(const std::filesystem::path& path, const TextureSettings& settings)
 	{
+		// KTX2 files hold pre-compressed payloads which are uploaded
+		// as they are, everything else is decoded to RGBA pixels.
+		if(path.extension() == ".ktx2")
+		{
+			SRes<CompressedImage> image = CompressedImage::Open(path);
+			if(!image)
+				return nullptr;
+
+			return Create(image, settings);
+		}
+
 		SRes<Image> image = Image::Open(path);
 		if(!image)
 			return nullptr;
@@ -50,12 +191,131 @@ namespace cbn
 	
 	//-------------------------------------------------------------------------------------
 
-	void Texture::upload_image_data(const Colour* data, const unsigned width, const unsigned height)
+	GLsizei Texture::full_mipmap_levels(const unsigned width, const unsigned height)
 	{
-		// We need to bind the image before we can update its contents
+		// A full chain halves the resolution until both dimensions reach one
+		GLsizei levels = 1;
+		for(unsigned size = std::max(width, height); size > 1; size >>= 1)
+			levels++;
+
+		return levels;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void Texture::allocate_storage()
+	{
+		// Immutable storage allocates every level up front with a fixed format, so the 
+		// driver never has to validate the texture's completeness when it is sampled.
+		if(m_DirectStateAccess)
+		{
+			glTextureStorage2D(m_TextureID, m_Levels, m_InternalFormat, m_Resolution.x, m_Resolution.y);
+			return;
+		}
+
+		// We need to bind the texture before we can allocate its storage
 		bind();
 
-		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		if(m_ImmutableStorage)
+		{
+			glTexStorage2D(GL_TEXTURE_2D, m_Levels, m_InternalFormat, m_Resolution.x, m_Resolution.y);
+		}
+		else
+		{
+			// Without immutable storage, each level is allocated when it is first uploaded.
+			// The level range must be limited to the levels we have, otherwise the texture
+			// would be incomplete and sample as black when using a mipmapped filter. 
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_Levels - 1);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void Texture::upload_level(const GLint level, const void* data, const unsigned width, const unsigned height, const unsigned stride)
+	{
+		// Views of part of a larger image have rows which are further apart than their
+		// width, so the row length is given while unpacking them and is reset afterwards.
+		const bool strided = data != nullptr && stride != width;
+		if(strided)
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, stride);
+
+		// Rows are expected to start on four byte boundaries by default, 
+		// which single byte indices only do if the width is a multiple of four.
+		const bool unaligned = is_indexed();
+		if(unaligned)
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+		const GLenum format = pixel_format();
+
+		if(m_DirectStateAccess)
+		{
+			if(data != nullptr)
+				glTextureSubImage2D(m_TextureID, level, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+		}
+		else
+		{
+			// We need to bind the image before we can update its contents
+			bind();
+
+			if(m_ImmutableStorage)
+			{
+				if(data != nullptr)
+					glTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, format, GL_UNSIGNED_BYTE, data);
+			}
+			else
+			{
+				glTexImage2D(GL_TEXTURE_2D, level, m_InternalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+			}
+		}
+
+		if(strided)
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+		if(unaligned)
+			glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void Texture::upload_compressed_level(const GLint level, const uint8_t* data, const uint64_t size, const unsigned width, const unsigned height)
+	{
+		if(m_DirectStateAccess)
+		{
+			glCompressedTextureSubImage2D(m_TextureID, level, 0, 0, width, height, m_InternalFormat, static_cast<GLsizei>(size), data);
+			return;
+		}
+
+		bind();
+
+		if(m_ImmutableStorage)
+			glCompressedTexSubImage2D(GL_TEXTURE_2D, level, 0, 0, width, height, m_InternalFormat, static_cast<GLsizei>(size), data);
+		else
+			glCompressedTexImage2D(GL_TEXTURE_2D, level, m_InternalFormat, width, height, 0, static_cast<GLsizei>(size), data);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	GLenum Texture::pixel_format() const
+	{
+		return is_indexed() ? GL_RED : GL_RGBA;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	GLint Texture::create_minifying_filter(const TextureSettings& settings) const
+	{
+		if(m_Levels <= 1)
+			return value(settings.minifying_filter);
+
+		// With mipmaps, the minifying filter is combined with the filter used between levels
+		const bool linear_texels = settings.minifying_filter == TextureFilter::LINEAR;
+		const bool linear_levels = settings.mipmap_filter == TextureFilter::LINEAR;
+
+		if(linear_texels)
+			return linear_levels ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR_MIPMAP_NEAREST;
+		else
+			return linear_levels ? GL_NEAREST_MIPMAP_LINEAR : GL_NEAREST_MIPMAP_NEAREST;
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -79,29 +339,36 @@ namespace cbn
 	
 	//-------------------------------------------------------------------------------------
 
-	Texture::Texture(const SRes<Image>& image, const TextureSettings& settings)
-		: m_Resolution(image->resolution())
+	Texture::Texture(const unsigned width, const unsigned height, const GLenum internal_format, const GLsizei levels, const TextureSettings& settings)
+		: m_TextureUnit(TextureUnit::UNIT_0),
+		m_DirectStateAccess(StateCache::ContextVersion() >= Version{4,5}),
+		m_ImmutableStorage(StateCache::ContextVersion() >= Version{4,2}),
+		m_InternalFormat(internal_format),
+		m_Levels(levels),
+		m_Resolution(width, height)
 	{
-		// Create the texture
-		glGenTextures(1, &m_TextureID);
+		// Create the texture. With direct state access, it must be created with glCreateTextures 
+		// so that it is initialized as a 2D texture without having to be bound to the context.
+		if(m_DirectStateAccess)
+			glCreateTextures(GL_TEXTURE_2D, 1, &m_TextureID);
+		else
+			glGenTextures(1, &m_TextureID);
 
 		// Configure texture properties
 		configure(settings);
 		
 		// Note that this can fail if the graphics device is out of memory,
 		// however the error is generated by the device not OpenGL so it must 
-		// be validated independently in the create function.
-		upload_image_data(image->data(), image->width(), image->height());
+		// be validated independently in the create functions.
+		allocate_storage();
 	}
-	
 	//-------------------------------------------------------------------------------------
 
 	Texture::~Texture()
 	{
-		// Before we destroy the object, we need to ensure the static bounded object tracker
-		// doesnt consider it as being bound. Otherwise issues will arise when a new object
-		// takes its ID. 
-		unbind();
+		// Before we destroy the object, we need to ensure the state cache doesnt consider 
+		// it as being bound. Otherwise issues will arise when a new object takes its ID. 
+		StateCache::ForgetTexture(m_TextureID);
 		glDeleteTextures(1, &m_TextureID);
 	}
 	
@@ -109,35 +376,26 @@ namespace cbn
 
 	bool Texture::is_bound(const TextureUnit texture_unit) const
 	{
-		return m_TextureUnit == texture_unit && s_BoundTexture2Ds[value(texture_unit)] == m_TextureID;
+		return m_TextureUnit == texture_unit && StateCache::IsTextureBound(value(texture_unit), GL_TEXTURE_2D, m_TextureID);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	bool Texture::is_bound() const
 	{
-		return s_BoundTexture2Ds[value(m_TextureUnit)] == m_TextureID;
+		return StateCache::IsTextureBound(value(m_TextureUnit), GL_TEXTURE_2D, m_TextureID);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	void Texture::bind(const TextureUnit texture_unit) const
 	{
-		// Only bind the texture if it is not already 
-		// bound to the given texture unit
-		if(!is_bound(texture_unit))
-		{
-			// Update the texture binding states
-			s_BoundTexture2Ds[value(texture_unit)] = m_TextureID;
-			m_TextureUnit = texture_unit;
-
-			// Bind the texture to the correct unit
-			glActiveTexture(GL_TEXTURE0 +  value(texture_unit));
-			glBindTexture(GL_TEXTURE_2D, m_TextureID);
-		}
+		// The state cache will only bind the texture if it is 
+		// not already bound to the given texture unit
+		StateCache::BindTexture(value(texture_unit), GL_TEXTURE_2D, m_TextureID);
+		m_TextureUnit = texture_unit;
 	}
 
-
 	//-------------------------------------------------------------------------------------
 
 	void Texture::unbind() const
@@ -146,11 +404,62 @@ namespace cbn
 		if(is_bound())
 		{
 			// Unbind from the texture unit the texture is bound to
-			glActiveTexture(GL_TEXTURE0 + value(m_TextureUnit));
-			glBindTexture(GL_TEXTURE_2D, 0);
+			StateCache::BindTexture(value(m_TextureUnit), GL_TEXTURE_2D, 0);
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void Texture::upload(const Colour* data, const unsigned x, const unsigned y, const unsigned width, const unsigned height)
+	{
+		CBN_Assert(!is_compressed(), "Cannot upload pixels to a compressed texture");
+		CBN_Assert(!is_indexed(), "Cannot upload pixels to an indexed texture");
+		CBN_Assert(x + width <= m_Resolution.x && y + height <= m_Resolution.y, "Upload region is outside of the texture");
+
+		// If a pixel unpack buffer is bound to the context, then the data 
+		// pointer is interpreted as a byte offset into that buffer instead. 
+		if(m_DirectStateAccess)
+		{
+			glTextureSubImage2D(m_TextureID, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+		else
+		{
+			bind();
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, data);
+		}
+	}
 
-			// Reset state information
-			s_BoundTexture2Ds[value(m_TextureUnit)] = 0;
+	//-------------------------------------------------------------------------------------
+
+	void Texture::upload(const ImageView& image, const unsigned x, const unsigned y)
+	{
+		const bool strided = !image.is_contiguous();
+		if(strided)
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, image.stride());
+
+		upload(image.data(), x, y, image.width(), image.height());
+
+		if(strided)
+			glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void Texture::generate_mipmaps()
+	{
+		CBN_Assert(!is_compressed(), "Cannot generate mipmaps for a compressed texture");
+
+		if(m_Levels <= 1)
+			return;
+
+		if(m_DirectStateAccess)
+		{
+			glGenerateTextureMipmap(m_TextureID);
+		}
+		else
+		{
+			bind();
+			glGenerateMipmap(GL_TEXTURE_2D);
 		}
 	}
 
@@ -158,16 +467,27 @@ namespace cbn
 
 	void Texture::configure(const TextureSettings& settings)
 	{
-		// We need to bind the texture before we can change its parameters
-		bind();
+		if(m_DirectStateAccess)
+		{
+			glTextureParameteri(m_TextureID, GL_TEXTURE_WRAP_S, value(settings.horizontal_wrapping));
+			glTextureParameteri(m_TextureID, GL_TEXTURE_WRAP_T, value(settings.vertical_wrapping));
+			glTextureParameteri(m_TextureID, GL_TEXTURE_MIN_FILTER, create_minifying_filter(settings));
+			glTextureParameteri(m_TextureID, GL_TEXTURE_MAG_FILTER, value(settings.magnifying_filter));
+			glTextureParameteriv(m_TextureID, GL_TEXTURE_SWIZZLE_RGBA, create_swizzle_mask(settings.swizzle).data());
+		}
+		else
+		{
+			// We need to bind the texture before we can change its parameters
+			bind();
 
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, value(settings.horizontal_wrapping));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, value(settings.vertical_wrapping));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, value(settings.minifying_filter));
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, value(settings.magnifying_filter));
-	
-		// Update the swizzle mask
-		glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, create_swizzle_mask(settings.swizzle).data());
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, value(settings.horizontal_wrapping));
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, value(settings.vertical_wrapping));
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, create_minifying_filter(settings));
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, value(settings.magnifying_filter));
+		
+			// Update the swizzle mask
+			glTexParameteriv(GL_TEXTURE_2D, GL_TEXTURE_SWIZZLE_RGBA, create_swizzle_mask(settings.swizzle).data());
+		}
 
 		// Update the stored properties
 		m_Settings = settings;
@@ -203,6 +523,27 @@ namespace cbn
 
 	//-------------------------------------------------------------------------------------
 
+	unsigned Texture::levels() const
+	{
+		return m_Levels;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool Texture::is_compressed() const
+	{
+		return m_InternalFormat != GL_RGBA8 && m_InternalFormat != GL_R8;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool Texture::is_indexed() const
+	{
+		return m_InternalFormat == GL_R8;
+	}
+
+	//-------------------------------------------------------------------------------------
+
 	TextureUVMap Texture::uvs() const
 	{
 		// Texture uvs just encompass the entire texture, so we can just hardcode them
@@ -1,11 +1,16 @@
 #pragma once
 
 #include <unordered_map>
+#include <string_view>
+#include <vector>
 #include <array>
+#include <span>
 
 #include "../../Memory/Resource.hpp"
 #include "../../Utility/Enum.hpp"
 #include "../OpenGL/OpenGL.hpp"
+#include "CompressedImage.hpp"
+#include "IndexedImage.hpp"
 #include "Image.hpp"
 
 namespace cbn
@@ -60,6 +65,13 @@ namespace cbn
 		LINEAR = GL_LINEAR
 	};
 
+	enum class TextureMipmaps
+	{
+		NONE,
+		GENERATE_GPU,
+		GENERATE_CPU
+	};
+
 	enum class TextureWrapping : GLint
 	{
 		REPEAT = GL_REPEAT,
@@ -85,6 +97,9 @@ namespace cbn
 		TextureWrapping vertical_wrapping = TextureWrapping::CLAMP_TO_EDGE;
 
 		TextureSwizzle swizzle = TextureSwizzle::RGBA;
+
+		TextureMipmaps mipmaps = TextureMipmaps::NONE;
+		TextureFilter mipmap_filter = TextureFilter::LINEAR;
 	};
 
 	class Texture 
@@ -93,25 +108,63 @@ namespace cbn
 
 		static SRes<Texture> Create(const SRes<Image>& image, const TextureSettings& settings = {});
 
+		static SRes<Texture> Create(const ImageView& image, const TextureSettings& settings = {});
+
+		static SRes<Texture> Create(const unsigned width, const unsigned height, const TextureSettings& settings = {});
+
+		static SRes<Texture> Create(const SRes<CompressedImage>& image, const TextureSettings& settings = {});
+
+		static SRes<Texture> Create(const CompressedFormat format, const unsigned width, const unsigned height, const std::vector<std::span<const uint8_t>>& levels, const TextureSettings& settings = {});
+
+		// Creates a single channel texture holding the palette indices of the image. Indices cannot 
+		// be blended, so the texture always uses nearest filtering without any mipmaps. Its colours
+		// are looked up in a palette texture by the shader, see PaletteLookupSource.
+		static SRes<Texture> Create(const SRes<IndexedImage>& image, const TextureSettings& settings = {});
+
+		// Creates a palette texture with one palette per row, each MaxColours texels wide. A row 
+		// can be replaced at any time by uploading a new palette to it. 
+		static SRes<Texture> Create(const std::vector<Palette>& palettes);
+
 		static SRes<Texture> Open(const std::filesystem::path& path, const TextureSettings& settings = {});
 
 		static GLint SupportedTextureUnits();
 
+		// GLSL source for sampling indexed textures, which can be inserted into a shader after its
+		// version directive. Sprites are recoloured by choosing a different row of the palettes.
+		static constexpr std::string_view PaletteLookupSource =
+			"vec4 palette_lookup(sampler2D indices, sampler2D palettes, vec2 uv, int palette)\n"
+			"{\n"
+			"	int index = int(texture(indices, uv).r * 255.0 + 0.5);\n"
+			"	return texelFetch(palettes, ivec2(index, palette), 0);\n"
+			"}\n";
 
-	private:
 
-		static std::array<GLuint, 32> s_BoundTexture2Ds;
+	private:
 
 		mutable TextureUnit m_TextureUnit;
+		const bool m_DirectStateAccess;
+		const bool m_ImmutableStorage;
+		const GLenum m_InternalFormat;
+		const GLsizei m_Levels;
 		TextureSettings m_Settings;
 		glm::uvec2 m_Resolution;
 		GLuint m_TextureID;
 
-		void upload_image_data(const Colour* data, const unsigned width, const unsigned height);
+		static GLsizei full_mipmap_levels(const unsigned width, const unsigned height);
+
+		void allocate_storage();
+
+		void upload_level(const GLint level, const void* data, const unsigned width, const unsigned height, const unsigned stride);
+
+		void upload_compressed_level(const GLint level, const uint8_t* data, const uint64_t size, const unsigned width, const unsigned height);
+
+		GLenum pixel_format() const;
+
+		GLint create_minifying_filter(const TextureSettings& settings) const;
 
 		std::array<GLint, 4> create_swizzle_mask(const TextureSwizzle swizzle);
 
-		Texture(const SRes<Image>& image, const TextureSettings& settings);
+		Texture(const unsigned width, const unsigned height, const GLenum internal_format, const GLsizei levels, const TextureSettings& settings);
 
 	public:
 
@@ -125,6 +178,12 @@ namespace cbn
 		
 		bool is_bound() const;
 
+		void upload(const Colour* data, const unsigned x, const unsigned y, const unsigned width, const unsigned height);
+
+		void upload(const ImageView& image, const unsigned x, const unsigned y);
+
+		void generate_mipmaps();
+
 		void configure(const TextureSettings& settings);
 
 		TextureSettings settings() const;
@@ -135,6 +194,12 @@ namespace cbn
 
 		glm::uvec2 resolution() const;
 
+		unsigned levels() const;
+
+		bool is_compressed() const;
+
+		bool is_indexed() const;
+
 		TextureUVMap uvs() const;
 
 	};
@@ -3,6 +3,10 @@
 #include <algorithm>
 #include <iostream>
 #include <numeric>
+#include <cstring>
+#include <tuple>
+#include <deque>
+#include <set>
 
 #include "../../Maths/Maths.hpp"
 #include "Texture.hpp"
@@ -11,12 +15,61 @@ namespace cbn
 {
     //-------------------------------------------------------------------------------------
 
-    SubTexture::SubTexture(const Identifier& identity, const bool rotated, const TextureUVMap& uvs, const Rect<int>& rect)
+    // Views of the same pixels have the same key, which is used to 
+    // make sure that an image given more than once is only packed once.
+    using ViewKey = std::tuple<uintptr_t, unsigned, unsigned, unsigned>;
+
+    ViewKey view_key(const ImageView& view)
+    {
+        return {reinterpret_cast<uintptr_t>(view.data()), view.width(), view.height(), view.stride()};
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool same_pixels(const ImageView& left, const ImageView& right)
+    {
+        if(left.resolution() != right.resolution())
+            return false;
+
+        for(unsigned y = 0; y < left.height(); y++)
+            if(std::memcmp(left.row(y), right.row(y), left.width() * sizeof(Colour)) != 0)
+                return false;
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    SubTexture::SubTexture(const Identifier& identity, const bool rotated, const TextureUVMap& uvs, const Rect<int>& rect, const glm::ivec2& trim_offset, const glm::ivec2& source_resolution)
         : Identifiable(identity),
           rotated(rotated),
           uvs(uvs),
           position({rect.x, rect.y}),
-          resolution({rect.width, rect.height}) {}
+          resolution({rect.width, rect.height}),
+          trim_offset(trim_offset),
+          source_resolution(source_resolution) {}
+
+    //-------------------------------------------------------------------------------------
+
+    bool SubTexture::is_trimmed() const
+    {
+        return source_resolution.x > 0 && source_resolution.y > 0;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    TextureBounds SubTexture::bounds() const
+    {
+        if(!is_trimmed())
+            return {};
+
+        // The resolution is of the packed rect, which has its sides swapped if rotated
+        const glm::vec2 content_resolution = rotated ? glm::vec2{resolution.y, resolution.x} : resolution;
+        return {
+            trim_offset / source_resolution,
+            (trim_offset + content_resolution) / source_resolution
+        };
+    }
 
     //-------------------------------------------------------------------------------------
 
@@ -52,9 +105,9 @@ namespace cbn
     
     //-------------------------------------------------------------------------------------
 
-    bool TextureAtlas::is_rotated(const Rect<int>& rect, const SRes<Image>& image)
+    bool TextureAtlas::is_rotated(const Rect<int>& rect, const ImageView& image)
     {
-        return rect.width != rect.height && rect.width == image->height() && rect.height == image->width();
+        return rect.width != rect.height && rect.width == image.height() && rect.height == image.width();
     }
     
     //-------------------------------------------------------------------------------------
@@ -77,70 +130,460 @@ namespace cbn
     //-------------------------------------------------------------------------------------
     
     SRes<TextureAtlas> TextureAtlas::Pack(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings)
+    {
+        std::vector<PackingAttempt> attempts;
+        return Pack(width, height, images, settings, attempts);
+    }
+    
+    //-------------------------------------------------------------------------------------
+    
+    SRes<TextureAtlas> TextureAtlas::Pack(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings)
+    {
+        std::vector<PackingAttempt> attempts;
+        return Pack(width, height, images, settings, attempts);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    IdentityMap<ImageView> TextureAtlas::views(const IdentityMap<SRes<Image>>& images)
+    {
+        IdentityMap<ImageView> views;
+        for(const auto& [identity, image] : images)
+            views[identity] = image->view();
+
+        return views;
+    }
+    
+    //-------------------------------------------------------------------------------------
+    
+    ImageView TextureAtlas::trim(const ImageView& image, glm::ivec2& offset)
+    {
+        // Find the bounding box of all the pixels which aren't fully transparent
+        int min_x = image.width(), min_y = image.height(), max_x = -1, max_y = -1;
+        for(int y = 0; y < static_cast<int>(image.height()); y++)
+        {
+            const Colour* row = image.row(y);
+            for(int x = 0; x < static_cast<int>(image.width()); x++)
+            {
+                if(row[x].alpha != 0)
+                {
+                    min_x = std::min(min_x, x);
+                    max_x = std::max(max_x, x);
+                    min_y = std::min(min_y, y);
+                    max_y = y;
+                }
+            }
+        }
+
+        // A fully transparent image still needs a rect, so it is kept as a single pixel
+        if(max_x < 0)
+        {
+            min_x = max_x = 0;
+            min_y = max_y = 0;
+        }
+
+        // The trimmed image is just a view of the opaque part, so nothing needs to be copied
+        offset = {min_x, min_y};
+        return image.subview(min_x, min_y, max_x - min_x + 1, max_y - min_y + 1);
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    IdentityMap<TextureAtlas::PreparedImage> TextureAtlas::prepare(const IdentityMap<ImageView>& images, const TexturePackingSettings& settings)
+    {
+        IdentityMap<PreparedImage> prepared;
+        std::unordered_map<uint64_t, std::vector<ImageView>> contents;
+        for(const auto& [identity, image] : images)
+        {
+            PreparedImage& entry = prepared[identity];
+            entry.trim_offset = {0, 0};
+            entry.source_resolution = {0, 0};
+            entry.image = image;
+
+            if(settings.trim_transparency)
+            {
+                entry.image = trim(image, entry.trim_offset);
+                if(entry.image.resolution() != image.resolution())
+                    entry.source_resolution = image.resolution();
+            }
+
+            if(!settings.deduplicate)
+                continue;
+
+            // Images with identical contents are given the same packed image, so that
+            // they share one rect. Hash collisions are resolved by comparing the pixels.
+            const auto& candidate = entry.image;
+            uint64_t hash = 0xcbf29ce484222325;
+            for(unsigned y = 0; y < candidate.height(); y++)
+            {
+                const uint8_t* bytes = reinterpret_cast<const uint8_t*>(candidate.row(y));
+                for(uint64_t b = 0; b < candidate.width() * sizeof(Colour); b++)
+                    hash = (hash ^ bytes[b]) * 0x100000001b3;
+            }
+            hash ^= (static_cast<uint64_t>(candidate.width()) << 32) | candidate.height();
+
+            auto& matches = contents[hash];
+            const auto duplicate = std::find_if(matches.begin(), matches.end(), [&](const ImageView& match)
+            {
+                return same_pixels(match, candidate);
+            });
+
+            if(duplicate != matches.end())
+                entry.image = *duplicate;
+            else
+                matches.push_back(candidate);
+        }
+
+        return prepared;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    std::vector<ImageView> TextureAtlas::unique_images(const IdentityMap<ImageView>& images, const IdentityMap<PreparedImage>& prepared)
+    {
+        // The unique images are kept in the order of their identities rather than the order
+        // of the map, which depends on how the map was built. This way the same images always 
+        // give the same layout, even after being copied between maps of images and views. 
+        std::vector<Identifier> identities;
+        identities.reserve(images.size());
+        for(const auto& [identity, image] : images)
+            identities.push_back(identity);
+        std::sort(identities.begin(), identities.end());
+
+        std::vector<ImageView> unique;
+        std::set<ViewKey> seen;
+        for(const auto& identity : identities)
+        {
+            const auto& packed_image = prepared.at(identity).image;
+            if(seen.insert(view_key(packed_image)).second)
+                unique.push_back(packed_image);
+        }
+
+        return unique;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TextureAtlas::layout(const unsigned width, const unsigned height, const std::vector<ImageView>& images, const TexturePackingSettings& settings, std::vector<Rect<int>>& rectangles, std::vector<PackingAttempt>& attempts)
     {
         // Create rectangles representing the images, these will be used in a rectangle packing algorithm to represent the textures. 
-        // The rects in the rectangles vector are in the same order as those in the images unordered map when iterated. 
-        std::vector<Rect<int>> rectangles(images.size());
-        std::transform(images.begin(), images.end(), rectangles.begin(), [&](const std::pair<Identifier, SRes<Image>>& pair)
+        // The rects in the rectangles vector are in the same order as the images. 
+        rectangles.resize(images.size());
+        std::transform(images.begin(), images.end(), rectangles.begin(), [&](const ImageView& image)
         {
-            return Rect<int>{0, 0, static_cast<int>(pair.second->width()), static_cast<int>(pair.second->height())};
+            return Rect<int>{
+                0, 0, 
+                static_cast<int>(image.width() + settings.padding),
+                static_cast<int>(image.height() + settings.padding)
+            };
         });
 
-        // Use the MaxRects algorithm to pack the texture rectangles optimally
-        // The algorithm will update the x and y of the rectangles inside the rectangles vector
-        if(max_rects_optimal({width, height}, settings.allow_image_rotation, settings.heuristic, rectangles)) {
- 
-            // If we want to shrink to footprint then we need to find the extent of the rectangles,
-            // and push the extent to the next power of 2, this will be the atas size we use.
-            glm::uvec2 atlas_resolution = {width, height};
-            if(settings.shrink_to_footprint)
-            {
-                const glm::uvec2 footprint = determine_footprint(rectangles);
+        // Pack the texture rectangles with the chosen algorithm. MaxRects can also search for its best 
+        // heuristic, in which case the attempts are also returned. The algorithm will update the x and
+        // y of the rectangles inside the rectangles vector, and swap the sides of any rotated ones.
+        attempts.clear();
+        const bool search = settings.search_heuristics && settings.algorithm == RectanglePackingAlgorithm::MAX_RECTS;
+        return search
+            ? max_rects_search({width, height}, settings.allow_image_rotation, rectangles, attempts, settings.search_threads)
+            : pack_rectangles({width, height}, settings.allow_image_rotation, settings.algorithm, settings.heuristic, rectangles);
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    std::string TextureAtlas::default_group(const Identifier& identifier)
+    {
+        // Images named like "player/run_1" or "player_run_1" are grouped by 
+        // everything before the last separator, so all frames stay together.
+        const std::string alias = identifier.alias().as_std_string();
+        const size_t separator = alias.find_last_of("/_");
+        
+        return separator == std::string::npos ? alias : alias.substr(0, separator);
+    }
+
+    //-------------------------------------------------------------------------------------
+    
+    SRes<TextureAtlas> TextureAtlas::Pack(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings, std::vector<PackingAttempt>& attempts)
+    {
+        return Pack(width, height, views(images), settings, attempts);
+    }
+    
+    //-------------------------------------------------------------------------------------
+    
+    SRes<TextureAtlas> TextureAtlas::Pack(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings, std::vector<PackingAttempt>& attempts)
+    {
+        IdentityMap<AtlasRegion> regions;
+        SRes<Image> atlas_image = compose(width, height, images, settings, regions, attempts);
+        if(!atlas_image)
+            return nullptr;
+
+        // Create the texture
+        TextureSettings properties;
+        properties.minifying_filter = TextureFilter::NEAREST;
+        properties.magnifying_filter = TextureFilter::NEAREST;
+        properties.vertical_wrapping = TextureWrapping::CLAMP_TO_EDGE;
+        properties.horizontal_wrapping = TextureWrapping::CLAMP_TO_EDGE;
+        properties.mipmaps = settings.mipmaps;
+        SRes<Texture> atlas_texture = Texture::Create(atlas_image, properties);
+        
+        if(!atlas_texture)
+            return nullptr;
+
+        return Create(atlas_texture, regions);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> TextureAtlas::Compose(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings, IdentityMap<AtlasRegion>& regions)
+    {
+        return Compose(width, height, views(images), settings, regions);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> TextureAtlas::Compose(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings, IdentityMap<AtlasRegion>& regions)
+    {
+        std::vector<PackingAttempt> attempts;
+        return compose(width, height, images, settings, regions, attempts);
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    SRes<Image> TextureAtlas::compose(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings& settings, IdentityMap<AtlasRegion>& regions, std::vector<PackingAttempt>& attempts)
+    {
+        const auto prepared = prepare(images, settings);
+        const auto unique = unique_images(images, prepared);
+
+        std::vector<Rect<int>> rectangles;
+        if(!layout(width, height, unique, settings, rectangles, attempts))
+            return nullptr;
+
+        // The padding keeps a gap between neighbouring images so that they don't bleed 
+        // into each other when sampled from the lower mipmap levels. Once packing is 
+        // done it is removed again, so that the rectangles cover just their image. 
+        for(auto& rect : rectangles)
+        {
+            rect.width -= settings.padding;
+            rect.height -= settings.padding;
+        }
+
+        // If we want to shrink to footprint then we need to find the extent of the rectangles,
+        // and push the extent to the next power of 2, this will be the atas size we use.
+        glm::uvec2 atlas_resolution = {width, height};
+        if(settings.shrink_to_footprint)
+        {
+            const glm::uvec2 footprint = determine_footprint(rectangles);
+
+            // The next power of 2 of the footprint will be used as the size
+            atlas_resolution.x = std::min(width, next_power(footprint.x, 2u));
+            atlas_resolution.y = std::min(height, next_power(footprint.y, 2u));
+        }
+
+        SRes<Image> atlas_image = Image::Create(atlas_resolution.x, atlas_resolution.y);
+        if(!atlas_image) return nullptr;
+
+        // Insert the unique images, the rectangles are in the same order
+        std::map<ViewKey, size_t> slots;
+        for(size_t i = 0; i < unique.size(); i++)
+        {
+            const auto& rect = rectangles[i];
+            atlas_image->insert(rect.x, rect.y, unique[i], is_rotated(rect, unique[i]));
+            slots[view_key(unique[i])] = i;
+        }
+
+        // Generate the regions, duplicate images will share the same rect
+        regions.clear();
+        for(auto const& [identity, image] : images)
+        {
+            const auto& entry = prepared.at(identity);
+            const auto& rect = rectangles[slots.at(view_key(entry.image))];
+            regions[identity] = {rect, is_rotated(rect, entry.image), entry.trim_offset, entry.source_resolution};
+        }
+
+        return atlas_image;
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    std::vector<SRes<TextureAtlas>> TextureAtlas::PackPages(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings, const AtlasGrouping& grouping)
+    {
+        return PackPages(width, height, views(images), settings, grouping);
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    std::vector<SRes<TextureAtlas>> TextureAtlas::PackPages(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings, const AtlasGrouping& grouping)
+    {
+        const auto pages = Paginate(width, height, images, settings, grouping);
+
+        // Each page is packed from the same image map which was laid out 
+        // when paginating, so it is guaranteed to produce the same layout.
+        std::vector<SRes<TextureAtlas>> atlases;
+        for(const auto& page : pages)
+        {
+            auto atlas = Pack(width, height, page, settings);
+            if(!atlas)
+                return {};
+
+            atlases.push_back(atlas);
+        }
+
+        return atlases;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    std::vector<IdentityMap<SRes<Image>>> TextureAtlas::Paginate(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings, const AtlasGrouping& grouping)
+    {
+        const auto pages = Paginate(width, height, views(images), settings, grouping);
+
+        // Each page holds views of the images, so they are swapped back for the images themselves
+        std::vector<IdentityMap<SRes<Image>>> page_images;
+        for(const auto& page : pages)
+        {
+            auto& page_image = page_images.emplace_back();
+            for(const auto& [identity, view] : page)
+                page_image[identity] = images.at(identity);
+        }
+
+        return page_images;
+    }
+
+    //-------------------------------------------------------------------------------------
 
-                // The next power of 2 of the footprint will be used as the size
-                atlas_resolution.x = std::min(width, next_power(footprint.x, 2u));
-                atlas_resolution.y = std::min(height, next_power(footprint.y, 2u));
+    std::vector<IdentityMap<ImageView>> TextureAtlas::Paginate(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings, const AtlasGrouping& grouping)
+    {
+        struct Page
+        {
+            IdentityMap<ImageView> images;
+            uint64_t area = 0;
+        };
+
+        // The images are only trimmed and deduplicated once up front, since
+        // the same images will be laid out many times while finding a page.
+        const auto prepared = prepare(images, settings);
+
+        const uint64_t page_area = static_cast<uint64_t>(width) * height;
+        const auto area_of = [&](const std::vector<Identifier>& members)
+        {
+            uint64_t area = 0;
+            std::set<ViewKey> counted;
+            for(const auto& member : members)
+            {
+                const auto& image = prepared.at(member).image;
+                if(counted.insert(view_key(image)).second)
+                    area += static_cast<uint64_t>(image.width() + settings.padding) * (image.height() + settings.padding);
             }
+            return area;
+        };
+
+        // Images which are likely to be drawn together are kept on the same page where 
+        // possible, so that they can still be batched. The members of a group are sorted 
+        // by name so that if a group has to be split, related images stay together. 
+        std::map<std::string, std::vector<Identifier>> groups;
+        for(const auto& [identity, image] : images)
+            groups[grouping ? grouping(identity) : default_group(identity)].push_back(identity);
+
+        std::deque<std::vector<Identifier>> pending;
+        for(auto& [key, members] : groups)
+        {
+            std::sort(members.begin(), members.end(), [](const Identifier& left, const Identifier& right){
+                return left.alias().as_std_string() < right.alias().as_std_string();
+            });
+            pending.push_back(std::move(members));
+        }
+
+        // Placing the largest groups first leaves the smaller groups to fill in the gaps
+        std::stable_sort(pending.begin(), pending.end(), [&](const auto& left, const auto& right){
+            return area_of(left) > area_of(right);
+        });
+
+        std::vector<Rect<int>> rectangles;
+        std::vector<PackingAttempt> attempts;
+        const auto try_place = [&](Page& page, const std::vector<Identifier>& members, const uint64_t area)
+        {
+            if(page.area + area > page_area)
+                return false;
 
-            SRes<Image> atlas_image = Image::Create(atlas_resolution.x, atlas_resolution.y);
-            if(!atlas_image) return nullptr;
+            auto candidate = page.images;
+            for(const auto& member : members)
+                candidate[member] = images.at(member);
 
-            // Insert images and generate references. The references 
-            // and rectangles are in the order of the images map
-            int i = 0;
-            std::vector<SubTexture> subtextures;
-            for(auto const& [identity, image] : images)
+            if(!layout(width, height, unique_images(candidate, prepared), settings, rectangles, attempts))
+                return false;
+
+            page.images = std::move(candidate);
+            page.area += area;
+            return true;
+        };
+
+        std::vector<Page> pages;
+        while(!pending.empty())
+        {
+            const auto group = std::move(pending.front());
+            pending.pop_front();
+
+            // Use the first page which the whole group fits onto, otherwise start a new page
+            const uint64_t area = area_of(group);
+            if(std::any_of(pages.begin(), pages.end(), [&](Page& page){ return try_place(page, group, area); }))
+                continue;
+
+            Page page;
+            if(try_place(page, group, area))
             {
-                const auto& rect = rectangles[i++];
-                const bool rotated = is_rotated(rect, image);
-
-                const SubTexture subtexture = {
-                    identity,
-                    rotated,
-                    calculate_uvs(rect, rotated, atlas_image->resolution()),
-                    rect
-                };
-                
-                subtextures.push_back(subtexture);
-                atlas_image->insert(rect.x, rect.y, image, rotated);
+                pages.push_back(std::move(page));
+                continue;
             }
 
-            // Create the texture
-            TextureSettings properties;
-            properties.minifying_filter = TextureFilter::NEAREST;
-            properties.magnifying_filter = TextureFilter::NEAREST;
-            properties.vertical_wrapping = TextureWrapping::CLAMP_TO_EDGE;
-            properties.horizontal_wrapping = TextureWrapping::CLAMP_TO_EDGE;
-            SRes<Texture> atlas_texture = Texture::Create(atlas_image, properties);
-            
-            if(!atlas_texture)
+            // The group does not fit on a page by itself, so it has to be split. If it's 
+            // a single image then it can never fit and the images can't be packed at all.
+            if(group.size() == 1)
+                return {};
+
+            const auto middle = group.begin() + group.size() / 2;
+            pending.emplace_front(middle, group.end());
+            pending.emplace_front(group.begin(), middle);
+        }
+
+        std::vector<IdentityMap<ImageView>> page_images;
+        for(auto& page : pages)
+            page_images.push_back(std::move(page.images));
+
+        return page_images;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    SRes<TextureAtlas> TextureAtlas::Create(const SRes<Texture>& texture, const IdentityMap<AtlasRegion>& regions)
+    {
+        // This allows an atlas which was packed ahead of time, such as a pre-compressed
+        // texture, to be used directly given the layout of its sub-textures. 
+        std::vector<SubTexture> subtextures;
+        subtextures.reserve(regions.size());
+        for(auto const& [identity, region] : regions)
+        {
+            const auto& rect = region.rect;
+            if(rect.x < 0 || rect.y < 0 || rect.width <= 0 || rect.height <= 0
+            || static_cast<unsigned>(rect.x + rect.width) > texture->width()
+            || static_cast<unsigned>(rect.y + rect.height) > texture->height())
                 return nullptr;
 
-            return Resource::WrapShared<TextureAtlas>(new TextureAtlas(atlas_texture, subtextures));
+            subtextures.emplace_back(identity, region.rotated, calculate_uvs(rect, region.rotated, texture->resolution()), rect, region.trim_offset, region.source_resolution);
         }
-        return nullptr;
+
+        return Resource::WrapShared<TextureAtlas>(new TextureAtlas(texture, subtextures));
     }
-    
+
+    //-------------------------------------------------------------------------------------
+
+    SRes<TextureAtlas> TextureAtlas::Open(const std::filesystem::path& path, const IdentityMap<AtlasRegion>& regions, const TextureSettings& settings)
+    {
+        SRes<Texture> texture = Texture::Open(path, settings);
+        if(!texture)
+            return nullptr;
+
+        return Create(texture, regions);
+    }
+
     //-------------------------------------------------------------------------------------
    
     TextureAtlas::TextureAtlas(const SRes<Texture>& texture, const std::vector<SubTexture>& subtextures)
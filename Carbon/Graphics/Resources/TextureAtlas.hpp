@@ -2,7 +2,9 @@
 
 #include <unordered_map>
 #include <filesystem>
+#include <functional>
 #include <optional>
+#include <string>
 #include <vector>
 #include <map>
 
@@ -35,9 +37,35 @@ namespace cbn
 
 	struct TexturePackingSettings
 	{
+		RectanglePackingAlgorithm algorithm = RectanglePackingAlgorithm::MAX_RECTS;
 		RectanglePackingHeuristic heuristic = RectanglePackingHeuristic::BLSF_BAF_SQR;
+		bool search_heuristics = false;
+		unsigned search_threads = 0;
 		bool allow_image_rotation = true;
 		bool shrink_to_footprint = true;
+		TextureMipmaps mipmaps = TextureMipmaps::NONE;
+		unsigned padding = 0;
+		bool trim_transparency = false;
+		bool deduplicate = false;
+	};
+
+	// A trimmed region only holds the opaque part of its source image, which 
+	// sits at the trim offset within the source image's original resolution. 
+	// A source resolution of zero means that the region was not trimmed.
+	struct AtlasRegion
+	{
+		Rect<int> rect;
+		bool rotated = false;
+		glm::ivec2 trim_offset = {0, 0};
+		glm::ivec2 source_resolution = {0, 0};
+	};
+
+	// The part of a sprite which is covered by its texture, as fractions of the sprite's 
+	// size. Trimmed textures only cover the part where their opaque pixels used to be.
+	struct TextureBounds
+	{
+		glm::vec2 min = {0.0f, 0.0f};
+		glm::vec2 max = {1.0f, 1.0f};
 	};
 
 	struct SubTexture : Identifiable
@@ -46,18 +74,66 @@ namespace cbn
 		const TextureUVMap uvs;
 		const glm::vec2 position;
 		const glm::vec2 resolution;
+		const glm::vec2 trim_offset;
+		const glm::vec2 source_resolution;
 		
-		SubTexture(const Identifier& identity, const bool rotated, const TextureUVMap& uvs, const Rect<int>& rect);
+		SubTexture(const Identifier& identity, const bool rotated, const TextureUVMap& uvs, const Rect<int>& rect, const glm::ivec2& trim_offset = {0, 0}, const glm::ivec2& source_resolution = {0, 0});
+
+		bool is_trimmed() const;
+
+		TextureBounds bounds() const;
 	};
 
+	using AtlasGrouping = std::function<std::string(const Identifier&)>;
+
 	class TextureAtlas
 	{
+		friend class AtlasCache;
+
 	public:
 
 		static SRes<TextureAtlas> Pack(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings = {});
 
+		static SRes<TextureAtlas> Pack(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings, std::vector<PackingAttempt>& attempts);
+
+		static std::vector<SRes<TextureAtlas>> PackPages(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings = {}, const AtlasGrouping& grouping = {});
+
+		// Views can be packed directly, so that regions of a larger image such as the frames
+		// of a sprite sheet are packed without first copying each of them into its own image.
+		// The viewed images only need to stay alive until packing is complete. 
+
+		static SRes<TextureAtlas> Pack(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings = {});
+
+		static SRes<TextureAtlas> Pack(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings, std::vector<PackingAttempt>& attempts);
+
+		static std::vector<SRes<TextureAtlas>> PackPages(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings = {}, const AtlasGrouping& grouping = {});
+
+		// These perform the packing steps without creating any textures, so that 
+		// atlases can also be built offline where there is no OpenGL context. 
+
+		static SRes<Image> Compose(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings, IdentityMap<AtlasRegion>& regions);
+
+		static SRes<Image> Compose(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings, IdentityMap<AtlasRegion>& regions);
+
+		static std::vector<IdentityMap<SRes<Image>>> Paginate(const unsigned width, const unsigned height, const IdentityMap<SRes<Image>>& images, const TexturePackingSettings settings = {}, const AtlasGrouping& grouping = {});
+
+		static std::vector<IdentityMap<ImageView>> Paginate(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings settings = {}, const AtlasGrouping& grouping = {});
+
+		static SRes<TextureAtlas> Create(const SRes<Texture>& texture, const IdentityMap<AtlasRegion>& regions);
+
+		static SRes<TextureAtlas> Open(const std::filesystem::path& path, const IdentityMap<AtlasRegion>& regions, const TextureSettings& settings = {});
+
 	private:
 
+		// An image which is ready to be packed, after it has been trimmed and 
+		// deduplicated. Duplicate images all share the same packed image.
+		struct PreparedImage
+		{
+			ImageView image;
+			glm::ivec2 trim_offset;
+			glm::ivec2 source_resolution;
+		};
+
 		const std::vector<SubTexture> m_SubTextures;
 		IdentityMap<int> m_SubTextureMap;
 		SRes<Texture> m_AtlasTexture;
@@ -66,7 +142,21 @@ namespace cbn
 
 		static glm::uvec2 determine_footprint(const std::vector<Rect<int>>& rectangles);
 
-		static bool is_rotated(const Rect<int>& rect, const SRes<Image>& image); // This is kinda crap
+		static bool is_rotated(const Rect<int>& rect, const ImageView& image); // This is kinda crap
+
+		static IdentityMap<ImageView> views(const IdentityMap<SRes<Image>>& images);
+
+		static ImageView trim(const ImageView& image, glm::ivec2& offset);
+
+		static IdentityMap<PreparedImage> prepare(const IdentityMap<ImageView>& images, const TexturePackingSettings& settings);
+
+		static std::vector<ImageView> unique_images(const IdentityMap<ImageView>& images, const IdentityMap<PreparedImage>& prepared);
+
+		static bool layout(const unsigned width, const unsigned height, const std::vector<ImageView>& images, const TexturePackingSettings& settings, std::vector<Rect<int>>& rectangles, std::vector<PackingAttempt>& attempts);
+
+		static std::string default_group(const Identifier& identifier);
+
+		static SRes<Image> compose(const unsigned width, const unsigned height, const IdentityMap<ImageView>& images, const TexturePackingSettings& settings, IdentityMap<AtlasRegion>& regions, std::vector<PackingAttempt>& attempts);
 
 		TextureAtlas(const SRes<Texture>& texture, const std::vector<SubTexture>& subtextures);
 		
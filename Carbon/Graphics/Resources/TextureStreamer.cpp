@@ -0,0 +1,327 @@
+#include "TextureStreamer.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#include "../../Control/Timing/Stopwatch.hpp"
+#include "../../Diagnostics/Assert.hpp"
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+	StreamedTexture::StreamedTexture(const std::filesystem::path& path, const TextureSettings& settings, const SRes<Texture>& placeholder)
+		: m_Path(path),
+		m_Settings(settings),
+		m_Placeholder(placeholder),
+		m_Texture(nullptr),
+		m_Resident(false),
+		m_Failed(false)
+	{}
+
+	//-------------------------------------------------------------------------------------
+
+	const SRes<Texture>& StreamedTexture::texture() const
+	{
+		return m_Resident ? m_Texture : m_Placeholder;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const std::filesystem::path& StreamedTexture::path() const
+	{
+		return m_Path;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StreamedTexture::is_resident() const
+	{
+		return m_Resident;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool StreamedTexture::has_failed() const
+	{
+		return m_Failed;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void TextureStreamer::decode_images()
+	{
+		std::unique_lock lock(m_QueueMutex);
+		while(true)
+		{
+			m_QueueCondition.wait(lock, [this](){
+				return !m_Running || !m_DecodeQueue.empty();
+			});
+
+			if(!m_Running)
+				return;
+
+			auto target = std::move(m_DecodeQueue.front());
+			m_DecodeQueue.pop_front();
+			m_ActiveDecodes++;
+
+			// Decoding is the expensive part of loading, so it happens outside of the lock.
+			// A failed decode is still passed on so that the GL thread can mark it as failed.
+			lock.unlock();
+			auto image = Image::Open(target->path());
+			lock.lock();
+
+			m_DecodedQueue.push_back({std::move(target), std::move(image)});
+			m_ActiveDecodes--;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void TextureStreamer::retire_staging_slots()
+	{
+		for(auto& slot : m_StagingSlots)
+		{
+			if(slot.fence == nullptr)
+				continue;
+
+			// Poll the fence without waiting, we never want to stall the frame here
+			const GLenum status = glClientWaitSync(slot.fence, 0, 0);
+			if(status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				continue;
+
+			glDeleteSync(slot.fence);
+			slot.fence = nullptr;
+
+			// Commands complete in order, so if the final chunk of
+			// a texture is done then all of its other chunks are too.
+			if(slot.completes)
+			{
+				slot.completes->m_Texture = slot.texture;
+				slot.completes->m_Resident = true;
+			}
+
+			slot.completes = nullptr;
+			slot.texture = nullptr;
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool TextureStreamer::stream_chunk(Upload& upload)
+	{
+		// Slots are used in ring order, so if the next slot is still
+		// in use by the GPU then we cannot stream anything this frame.
+		auto& slot = m_StagingSlots[m_NextSlot];
+		if(slot.fence != nullptr)
+			return false;
+
+		const auto& image = upload.image;
+		if(!upload.texture)
+		{
+			upload.texture = Texture::Create(image->width(), image->height(), upload.target->m_Settings);
+			if(!upload.texture)
+			{
+				upload.target->m_Failed = true;
+				return true;
+			}
+		}
+
+		// If a single row does not fit into a staging slot, then the image cannot
+		// be streamed in chunks so we have no choice but to upload it directly.
+		const uint64_t row_size = image->width() * sizeof(Colour);
+		const unsigned rows_per_slot = static_cast<unsigned>(m_Properties.staging_slot_size / row_size);
+		if(rows_per_slot == 0)
+		{
+			upload.texture->upload(image->data(), 0, 0, image->width(), image->height());
+			upload.texture->generate_mipmaps();
+			upload.next_row = image->height();
+			upload.target->m_Texture = upload.texture;
+			upload.target->m_Resident = true;
+			return true;
+		}
+
+		const unsigned rows = std::min(rows_per_slot, image->height() - upload.next_row);
+		const uint64_t offset = m_NextSlot * m_Properties.staging_slot_size;
+		const uint64_t length = rows * row_size;
+
+		// The slot's fence has already signalled, so the GPU is no longer reading
+		// from it and the staging buffer can be mapped without synchronization.
+		void* staging = m_StagingBuffer->map(offset, length);
+		if(staging == nullptr)
+		{
+			m_StagingBuffer->unmap();
+			upload.target->m_Failed = true;
+			return true;
+		}
+		std::memcpy(staging, image->data() + upload.next_row * image->width(), length);
+		m_StagingBuffer->unmap();
+
+		// While the staging buffer is bound as the pixel unpack buffer, the upload reads
+		// from the given offset within it. It must be unbound afterwards, otherwise all
+		// other texture uploads would also attempt to read from the staging buffer.
+		m_StagingBuffer->bind();
+		upload.texture->upload(reinterpret_cast<const Colour*>(offset), 0, upload.next_row, image->width(), rows);
+		m_StagingBuffer->unbind();
+
+		upload.next_row += rows;
+
+		// Mipmaps can only be built once every row of the base level has been uploaded.
+		// Since the image arrives in chunks, they are always generated on the GPU, even
+		// if the texture settings ask for them to be generated on the CPU instead.
+		const bool completed = upload.next_row == image->height();
+		if(completed)
+			upload.texture->generate_mipmaps();
+
+		slot.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		slot.texture = upload.texture;
+		if(completed)
+			slot.completes = upload.target;
+
+		m_NextSlot = (m_NextSlot + 1) % m_StagingSlots.size();
+		return true;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	TextureStreamer::TextureStreamer(const Version& opengl_version, const TextureStreamerProperties& properties)
+		: m_Properties(properties),
+		m_StagingSlots(properties.staging_slots),
+		m_NextSlot(0),
+		m_ActiveDecodes(0),
+		m_Running(true)
+	{
+		CBN_Assert(properties.worker_count > 0, "Texture streamer needs at least one worker");
+		CBN_Assert(properties.staging_slots > 0, "Texture streamer needs at least one staging slot");
+		CBN_Assert(properties.staging_slot_size > 0, "Staging slots must be non-empty");
+
+		auto placeholder_image = Image::Create(1, 1);
+		placeholder_image->fill(properties.placeholder_colour);
+		m_Placeholder = Texture::Create(placeholder_image);
+
+		m_StagingBuffer = StreamBuffer::Allocate(
+			BufferTarget::PIXEL_UNPACK_BUFFER,
+			properties.staging_slots * properties.staging_slot_size,
+			false,
+			opengl_version
+		);
+
+		for(unsigned i = 0; i < properties.worker_count; i++)
+			m_Workers.emplace_back(&TextureStreamer::decode_images, this);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	TextureStreamer::~TextureStreamer()
+	{
+		{
+			std::scoped_lock lock(m_QueueMutex);
+			m_Running = false;
+		}
+		m_QueueCondition.notify_all();
+
+		for(auto& worker : m_Workers)
+			worker.join();
+
+		for(auto& slot : m_StagingSlots)
+			if(slot.fence != nullptr)
+				glDeleteSync(slot.fence);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	SRes<StreamedTexture> TextureStreamer::load(const std::filesystem::path& path, const TextureSettings& settings)
+	{
+		auto streamed_texture = Resource::WrapShared(new StreamedTexture(path, settings, m_Placeholder));
+
+		{
+			std::scoped_lock lock(m_QueueMutex);
+			m_DecodeQueue.push_back(streamed_texture);
+		}
+		m_QueueCondition.notify_one();
+
+		return streamed_texture;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void TextureStreamer::update()
+	{
+		Stopwatch stopwatch;
+		stopwatch.start();
+
+		retire_staging_slots();
+
+		{
+			std::scoped_lock lock(m_QueueMutex);
+			for(auto& decoded : m_DecodedQueue)
+			{
+				if(decoded.image)
+					m_Uploads.push_back({std::move(decoded.target), std::move(decoded.image)});
+				else
+					decoded.target->m_Failed = true;
+			}
+			m_DecodedQueue.clear();
+		}
+
+		// Stream chunks until we run out of budget or staging slots. Note that the
+		// budget is only checked between chunks, so the staging slot size should be
+		// small enough that a single chunk never takes a significant part of it.
+		while(!m_Uploads.empty() && stopwatch.elapsed() < m_Properties.frame_budget)
+		{
+			auto& upload = m_Uploads.front();
+
+			// If we hold the only reference to the target,
+			// nobody wants the texture anymore so drop it.
+			if(upload.target.use_count() == 1)
+			{
+				m_Uploads.pop_front();
+				continue;
+			}
+
+			if(!stream_chunk(upload))
+				break;
+
+			if(upload.target->m_Failed || upload.next_row >= upload.image->height())
+				m_Uploads.pop_front();
+		}
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	int TextureStreamer::pending_count()
+	{
+		std::scoped_lock lock(m_QueueMutex);
+
+		int in_flight = 0;
+		for(const auto& slot : m_StagingSlots)
+			if(slot.completes)
+				in_flight++;
+
+		return m_DecodeQueue.size() + m_ActiveDecodes + m_DecodedQueue.size() + m_Uploads.size() + in_flight;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool TextureStreamer::is_idle()
+	{
+		return pending_count() == 0;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const SRes<Texture>& TextureStreamer::placeholder() const
+	{
+		return m_Placeholder;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	TextureStreamerProperties TextureStreamer::properties() const
+	{
+		return m_Properties;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
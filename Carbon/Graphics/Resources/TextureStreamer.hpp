@@ -0,0 +1,127 @@
+#pragma once
+
+#include <condition_variable>
+#include <filesystem>
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <deque>
+
+#include "../../Control/Timing/Time.hpp"
+#include "../../Utility/Version.hpp"
+#include "../../Memory/Resource.hpp"
+#include "../OpenGL/OpenGL.hpp"
+#include "StreamBuffer.hpp"
+#include "Texture.hpp"
+
+namespace cbn
+{
+
+	struct TextureStreamerProperties
+	{
+		unsigned worker_count = 2;
+		unsigned staging_slots = 4;
+		uint64_t staging_slot_size = 4 * 1024 * 1024;
+		Time frame_budget = Time::Milliseconds(2.0);
+		Colour placeholder_colour = Magenta;
+	};
+
+	class StreamedTexture
+	{
+		friend class TextureStreamer;
+
+	private:
+
+		const std::filesystem::path m_Path;
+		const TextureSettings m_Settings;
+		const SRes<Texture> m_Placeholder;
+		SRes<Texture> m_Texture;
+		bool m_Resident, m_Failed;
+
+		StreamedTexture(const std::filesystem::path& path, const TextureSettings& settings, const SRes<Texture>& placeholder);
+
+	public:
+
+		const SRes<Texture>& texture() const;
+
+		const std::filesystem::path& path() const;
+
+		bool is_resident() const;
+
+		bool has_failed() const;
+
+	};
+
+	// Loads textures in the background without stalling the frame. Images are decoded on worker
+	// threads, then streamed to the GPU from a ring of pixel unpack buffers in row chunks. Each
+	// chunk is fenced, and a texture only becomes resident once its final chunk has completed.
+	class TextureStreamer
+	{
+	private:
+
+		struct DecodedImage
+		{
+			SRes<StreamedTexture> target;
+			SRes<Image> image;
+		};
+
+		struct Upload
+		{
+			SRes<StreamedTexture> target;
+			SRes<Image> image;
+			SRes<Texture> texture;
+			unsigned next_row = 0;
+		};
+
+		struct StagingSlot
+		{
+			GLsync fence = nullptr;
+			SRes<StreamedTexture> completes;
+			SRes<Texture> texture;
+		};
+
+		const TextureStreamerProperties m_Properties;
+		SRes<Texture> m_Placeholder;
+
+		SRes<StreamBuffer> m_StagingBuffer;
+		std::vector<StagingSlot> m_StagingSlots;
+		unsigned m_NextSlot;
+
+		std::deque<Upload> m_Uploads;
+
+		std::mutex m_QueueMutex;
+		std::condition_variable m_QueueCondition;
+		std::deque<SRes<StreamedTexture>> m_DecodeQueue;
+		std::deque<DecodedImage> m_DecodedQueue;
+		std::vector<std::thread> m_Workers;
+		unsigned m_ActiveDecodes;
+		bool m_Running;
+
+		void decode_images();
+
+		void retire_staging_slots();
+
+		bool stream_chunk(Upload& upload);
+
+	public:
+
+		TextureStreamer(const Version& opengl_version, const TextureStreamerProperties& properties = {});
+
+		~TextureStreamer();
+
+		SRes<StreamedTexture> load(const std::filesystem::path& path, const TextureSettings& settings = {});
+
+		void update();
+
+		int pending_count();
+
+		bool is_idle();
+
+		const SRes<Texture>& placeholder() const;
+
+		TextureStreamerProperties properties() const;
+
+	};
+
+}
\ No newline at end of file
@@ -31,32 +31,53 @@ namespace cbn
 		m_StreamBuffer = StreamBuffer::Allocate(BufferTarget::VERTEX_BUFFER, m_SpritesPerStreamBuffer * sizeof(SpriteLayout), false, opengl_version);
 		CBN_Assert(m_StreamBuffer != nullptr, "Stream buffer creation failed");
 
-		// Set up the vertex array
-		m_VertexArray.bind();
+		// Set up the vertex array with the index buffer and the attribute 
+		// bindings for the stream buffer and sprite layout
+		m_VertexArray.attach_element_buffer(*m_IndexBuffer);
+		m_VertexArray.set_attribute(0, *m_StreamBuffer, 2, GL_FLOAT, sizeof(VertexLayout), offsetof(VertexLayout, position));
+		m_VertexArray.set_integer_attribute(1, *m_StreamBuffer, 4, GL_UNSIGNED_SHORT, sizeof(VertexLayout), offsetof(VertexLayout, texture));
+		m_VertexArray.set_integer_attribute(2, *m_StreamBuffer, 4, GL_UNSIGNED_INT, sizeof(VertexLayout), offsetof(VertexLayout, data));
+	}
 
-		// Bind the buffers to the vertex array
-		m_StreamBuffer->force_bind();
-		m_IndexBuffer->force_bind();
+	//-------------------------------------------------------------------------------------
 
-		// Set attribute bindings for the stream buffer and sprite layout
-		int attribute = 0;
-		glVertexAttribPointer(attribute++, 2, GL_FLOAT, false, sizeof(VertexLayout), (void*)offsetof(VertexLayout, position));
-		glVertexAttribIPointer(attribute++, 4, GL_UNSIGNED_SHORT, sizeof(VertexLayout), (void*)offsetof(VertexLayout, texture));
-		glVertexAttribIPointer(attribute++, 4, GL_UNSIGNED_INT, sizeof(VertexLayout), (void*)offsetof(VertexLayout, data));
+	bool SpriteRenderer::is_trimmed(const TextureBounds& bounds)
+	{
+		return bounds.min != glm::vec2{0.0f, 0.0f} || bounds.max != glm::vec2{1.0f, 1.0f};
+	}
 
-		for(auto i = 0; i < attribute; i++)
-			glEnableVertexAttribArray(i);
+	//-------------------------------------------------------------------------------------
 
+	std::array<glm::vec2, 4> SpriteRenderer::trim_quad(const std::array<glm::vec2, 4>& vertices, const TextureBounds& bounds)
+	{
+		// The vertices go anti-clockwise from the top left, so the quad is interpolated
+		// along its top and bottom edges to find the corners of the texture's bounds. 
+		const auto point = [&](const float u, const float v)
+		{
+			const glm::vec2 top = vertices[0] + (vertices[3] - vertices[0]) * u;
+			const glm::vec2 bottom = vertices[1] + (vertices[2] - vertices[1]) * u;
+			return top + (bottom - top) * v;
+		};
+
+		return {
+			point(bounds.min.x, bounds.min.y),
+			point(bounds.min.x, bounds.max.y),
+			point(bounds.max.x, bounds.max.y),
+			point(bounds.max.x, bounds.min.y)
+		};
 	}
 
 	//-------------------------------------------------------------------------------------
 
-	void SpriteRenderer::push_sprite_to_buffer(const StaticMesh<4>& mesh, const uint16_t& index_1, const uint16_t& index_2, const uint16_t& index_3, const uint16_t& index_4, const glm::uvec4& vertex_data)
+	void SpriteRenderer::push_sprite_to_buffer(const std::array<glm::vec2, 4>& quad, const uint16_t& index_1, const uint16_t& index_2, const uint16_t& index_3, const uint16_t& index_4, const glm::uvec4& vertex_data, const TextureBounds& bounds)
 	{
 		CBN_Assert(m_BatchStarted, "No batch exists for submission");
 		CBN_Assert(!is_batch_full(), "Batch is full");
 
-		const auto& vertices = mesh.vertices();
+		// A trimmed texture only covers part of the sprite, the rest was transparent, so the
+		// quad is shrunk down to just that part. This looks the same, with less overdraw. Only 
+		// single texture sprites can be trimmed, as any other textures would no longer line up.
+		const auto vertices = is_trimmed(bounds) ? trim_quad(quad, bounds) : quad;
 		const auto vertex_1 = transform(vertices[0], m_ViewProjectionMatrix);
 		const auto vertex_2 = transform(vertices[1], m_ViewProjectionMatrix);
 		const auto vertex_3 = transform(vertices[2], m_ViewProjectionMatrix);
@@ -102,6 +123,19 @@ namespace cbn
 
 	//-------------------------------------------------------------------------------------
 
+	uint32_t SpriteRenderer::untrimmed_position_of(const Identifier& texture) const
+	{
+		// The textures of a multi-texture sprite all share the same quad, so a trimmed texture
+		// would have its uvs stretched over the whole sprite, distorting it.
+		TextureBounds bounds;
+		const uint32_t position = m_TexturePack.position_of(texture, bounds);
+		CBN_Assert(!is_trimmed(bounds), "Trimmed textures cannot be used in multi-texture sprites");
+
+		return position;
+	}
+
+	//-------------------------------------------------------------------------------------
+
 	SpriteRenderer::SpriteRenderer(const Version& opengl_version, const SpriteRendererProperties& properties)
 		: m_SpritesPerStreamBuffer(properties.sprites_per_batch * properties.buffer_allocation_bias),
 		m_TexturePack(opengl_version),
@@ -146,69 +180,82 @@ namespace cbn
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices)
 	{
-		push_sprite_to_buffer(vertices, 0, 0, 0, 0, c_EmptyVertexData);
+		push_sprite_to_buffer(vertices.vertices(), 0, 0, 0, 0, c_EmptyVertexData);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const glm::uvec4& vertex_data)
 	{
-		push_sprite_to_buffer(vertices, 0, 0, 0, 0, vertex_data);
+		push_sprite_to_buffer(vertices.vertices(), 0, 0, 0, 0, vertex_data);
 	}
 	
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const Identifier& texture_1)
 	{
-		push_sprite_to_buffer(vertices, m_TexturePack.position_of(texture_1), 0, 0, 0, c_EmptyVertexData);
+		TextureBounds bounds;
+		const uint32_t position = m_TexturePack.position_of(texture_1, bounds);
+		push_sprite_to_buffer(vertices.vertices(), position, 0, 0, 0, c_EmptyVertexData, bounds);
 	}
 	
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const Identifier& texture_1, const glm::uvec4& vertex_data)
 	{
-		push_sprite_to_buffer(vertices, m_TexturePack.position_of(texture_1), 0, 0, 0, vertex_data);
+		TextureBounds bounds;
+		const uint32_t position = m_TexturePack.position_of(texture_1, bounds);
+		push_sprite_to_buffer(vertices.vertices(), position, 0, 0, 0, vertex_data, bounds);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const Identifier& texture_1, const Identifier& texture_2)
 	{
-		push_sprite_to_buffer(vertices, m_TexturePack.position_of(texture_1), m_TexturePack.position_of(texture_2), 0, 0, c_EmptyVertexData);
+		push_sprite_to_buffer(vertices.vertices(), untrimmed_position_of(texture_1), untrimmed_position_of(texture_2), 0, 0, c_EmptyVertexData);
 	}
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const Identifier& texture_1, const Identifier& texture_2, const glm::uvec4& vertex_data)
 	{
-		push_sprite_to_buffer(vertices, m_TexturePack.position_of(texture_1), m_TexturePack.position_of(texture_2), 0, 0, vertex_data);
+		push_sprite_to_buffer(vertices.vertices(), untrimmed_position_of(texture_1), untrimmed_position_of(texture_2), 0, 0, vertex_data);
 	}
 	
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const Identifier& texture_1, const Identifier& texture_2, const Identifier& texture_3)
 	{
-		push_sprite_to_buffer(vertices, m_TexturePack.position_of(texture_1), m_TexturePack.position_of(texture_2), m_TexturePack.position_of(texture_3), 0, c_EmptyVertexData);
+		push_sprite_to_buffer(vertices.vertices(), untrimmed_position_of(texture_1), untrimmed_position_of(texture_2), untrimmed_position_of(texture_3), 0, c_EmptyVertexData);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const Identifier& texture_1, const Identifier& texture_2, const Identifier& texture_3, const glm::uvec4& vertex_data)
 	{
-		push_sprite_to_buffer(vertices, m_TexturePack.position_of(texture_1), m_TexturePack.position_of(texture_2), m_TexturePack.position_of(texture_3), 0, vertex_data);
+		push_sprite_to_buffer(vertices.vertices(), untrimmed_position_of(texture_1), untrimmed_position_of(texture_2), untrimmed_position_of(texture_3), 0, vertex_data);
 	}
 
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const Identifier& texture_1, const Identifier& texture_2, const Identifier& texture_3, const Identifier& texture_4)
 	{
-		push_sprite_to_buffer(vertices, m_TexturePack.position_of(texture_1), m_TexturePack.position_of(texture_2), m_TexturePack.position_of(texture_3), m_TexturePack.position_of(texture_4), c_EmptyVertexData);
+		push_sprite_to_buffer(vertices.vertices(), untrimmed_position_of(texture_1), untrimmed_position_of(texture_2), untrimmed_position_of(texture_3), untrimmed_position_of(texture_4), c_EmptyVertexData);
 	}
 	
 	//-------------------------------------------------------------------------------------
 
 	void SpriteRenderer::submit(const StaticMesh<4>& vertices, const Identifier& texture_1, const Identifier& texture_2, const Identifier& texture_3, const Identifier& texture_4, const glm::uvec4& vertex_data)
 	{
-		push_sprite_to_buffer(vertices, m_TexturePack.position_of(texture_1), m_TexturePack.position_of(texture_2), m_TexturePack.position_of(texture_3), m_TexturePack.position_of(texture_4), vertex_data);
+		push_sprite_to_buffer(vertices.vertices(), untrimmed_position_of(texture_1), untrimmed_position_of(texture_2), untrimmed_position_of(texture_3), untrimmed_position_of(texture_4), vertex_data);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void SpriteRenderer::submit(const std::array<glm::vec2, 4>& vertices, const Identifier& texture_1, const glm::uvec4& vertex_data)
+	{
+		TextureBounds bounds;
+		const uint32_t position = m_TexturePack.position_of(texture_1, bounds);
+		push_sprite_to_buffer(vertices, position, 0, 0, 0, vertex_data, bounds);
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -274,4 +321,13 @@ namespace cbn
 	}
 
 	//-------------------------------------------------------------------------------------
+
+	TexturePack& SpriteRenderer::texture_pack()
+	{
+		// Gives access to the renderer's own pack, so that textures 
+		// can be added or removed in place without copying the pack.
+		return m_TexturePack;
+	}
+
+	//-------------------------------------------------------------------------------------
 }
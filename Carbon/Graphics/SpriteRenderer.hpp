@@ -67,7 +67,13 @@ namespace cbn
 
 		void initialize_renderer(const Version& opengl_version);
 
-		void push_sprite_to_buffer(const StaticMesh<4>& quad, const uint16_t& index_1, const uint16_t& index_2, const uint16_t& index_3, const uint16_t& index_4, const glm::uvec4& vertex_data);
+		static bool is_trimmed(const TextureBounds& bounds);
+
+		static std::array<glm::vec2, 4> trim_quad(const std::array<glm::vec2, 4>& vertices, const TextureBounds& bounds);
+
+		uint32_t untrimmed_position_of(const Identifier& texture) const;
+
+		void push_sprite_to_buffer(const std::array<glm::vec2, 4>& quad, const uint16_t& index_1, const uint16_t& index_2, const uint16_t& index_3, const uint16_t& index_4, const glm::uvec4& vertex_data, const TextureBounds& bounds = {});
 
 	public:
 
@@ -86,6 +92,10 @@ namespace cbn
 		void submit(const StaticMesh<4>& quad, const Identifier& texture_1, const Identifier& texture_2, const Identifier& texture_3, const Identifier& texture_4);
 		void submit(const StaticMesh<4>& quad, const Identifier& texture_1, const Identifier& texture_2, const Identifier& texture_3, const Identifier& texture_4, const glm::uvec4& vertex_data);
 
+		// Submits a quad straight from its world space vertices, in the same order as the vertices 
+		// of a StaticMesh<4>. This skips building a mesh, for callers emitting many small quads.
+		void submit(const std::array<glm::vec2, 4>& vertices, const Identifier& texture_1, const glm::uvec4& vertex_data);
+
 		void end_batch();
 
 		void render(const SRes<ShaderProgram>& shader);
@@ -100,5 +110,7 @@ namespace cbn
 
 		void set_texture_pack(const TexturePack& textures);
 
+		TexturePack& texture_pack();
+
 	};
 }
@@ -1,5 +1,11 @@
 #include "TexturePack.hpp"
 
+#include <unordered_set>
+#include <algorithm>
+#include <iterator>
+#include <cstring>
+#include <cmath>
+
 #include "../Utility/Enum.hpp"
 
 namespace cbn
@@ -12,17 +18,88 @@ namespace cbn
             hardware. However its incredibly unlikely that a game would even have that many textures, and that the limit
             would even be 65536 anyway. My gpu currently supports 134217728 texels. 
 
-            Possible Optimisations to Space (and Cache?):
-                - Smaller data types. This is possible, since we do not actually need a full 32bit float for the
-                data. Specially since the texture index only goes up to 15 currently or 31 in the future. The only 
-                downside is maybe we have to divide in the shader, or have to deal with half floats but its
-                not really an issue tbh. 
+            Encodings:
+                - FLOAT stores four vec3 texels per texture, one for each corner, holding the uv and the texture
+                index. It is 48 bytes per texture, and is read with a samplerBuffer. 
+                - PACKED stores a single RGBA32UI texel per texture (16 bytes). The first three channels hold the
+                uvs of the first three corners as 16 bit normalized pairs (u in the low bits), and the last channel
+                holds the 8 bit texture index. The fourth corner is reconstructed as uv_1 + uv_3 - uv_2, which is
+                exact for any parallelogram, so rotated and flipped uvs still work. 
+                - PACKED_RECT stores a single RGB32UI texel per texture (12 bytes). The first two channels hold the
+                minimum and maximum uv of the rectangle, and the last holds the texture index in the low 8 bits and 
+                the number of corners the uvs are rotated by in the next 8 bits. The uvs must form a rectangle. 
+
+            With the packed encodings, the position given to the shader is still 4 * index + corner, so that the
+            renderer does not need to know about the encoding. The shader must then fetch the (position >> 2)th
+            texel with a usamplerBuffer and decode the corner given by (position & 3). The decoders for every
+            encoding are provided below, so that shaders never have to duplicate them. 
     
     */
 
     //-------------------------------------------------------------------------------------
 
-    TexturePack::DataLayout TexturePack::pack_data(const TextureUVMap& uvs, const uint64_t texture_index)
+    constexpr std::string_view c_FloatDecoderSource =
+        "vec3 decode_texture_data(samplerBuffer data, uint position)\n"
+        "{\n"
+        "	return texelFetch(data, int(position)).xyz;\n"
+        "}\n";
+
+    constexpr std::string_view c_PackedDecoderSource =
+        "vec2 unpack_uv(uint packed_uv)\n"
+        "{\n"
+        "	return vec2(float(packed_uv & 0xFFFFu), float(packed_uv >> 16u)) / 65535.0;\n"
+        "}\n"
+        "vec3 decode_texture_data(usamplerBuffer data, uint position)\n"
+        "{\n"
+        "	uvec4 texel = texelFetch(data, int(position >> 2u));\n"
+        "	uint corner = position & 3u;\n"
+        "	vec2 uv = corner == 3u\n"
+        "		? unpack_uv(texel.x) + unpack_uv(texel.z) - unpack_uv(texel.y)\n"
+        "		: unpack_uv(texel[corner]);\n"
+        "	return vec3(uv, float(texel.w & 0xFFu));\n"
+        "}\n";
+
+    // The rectangle's corners are ordered as in the uv map, (min, min), (min, max), (max, max)
+    // then (max, min), and rotated uvs start from the corner given by the rotation.
+    constexpr std::string_view c_PackedRectDecoderSource =
+        "vec2 unpack_uv(uint packed_uv)\n"
+        "{\n"
+        "	return vec2(float(packed_uv & 0xFFFFu), float(packed_uv >> 16u)) / 65535.0;\n"
+        "}\n"
+        "vec3 decode_texture_data(usamplerBuffer data, uint position)\n"
+        "{\n"
+        "	uvec3 texel = texelFetch(data, int(position >> 2u)).xyz;\n"
+        "	uint corner = ((position & 3u) + ((texel.z >> 8u) & 0xFFu)) & 3u;\n"
+        "	vec2 min_uv = unpack_uv(texel.x);\n"
+        "	vec2 max_uv = unpack_uv(texel.y);\n"
+        "	vec2 uv = vec2(corner < 2u ? min_uv.x : max_uv.x, (corner == 1u || corner == 2u) ? max_uv.y : min_uv.y);\n"
+        "	return vec3(uv, float(texel.z & 0xFFu));\n"
+        "}\n";
+
+    //-------------------------------------------------------------------------------------
+
+    std::string_view TexturePack::DecoderSource(const TexturePackEncoding encoding)
+    {
+        switch(encoding)
+        {
+            case TexturePackEncoding::PACKED: return c_PackedDecoderSource;
+            case TexturePackEncoding::PACKED_RECT: return c_PackedRectDecoderSource;
+            default: return c_FloatDecoderSource;
+        }
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    uint32_t TexturePack::pack_uv(const glm::vec2& uv)
+    {
+        const uint32_t u = static_cast<uint32_t>(std::round(std::clamp(uv.x, 0.0f, 1.0f) * 65535.0f));
+        const uint32_t v = static_cast<uint32_t>(std::round(std::clamp(uv.y, 0.0f, 1.0f) * 65535.0f));
+        return u | (v << 16);
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    TexturePack::DataLayout TexturePack::pack_data(const TextureUVMap& uvs, const uint64_t texture_index) const
     {
         const glm::vec3 texture_data_1 = {
             uvs.uv_1.x,
@@ -53,87 +130,293 @@ namespace cbn
     
     //-------------------------------------------------------------------------------------
 
-    void TexturePack::initialize(const std::array<TexturePackEntry, SupportedTextureCount>& textures)
+    TexturePack::PackedDataLayout TexturePack::pack_data_compact(const TextureUVMap& uvs, const uint64_t texture_index) const
+    {
+        CBN_Assert(texture_index <= 0xFF, "Texture index does not fit in the packed encoding");
+
+        return {pack_uv(uvs.uv_1), pack_uv(uvs.uv_2), pack_uv(uvs.uv_3), static_cast<uint32_t>(texture_index)};
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    TexturePack::PackedRectDataLayout TexturePack::pack_data_rect(const TextureUVMap& uvs, const uint64_t texture_index) const
     {
-        std::vector<DataLayout> buffer_texture_data;
+        CBN_Assert(texture_index <= 0xFF, "Texture index does not fit in the packed encoding");
+
+        const std::array<glm::vec2, 4> corners = {uvs.uv_1, uvs.uv_2, uvs.uv_3, uvs.uv_4};
+        const glm::vec2 min_uv = glm::min(glm::min(uvs.uv_1, uvs.uv_2), glm::min(uvs.uv_3, uvs.uv_4));
+        const glm::vec2 max_uv = glm::max(glm::max(uvs.uv_1, uvs.uv_2), glm::max(uvs.uv_3, uvs.uv_4));
+
+        // The corners of the rectangle, in the same order as the uv map (top left, bottom left, bottom right,
+        // top right). Rotated uvs are the same corners shifted along, so we find how far they were shifted.
+        const std::array<glm::vec2, 4> rect_corners = {
+            glm::vec2{min_uv.x, min_uv.y},
+            glm::vec2{min_uv.x, max_uv.y},
+            glm::vec2{max_uv.x, max_uv.y},
+            glm::vec2{max_uv.x, min_uv.y}
+        };
 
-        // Record texture data and set up the data for the buffer texture
-        for(const auto& [identity, entry] : textures)
+        uint32_t rotation = 0;
+        for(; rotation < 4; rotation++)
         {
-            // If the entry is empty, skip this iteration
-            if(std::holds_alternative<std::monostate>(entry))
-                continue;
+            bool matches = true;
+            for(uint32_t k = 0; k < 4; k++)
+                matches &= corners[k] == rect_corners[(k + rotation) % 4];
+
+            if(matches)
+                break;
+        }
 
-            SRes<Texture> texture;
-            auto uv_index = m_TextureUVs.size();
-            auto data_index = buffer_texture_data.size();
-            const auto texture_index = m_Textures.size();
+        CBN_Assert(rotation < 4, "Texture uvs cannot be encoded as a rotated rectangle");
 
-            if(std::holds_alternative<SRes<TextureAtlas>>(entry))
+        return {pack_uv(min_uv), pack_uv(max_uv), static_cast<uint32_t>(texture_index) | ((rotation % 4) << 8)};
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    void TexturePack::encode_data(const TextureRecord& record, uint8_t* destination) const
+    {
+        switch(m_Encoding)
+        {
+            case TexturePackEncoding::PACKED:
+            {
+                const auto data = pack_data_compact(record.uvs, record.texture_index);
+                std::memcpy(destination, &data, sizeof(data));
+                break;
+            }
+            case TexturePackEncoding::PACKED_RECT:
+            {
+                const auto data = pack_data_rect(record.uvs, record.texture_index);
+                std::memcpy(destination, &data, sizeof(data));
+                break;
+            }
+            default:
             {
-                const auto& atlas = std::get<SRes<TextureAtlas>>(entry);
-
-                // If we have a texture atlas, we need to individually add each subtexture's uvs.
-                // We also want to texture equal to the backing texture of the atlas so that
-                // it is added as if it were a normal texture. 
-
-                const auto& subtextures = atlas->subtextures();
-                for(const auto& subtexture : subtextures)
-                {
-                    CBN_Assert(m_TextureLookupMap.count(subtexture.identifier()) == 0, "Duplicate texture identifier found");
-
-                    // Add subtexture name and uv data
-                    m_TextureUVs.push_back(subtexture.uvs);
-                    m_TextureNames.push_back(subtexture.identifier().alias());
-                    m_UVLookupMap[subtexture.identifier()] = uv_index++;
-                    m_TextureLookupMap[subtexture.identifier()] = texture_index;
-
-                    // Add subtexture data to the buffer texture data
-                    buffer_texture_data.push_back(pack_data(subtexture.uvs, texture_index));
-                    m_DataIndexLookupMap[subtexture.identifier()] = 4 * data_index;
-                    data_index++;
-
-                    // Set the backing texture
-                    texture = atlas->as_texture();
-                }
+                const auto data = pack_data(record.uvs, record.texture_index);
+                std::memcpy(destination, &data, sizeof(data));
+                break;
             }
-            else texture = std::get<SRes<Texture>>(entry);
+        }
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    uint64_t TexturePack::data_size() const
+    {
+        switch(m_Encoding)
+        {
+            case TexturePackEncoding::PACKED: return sizeof(PackedDataLayout);
+            case TexturePackEncoding::PACKED_RECT: return sizeof(PackedRectDataLayout);
+            default: return sizeof(DataLayout);
+        }
+    }
+    
+    //-------------------------------------------------------------------------------------
 
-            CBN_Assert(m_TextureLookupMap.count(identity) == 0, "Duplicate texture identifier found");
+    BufferTextureDataFormat TexturePack::data_format() const
+    {
+        switch(m_Encoding)
+        {
+            case TexturePackEncoding::PACKED: return BufferTextureDataFormat::VEC4_32U;
+            case TexturePackEncoding::PACKED_RECT: return BufferTextureDataFormat::VEC3_32U;
+            default: return BufferTextureDataFormat::VEC3_F;
+        }
+    }
+    
+    //-------------------------------------------------------------------------------------
 
-            // Add the normal texture name and uv data
-            const auto texture_uvs = texture->uvs();
-            m_TextureUVs.push_back(texture_uvs);
-            m_TextureNames.push_back(identity.alias());
-            m_UVLookupMap[identity] = uv_index;
+    std::vector<TexturePack::TextureMember> TexturePack::collect_members(const TexturePackEntry& entry, SRes<Texture>& texture) const
+    {
+        std::vector<TextureMember> members;
 
-            m_Textures.push_back(texture);
-            m_TextureLookupMap[identity] = texture_index;
+        // If we have a texture atlas, we need to individually add each subtexture's uvs.
+        // We also want the texture to equal the backing texture of the atlas so that
+        // it is added as if it were a normal texture. 
+        if(std::holds_alternative<SRes<TextureAtlas>>(entry.texture))
+        {
+            const auto& atlas = std::get<SRes<TextureAtlas>>(entry.texture);
+            for(const auto& subtexture : atlas->subtextures())
+                members.push_back({subtexture.identifier(), subtexture.uvs, subtexture.bounds()});
 
-            // Add texture data to the buffer texture data
-            buffer_texture_data.push_back(pack_data(texture_uvs, texture_index));
-            m_DataIndexLookupMap[identity] = 4 * data_index;
-            data_index++;
+            texture = atlas->as_texture();
         }
+        else texture = std::get<SRes<Texture>>(entry.texture);
+
+        // The entry itself always refers to the whole texture
+        members.push_back({entry.identifier, texture->uvs(), TextureBounds{}});
+        return members;
+    }
 
-        // If no textures were actually supplied, then the texture pack is empty
-        m_Empty = buffer_texture_data.empty();
+    //-------------------------------------------------------------------------------------
+
+    void TexturePack::write_record(const Identifier& identifier, const TextureRecord& record)
+    {
+        m_Records[identifier] = record;
+        m_PendingData[record.data_index] = record;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    uint32_t TexturePack::acquire_data_index()
+    {
+        // Re-use the data of removed textures before growing the buffer
+        if(!m_FreeDataIndices.empty())
+        {
+            const uint32_t data_index = m_FreeDataIndices.back();
+            m_FreeDataIndices.pop_back();
+            return data_index;
+        }
+        return m_DataCount++;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TexturePack::reserve_data(const uint32_t data_count)
+    {
+        // Copies of the pack share the same buffer texture, so it must be made unique 
+        // before we write to it. Otherwise we would also change the data of the copies.
+        const bool shared = m_BufferTexture && m_BufferTexture.use_count() > 1;
+        if(data_count <= m_DataCapacity && !shared)
+            return true;
+
+        // Grow geometrically so that adding textures one by one stays cheap
+        uint32_t capacity = m_DataCapacity;
+        if(data_count > capacity)
+            capacity = std::max({data_count, capacity * 2, c_MinimumDataCapacity});
+
+        auto buffer_texture = BufferTexture::Reserve(capacity * data_size(), data_format(), m_OpenGLVersion);
+        if(!buffer_texture)
+            return false;
+
+        // Bring over the existing data on the GPU, without having to re-upload it
+        if(m_BufferTexture)
+            buffer_texture->copy(*m_BufferTexture, 0, 0, m_BufferTexture->size());
+
+        m_BufferTexture = buffer_texture;
+        m_DataCapacity = capacity;
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TexturePack::flush_data()
+    {
+        if(m_PendingData.empty())
+            return true;
+
+        if(!reserve_data(m_DataCount))
+        {
+            m_PendingData.clear();
+            return false;
+        }
+
+        // The pending data is ordered by index, so we can upload it in contiguous runs.
+        // Adding a texture usually appends to the end, so this tends to be a single upload.
+        const uint64_t stride = data_size();
+        std::vector<uint8_t> run;
+        uint32_t run_start = 0, run_length = 0;
+        for(const auto& [data_index, record] : m_PendingData)
+        {
+            if(run_length > 0 && data_index != run_start + run_length)
+            {
+                m_BufferTexture->upload(run.data(), run.size(), run_start * stride);
+                run_length = 0;
+                run.clear();
+            }
+
+            if(run_length == 0)
+                run_start = data_index;
+
+            run.resize(run.size() + stride);
+            encode_data(record, run.data() + run_length * stride);
+            run_length++;
+        }
+        m_BufferTexture->upload(run.data(), run.size(), run_start * stride);
+
+        m_PendingData.clear();
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TexturePack::insert(const TexturePackEntry& entry)
+    {
+        // If the entry is empty, there is nothing to add
+        if(std::holds_alternative<std::monostate>(entry.texture))
+            return false;
+
+        SRes<Texture> texture;
+        const auto members = collect_members(entry, texture);
+        for(const auto& [identity, uvs, bounds] : members)
+            if(contains(identity))
+                return false;
+
+        // Texture indices must stay stable, so removed textures leave 
+        // a gap in the texture units which is filled in by the next one. 
+        auto free_slot = std::find(m_Textures.begin(), m_Textures.end(), nullptr);
+        if(free_slot == m_Textures.end())
+        {
+            if(m_Textures.size() >= SupportedTextureCount)
+                return false;
+
+            free_slot = m_Textures.insert(m_Textures.end(), nullptr);
+        }
+        *free_slot = texture;
+
+        const uint32_t texture_index = std::distance(m_Textures.begin(), free_slot);
+
+        auto& identifiers = m_EntryMembers[entry.identifier];
+        for(const auto& [identity, uvs, bounds] : members)
+        {
+            write_record(identity, {texture_index, acquire_data_index(), uvs, bounds});
+            identifiers.push_back(identity);
+        }
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    void TexturePack::clear()
+    {
+        // Note that the buffer texture is kept so that its storage can be re-used
+        m_Textures.clear();
+        m_Records.clear();
+        m_EntryMembers.clear();
+        m_PendingData.clear();
+        m_FreeDataIndices.clear();
+        m_DataCount = 0;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    void TexturePack::initialize(const std::array<TexturePackEntry, SupportedTextureCount>& textures)
+    {
+        // All of the data is gathered first, so that it can be uploaded in one go
+        for(const auto& entry : textures)
+        {
+            if(!insert(entry))
+                CBN_Assert(std::holds_alternative<std::monostate>(entry.texture), "Duplicate texture identifier found");
+        }
 
-        // Upload data to the buffer texture, unless its empty
-        if(!m_Empty)
-            m_BufferTexture = BufferTexture::Allocate(reinterpret_cast<uint8_t*>(buffer_texture_data.data()), buffer_texture_data.size() * sizeof(DataLayout), BufferTextureDataFormat::VEC3_F, m_OpenGLVersion);
+        flush_data();
     }
     
     //-------------------------------------------------------------------------------------
 
-    TexturePack::TexturePack(const Version& opengl_version)
+    TexturePack::TexturePack(const Version& opengl_version, const TexturePackEncoding encoding)
         : m_OpenGLVersion(opengl_version),
-        m_Empty(true) {}
+        m_Encoding(encoding),
+        m_DataCapacity(0),
+        m_DataCount(0) {}
     
     //-------------------------------------------------------------------------------------
 
-    TexturePack::TexturePack(const std::array<TexturePackEntry, SupportedTextureCount>& textures, const Version& opengl_version)
-        : m_OpenGLVersion(opengl_version)
+    TexturePack::TexturePack(const std::array<TexturePackEntry, SupportedTextureCount>& textures, const Version& opengl_version, const TexturePackEncoding encoding)
+        : m_OpenGLVersion(opengl_version),
+        m_Encoding(encoding),
+        m_DataCapacity(0),
+        m_DataCount(0)
     {
         initialize(textures);
     }
@@ -142,46 +425,278 @@ namespace cbn
 
     TexturePack::TexturePack(const TexturePack& other)
         : m_OpenGLVersion(other.m_OpenGLVersion),
+        m_Encoding(other.m_Encoding),
         m_BufferTexture(other.m_BufferTexture),
-        m_TextureNames(other.m_TextureNames),
+        m_DataCapacity(other.m_DataCapacity),
+        m_DataCount(other.m_DataCount),
+        m_FreeDataIndices(other.m_FreeDataIndices),
         m_Textures(other.m_Textures),
-        m_Empty(other.m_Empty),
-        m_TextureUVs(other.m_TextureUVs),
-        m_UVLookupMap(other.m_UVLookupMap),
-        m_TextureLookupMap(other.m_TextureLookupMap),
-        m_DataIndexLookupMap(other.m_DataIndexLookupMap)
+        m_Records(other.m_Records),
+        m_EntryMembers(other.m_EntryMembers)
     {}
 
     //-------------------------------------------------------------------------------------
 
     void TexturePack::operator=(const TexturePack& other)
     {
-        m_DataIndexLookupMap = other.m_DataIndexLookupMap;
-        m_TextureLookupMap = other.m_TextureLookupMap;
+        m_FreeDataIndices = other.m_FreeDataIndices;
         m_OpenGLVersion = other.m_OpenGLVersion;
         m_BufferTexture = other.m_BufferTexture;
-        m_TextureNames = other.m_TextureNames;
-        m_UVLookupMap = other.m_UVLookupMap;
-        m_TextureUVs = other.m_TextureUVs;
+        m_Encoding = other.m_Encoding;
+        m_EntryMembers = other.m_EntryMembers;
+        m_DataCapacity = other.m_DataCapacity;
+        m_DataCount = other.m_DataCount;
         m_Textures = other.m_Textures;
-        m_Empty = other.m_Empty;
+        m_Records = other.m_Records;
+        m_PendingData.clear();
     }
     
     //-------------------------------------------------------------------------------------
 
     void TexturePack::operator=(const std::array<TexturePackEntry, SupportedTextureCount>& textures)
     {
-        // Clear all current texture data 
-        m_Textures.clear();
-        m_TextureUVs.clear();
-        m_TextureNames.clear();
+        // Clear all current texture data then re-initialize the texture pack
+        clear();
+        initialize(textures);
+    }
 
-        m_UVLookupMap.clear();
-        m_TextureLookupMap.clear();
-        m_DataIndexLookupMap.clear();
+    //-------------------------------------------------------------------------------------
 
-        // re-initialize the texture pack
-        initialize(textures);
+    bool TexturePack::add(const TexturePackEntry& entry)
+    {
+        const std::vector<uint32_t> free_data_indices = m_FreeDataIndices;
+        const uint32_t data_count = m_DataCount;
+
+        if(!insert(entry))
+            return false;
+
+        // If the data cannot be uploaded, the entry is removed again so that it can be retried
+        if(!flush_data())
+        {
+            remove(entry.identifier);
+            m_FreeDataIndices = free_data_indices;
+            m_DataCount = data_count;
+            return false;
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TexturePack::add(const Identifier& identifier, const std::vector<SRes<TextureAtlas>>& pages)
+    {
+        // Each page takes up its own texture unit, so it is added as a separate entry
+        // named after its index e.g. 'sprites:0'. The pages are added all or nothing,
+        // so if any page fails, or their data cannot be uploaded, then the pages which 
+        // were already added are removed and their data indices are given back.
+        const std::vector<uint32_t> free_data_indices = m_FreeDataIndices;
+        const uint32_t data_count = m_DataCount;
+
+        std::vector<Identifier> added;
+        const auto rollback = [&]()
+        {
+            for(const auto& page : added)
+                remove(page);
+
+            m_FreeDataIndices = free_data_indices;
+            m_DataCount = data_count;
+            m_PendingData.clear();
+            return false;
+        };
+
+        for(size_t i = 0; i < pages.size(); i++)
+        {
+            const Identifier page_identifier(identifier.alias().as_std_string() + ":" + std::to_string(i));
+            if(!insert({page_identifier, pages[i]}))
+                return rollback();
+
+            added.push_back(page_identifier);
+        }
+
+        if(added.empty())
+            return false;
+
+        return flush_data() || rollback();
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TexturePack::remove(const Identifier& entry_identifier)
+    {
+        if(!m_EntryMembers.count(entry_identifier))
+            return false;
+
+        const uint32_t texture_index = m_Records.at(entry_identifier).texture_index;
+
+        // The data of the removed textures is left in the buffer texture, since nothing
+        // should refer to it anymore, and will be overwritten once its index is re-used.
+        for(const auto& identity : m_EntryMembers.at(entry_identifier))
+        {
+            m_FreeDataIndices.push_back(m_Records.at(identity).data_index);
+            m_Records.erase(identity);
+        }
+        m_EntryMembers.erase(entry_identifier);
+
+        // Free up the texture unit, trailing free units can be dropped entirely
+        m_Textures[texture_index] = nullptr;
+        while(!m_Textures.empty() && m_Textures.back() == nullptr)
+            m_Textures.pop_back();
+
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TexturePack::replace(const TexturePackEntry& entry)
+    {
+        if(!m_EntryMembers.count(entry.identifier) || std::holds_alternative<std::monostate>(entry.texture))
+            return false;
+
+        SRes<Texture> texture;
+        const auto members = collect_members(entry, texture);
+        auto& identifiers = m_EntryMembers.at(entry.identifier);
+
+        // The new texture may not take identifiers which belong to other entries
+        const std::unordered_set<Identifier> previous_identifiers(identifiers.begin(), identifiers.end());
+        for(const auto& [identity, uvs, bounds] : members)
+            if(contains(identity) && !previous_identifiers.count(identity))
+                return false;
+
+        // The previous state of the entry is kept, so that it can be restored if the upload fails
+        const std::vector<Identifier> previous_members = identifiers;
+        std::vector<std::pair<Identifier, TextureRecord>> previous_records;
+        for(const auto& identity : previous_members)
+            previous_records.emplace_back(identity, m_Records.at(identity));
+
+        const std::vector<uint32_t> free_data_indices = m_FreeDataIndices;
+        const uint32_t data_count = m_DataCount;
+
+        // The replacement takes over the texture unit of the previous texture
+        const uint32_t texture_index = m_Records.at(entry.identifier).texture_index;
+        const SRes<Texture> previous_texture = m_Textures[texture_index];
+        m_Textures[texture_index] = texture;
+
+        // Identifiers which no longer exist give up their data index. The rest keep their 
+        // index, so that any references to them stay valid, and are only re-uploaded if 
+        // their uvs changed. Replacing a plain texture therefore needs no upload at all. 
+        std::unordered_set<Identifier> current_identifiers;
+        for(const auto& [identity, uvs, bounds] : members)
+            current_identifiers.insert(identity);
+
+        for(const auto& identity : identifiers)
+        {
+            if(!current_identifiers.count(identity))
+            {
+                m_FreeDataIndices.push_back(m_Records.at(identity).data_index);
+                m_Records.erase(identity);
+            }
+        }
+
+        identifiers.clear();
+        for(const auto& [identity, uvs, bounds] : members)
+        {
+            identifiers.push_back(identity);
+
+            const auto existing = m_Records.find(identity);
+            if(existing == m_Records.end())
+            {
+                write_record(identity, {texture_index, acquire_data_index(), uvs, bounds});
+            }
+            else
+            {
+                // The bounds are only used on the CPU, so they never need to be uploaded
+                const auto& previous_uvs = existing->second.uvs;
+                if(previous_uvs.uv_1 != uvs.uv_1 || previous_uvs.uv_2 != uvs.uv_2 
+                || previous_uvs.uv_3 != uvs.uv_3 || previous_uvs.uv_4 != uvs.uv_4)
+                    write_record(identity, {texture_index, existing->second.data_index, uvs, bounds});
+                else
+                    existing->second.bounds = bounds;
+            }
+        }
+
+        if(!flush_data())
+        {
+            for(const auto& identity : identifiers)
+                m_Records.erase(identity);
+            for(const auto& [identity, record] : previous_records)
+                m_Records[identity] = record;
+
+            identifiers = previous_members;
+            m_Textures[texture_index] = previous_texture;
+            m_FreeDataIndices = free_data_indices;
+            m_DataCount = data_count;
+            return false;
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TexturePack::set_region(const Identifier& entry_identifier, const Identifier& region_identifier, const TextureUVMap& uvs, const TextureBounds& bounds)
+    {
+        if(!m_EntryMembers.count(entry_identifier) || m_EntryMembers.count(region_identifier))
+            return false;
+
+        // Every entry has its own texture unit, so the texture index identifies the entry
+        const uint32_t texture_index = m_Records.at(entry_identifier).texture_index;
+
+        const auto existing = m_Records.find(region_identifier);
+        if(existing == m_Records.end())
+        {
+            const uint32_t data_count = m_DataCount;
+            const uint32_t data_index = acquire_data_index();
+            write_record(region_identifier, {texture_index, data_index, uvs, bounds});
+            m_EntryMembers.at(entry_identifier).push_back(region_identifier);
+
+            // If the data cannot be uploaded, the new region is dropped and gives back its index
+            if(!flush_data())
+            {
+                m_Records.erase(region_identifier);
+                m_EntryMembers.at(entry_identifier).pop_back();
+                if(m_DataCount != data_count)
+                    m_DataCount = data_count;
+                else
+                    m_FreeDataIndices.push_back(data_index);
+                return false;
+            }
+        }
+        else
+        {
+            if(existing->second.texture_index != texture_index)
+                return false;
+
+            // If the data cannot be uploaded, the region keeps its previous uvs
+            const TextureRecord previous_record = existing->second;
+            write_record(region_identifier, {texture_index, previous_record.data_index, uvs, bounds});
+            if(!flush_data())
+            {
+                m_Records[region_identifier] = previous_record;
+                return false;
+            }
+        }
+        return true;
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    bool TexturePack::remove_region(const Identifier& region_identifier)
+    {
+        const auto record = m_Records.find(region_identifier);
+        if(record == m_Records.end() || m_EntryMembers.count(region_identifier))
+            return false;
+
+        for(auto& [entry_identifier, identifiers] : m_EntryMembers)
+        {
+            if(m_Records.at(entry_identifier).texture_index == record->second.texture_index)
+            {
+                std::erase(identifiers, region_identifier);
+                break;
+            }
+        }
+
+        m_FreeDataIndices.push_back(record->second.data_index);
+        m_Records.erase(record);
+        return true;
     }
 
     //-------------------------------------------------------------------------------------
@@ -190,7 +705,7 @@ namespace cbn
     {
         CBN_Assert(contains(texture_identifier), "No texture with the given identity exists");
 
-        return m_Textures[m_TextureLookupMap.at(texture_identifier)];
+        return m_Textures[m_Records.at(texture_identifier).texture_index];
     }
     
     //-------------------------------------------------------------------------------------
@@ -199,7 +714,7 @@ namespace cbn
     {
         CBN_Assert(contains(texture_identifier), "No texture with the given identity exists");
         
-        return m_TextureUVs[m_TextureLookupMap.at(texture_identifier)];
+        return m_Records.at(texture_identifier).uvs;
     }
     
     //-------------------------------------------------------------------------------------
@@ -208,56 +723,103 @@ namespace cbn
     {
         CBN_Assert(contains(texture_identifier), "No texture with the given identity exists");
 
-        return m_DataIndexLookupMap.at(texture_identifier);
+        // Each entry of data is made up of four texels, one for each corner
+        return 4 * m_Records.at(texture_identifier).data_index;
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    uint32_t TexturePack::position_of(const Identifier& texture_identifier, TextureBounds& bounds) const
+    {
+        CBN_Assert(contains(texture_identifier), "No texture with the given identity exists");
+
+        // This gives both from a single lookup, since they are both needed for every sprite
+        const auto& record = m_Records.at(texture_identifier);
+        bounds = record.bounds;
+        return 4 * record.data_index;
+    }
+    
+    //-------------------------------------------------------------------------------------
+
+    const TextureBounds TexturePack::bounds_of(const Identifier& texture_identifier) const
+    {
+        CBN_Assert(contains(texture_identifier), "No texture with the given identity exists");
+
+        return m_Records.at(texture_identifier).bounds;
     }
     
     //-------------------------------------------------------------------------------------
 
     const std::vector<SRes<Texture>> TexturePack::textures() const
     {
-        return m_Textures;
+        std::vector<SRes<Texture>> textures;
+        std::copy_if(m_Textures.begin(), m_Textures.end(), std::back_inserter(textures), [](const auto& texture)
+        {
+            return texture != nullptr;
+        });
+        return textures;
     }
 
     //-------------------------------------------------------------------------------------
 
     const std::vector<String> TexturePack::texture_names() const
     {
-        return m_TextureNames;
+        std::vector<String> names;
+        names.reserve(m_Records.size());
+        for(const auto& [identity, record] : m_Records)
+            names.push_back(identity.alias());
+
+        return names;
     }
 
     //-------------------------------------------------------------------------------------
 
-    const std::vector<TextureUVMap>& TexturePack::uvs() const
+    const std::vector<TextureUVMap> TexturePack::uvs() const
     {
-        return m_TextureUVs;
+        std::vector<TextureUVMap> uvs;
+        uvs.reserve(m_Records.size());
+        for(const auto& [identity, record] : m_Records)
+            uvs.push_back(record.uvs);
+
+        return uvs;
     }
 
     //-------------------------------------------------------------------------------------
 
     bool TexturePack::contains(const Identifier& texture_name) const
     {
-        return m_TextureLookupMap.count(texture_name);
+        return m_Records.count(texture_name);
     }
 
     //-------------------------------------------------------------------------------------
 
     int TexturePack::texture_resource_count() const
     {
-        return m_Textures.size();
+        return std::count_if(m_Textures.begin(), m_Textures.end(), [](const auto& texture)
+        {
+            return texture != nullptr;
+        });
     }
 
     //-------------------------------------------------------------------------------------
 
     int TexturePack::texture_count() const
     {
-        return m_TextureLookupMap.size();
+        return m_Records.size();
     }
     
     //-------------------------------------------------------------------------------------
 
     bool TexturePack::is_empty() const
     {
-        return m_Empty;
+        return m_Records.empty();
+    }
+
+    //-------------------------------------------------------------------------------------
+
+    TexturePackEncoding TexturePack::encoding() const
+    {
+        return m_Encoding;
     }
 
     //-------------------------------------------------------------------------------------
@@ -271,9 +833,10 @@ namespace cbn
         // be bound to one unit, so the units cannot overlap as the sampler can only be bound to one type. 
 
         GLint texture_unit_offset = 1;
-        return !m_Empty && m_BufferTexture->is_bound(TextureUnit::UNIT_0) && std::all_of(m_Textures.begin(), m_Textures.end(), [&](const auto& texture)
+        return !is_empty() && m_BufferTexture->is_bound(TextureUnit::UNIT_0) && std::all_of(m_Textures.begin(), m_Textures.end(), [&](const auto& texture)
         {
-            return texture->is_bound(to_enum<TextureUnit>(texture_unit_offset++));
+            const auto texture_unit = to_enum<TextureUnit>(texture_unit_offset++);
+            return texture == nullptr || texture->is_bound(texture_unit);
         });
     }
 
@@ -285,7 +848,8 @@ namespace cbn
 
         m_BufferTexture->unbind();
         for(const auto& texture : m_Textures)
-            texture->unbind();
+            if(texture != nullptr)
+                texture->unbind();
     }
 
     //-------------------------------------------------------------------------------------
@@ -298,9 +862,14 @@ namespace cbn
         // remaining units. In the order that they are stored in the m_Textures vector. They must be bound in 
         // this exact order, otherwise the data in the buffer texture will not match up in the shader. 
 
+        // Removed textures leave gaps, whose texture units are simply skipped over.
         m_BufferTexture->bind(TextureUnit::UNIT_0);
         for(GLint texture_unit_offset = 1; const auto& texture : m_Textures)
-            texture->bind(to_enum<TextureUnit>(texture_unit_offset++));
+        {
+            const auto texture_unit = to_enum<TextureUnit>(texture_unit_offset++);
+            if(texture != nullptr)
+                texture->bind(texture_unit);
+        }
     }
 
     //-------------------------------------------------------------------------------------
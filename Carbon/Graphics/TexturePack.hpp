@@ -3,6 +3,8 @@
 #include <vector>
 #include <variant>
 #include <unordered_map>
+#include <map>
+#include <string_view>
 
 #include "../Data/Identity/Identifier.hpp"
 #include "Resources/ShaderProgram.hpp"
@@ -13,6 +15,13 @@
 
 namespace cbn
 {
+	enum class TexturePackEncoding
+	{
+		FLOAT,
+		PACKED,
+		PACKED_RECT
+	};
+
 	using TexturePackReference = std::variant<std::monostate, SRes<Texture>, SRes<TextureAtlas>>;
 	
 	struct TexturePackEntry
@@ -42,35 +51,115 @@ namespace cbn
 			glm::vec3 uv_data_4;
 		};
 
+		struct PackedDataLayout
+		{
+			uint32_t uv_1;
+			uint32_t uv_2;
+			uint32_t uv_3;
+			uint32_t texture_index;
+		};
+
+		struct PackedRectDataLayout
+		{
+			uint32_t min_uv;
+			uint32_t max_uv;
+			uint32_t texture_index_rotation;
+		};
+
 #pragma pack(pop)
 
-		bool m_Empty;
+		struct TextureRecord
+		{
+			uint32_t texture_index;
+			uint32_t data_index;
+			TextureUVMap uvs;
+			TextureBounds bounds;
+		};
+
+		struct TextureMember
+		{
+			Identifier identity;
+			TextureUVMap uvs;
+			TextureBounds bounds;
+		};
+
+		static constexpr uint32_t c_MinimumDataCapacity = 16;
+
 		Version m_OpenGLVersion;
+		TexturePackEncoding m_Encoding;
 		SRes<BufferTexture> m_BufferTexture;
+		uint32_t m_DataCapacity, m_DataCount;
+		std::vector<uint32_t> m_FreeDataIndices;
+		std::map<uint32_t, TextureRecord> m_PendingData;
 
-		std::vector<String> m_TextureNames;
 		std::vector<SRes<Texture>> m_Textures;
-		std::vector<TextureUVMap> m_TextureUVs;
-		
-		IdentityMap<uint32_t> m_UVLookupMap;
-		IdentityMap<uint32_t> m_TextureLookupMap;
-		IdentityMap<uint32_t> m_DataIndexLookupMap;
+		IdentityMap<TextureRecord> m_Records;
+		IdentityMap<std::vector<Identifier>> m_EntryMembers;
+
+		static uint32_t pack_uv(const glm::vec2& uv);
+
+		DataLayout pack_data(const TextureUVMap& uvs, const uint64_t texture_index) const;
+
+		PackedDataLayout pack_data_compact(const TextureUVMap& uvs, const uint64_t texture_index) const;
 
-		DataLayout pack_data(const TextureUVMap& uvs, const uint64_t texture_index);
+		PackedRectDataLayout pack_data_rect(const TextureUVMap& uvs, const uint64_t texture_index) const;
+
+		void encode_data(const TextureRecord& record, uint8_t* destination) const;
+
+		uint64_t data_size() const;
+
+		BufferTextureDataFormat data_format() const;
+
+		std::vector<TextureMember> collect_members(const TexturePackEntry& entry, SRes<Texture>& texture) const;
+
+		void write_record(const Identifier& identifier, const TextureRecord& record);
+
+		uint32_t acquire_data_index();
+
+		bool reserve_data(const uint32_t data_count);
+
+		bool flush_data();
+
+		bool insert(const TexturePackEntry& entry);
+
+		void clear();
 
 		void initialize(const std::array<TexturePackEntry, SupportedTextureCount>& textures);
 
 	public:
 
-		TexturePack(const Version& opengl_version);
+		TexturePack(const Version& opengl_version, const TexturePackEncoding encoding = TexturePackEncoding::FLOAT);
 
 		TexturePack(const TexturePack& other);
 
-		TexturePack(const std::array<TexturePackEntry, SupportedTextureCount>& textures, const Version& opengl_version);
+		TexturePack(const std::array<TexturePackEntry, SupportedTextureCount>& textures, const Version& opengl_version, const TexturePackEncoding encoding = TexturePackEncoding::FLOAT);
 		
 		void operator=(const std::array<TexturePackEntry, SupportedTextureCount>& textures);
 
 		void operator=(const TexturePack& other);
+
+		// GLSL source for decoding the pack data of the given encoding, which can be inserted into a
+		// shader after its version directive. It defines decode_texture_data(data, position), which
+		// takes the pack's buffer texture and the texture position given to the renderer, then returns
+		// the uv of that corner and its texture index. The buffer texture is a samplerBuffer for the
+		// FLOAT encoding and a usamplerBuffer for the packed encodings.
+		static std::string_view DecoderSource(const TexturePackEncoding encoding);
+
+		bool add(const TexturePackEntry& entry);
+
+		bool add(const Identifier& identifier, const std::vector<SRes<TextureAtlas>>& pages);
+
+		bool remove(const Identifier& entry_identifier);
+
+		bool replace(const TexturePackEntry& entry);
+
+		// Adds or updates a named region of an entry's texture, which can then be submitted like
+		// any other texture. This lets textures whose contents change at runtime, such as glyph
+		// caches, expose new sub-textures without replacing the whole entry. Regions are removed 
+		// along with their entry, and an existing region can only be updated by its own entry.
+		bool set_region(const Identifier& entry_identifier, const Identifier& region_identifier, const TextureUVMap& uvs, const TextureBounds& bounds = {});
+
+		bool remove_region(const Identifier& region_identifier);
 		
 		const SRes<Texture> texture_of(const Identifier& texture_identifier) const;
 
@@ -78,13 +167,17 @@ namespace cbn
 
 		unsigned position_of(const Identifier& texture_identifier) const;
 
+		unsigned position_of(const Identifier& texture_identifier, TextureBounds& bounds) const;
+
+		const TextureBounds bounds_of(const Identifier& texture_identifier) const;
+
 		bool contains(const Identifier& texture_identifier) const;
 
 		const std::vector<SRes<Texture>> textures() const;
 
 		const std::vector<String> texture_names() const;
 		
-		const std::vector<TextureUVMap>& uvs() const;
+		const std::vector<TextureUVMap> uvs() const;
 		
 		int texture_resource_count() const;
 
@@ -92,6 +185,8 @@ namespace cbn
 		
 		bool is_empty() const;
 
+		TexturePackEncoding encoding() const;
+
 		bool is_bound() const;
 
 		void unbind() const;
@@ -1,5 +1,7 @@
 #include "Window.hpp"
 
+#include "OpenGL/StateCache.hpp"
+
 namespace cbn
 {
 
@@ -209,9 +211,12 @@ namespace cbn
 		// which gets created. Especially if no OpenGL version was specified in the first place. 
 		window_properties.opengl_version = {static_cast<unsigned>(GLVersion.major), static_cast<unsigned>(GLVersion.minor)};
 
+		// The new context starts with default state, so the state cache must be reset
+		StateCache::Reset(window_properties.opengl_version);
+
 		// Enable colour blending, there no reason you wouldnt want this on
-		glEnable(GL_BLEND);
-		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		StateCache::SetBlending(true);
+		StateCache::SetBlendFunction(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 		// If we have made it here, then the window was successfully created
 		return Resource::WrapUnique(new Window(glfw_handle, window_properties));
@@ -0,0 +1,203 @@
+#include "MappedFile.hpp"
+
+#include "../Diagnostics/Assert.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace cbn
+{
+	//-------------------------------------------------------------------------------------
+
+#ifdef _WIN32
+
+	SRes<MappedFile> MappedFile::Open(const std::filesystem::path& path, const bool copy_on_write)
+	{
+		// The handle is only held until the file is mapped, but it is shared for deletion
+		// so that another thread can still replace the file while it is being opened. 
+		HANDLE file = CreateFileW(Resolve(path).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+		if(file == INVALID_HANDLE_VALUE)
+			return nullptr;
+
+		// Empty files cannot be mapped, so they are treated as a failure
+		LARGE_INTEGER size;
+		if(!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+		{
+			CloseHandle(file);
+			return nullptr;
+		}
+
+		// The mapping keeps its own reference to the file, so the handle is no longer needed
+		HANDLE mapping = CreateFileMappingW(file, nullptr, copy_on_write ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, nullptr);
+		CloseHandle(file);
+		if(mapping == nullptr)
+			return nullptr;
+
+		const void* data = MapViewOfFile(mapping, copy_on_write ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+		if(data == nullptr)
+		{
+			CloseHandle(mapping);
+			return nullptr;
+		}
+
+		return Resource::WrapShared(new MappedFile(static_cast<const uint8_t*>(data), size.QuadPart, copy_on_write, mapping));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	MappedFile::MappedFile(const uint8_t* data, const uint64_t size, const bool copy_on_write, void* mapping)
+		: m_Data(data),
+		m_Size(size),
+		m_CopyOnWrite(copy_on_write),
+		m_Mapping(mapping)
+	{}
+
+	//-------------------------------------------------------------------------------------
+
+	MappedFile::~MappedFile()
+	{
+		UnmapViewOfFile(m_Data);
+		CloseHandle(m_Mapping);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void MappedFile::prefetch() const
+	{
+		// This is only a hint, so it does not matter if it fails
+		WIN32_MEMORY_RANGE_ENTRY range = {const_cast<uint8_t*>(m_Data), m_Size};
+		PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+	}
+
+#else
+
+	SRes<MappedFile> MappedFile::Open(const std::filesystem::path& path, const bool copy_on_write)
+	{
+		const int file = open(Resolve(path).c_str(), O_RDONLY);
+		if(file < 0)
+			return nullptr;
+
+		// Empty files cannot be mapped, so they are treated as a failure
+		struct stat status;
+		if(fstat(file, &status) != 0 || status.st_size == 0)
+		{
+			close(file);
+			return nullptr;
+		}
+
+		// Private mappings are already copy-on-write, so they only need to allow writing
+		const int protection = copy_on_write ? PROT_READ | PROT_WRITE : PROT_READ;
+		// The mapping keeps its own reference to the file, so the descriptor is no longer needed
+		void* data = mmap(nullptr, status.st_size, protection, MAP_PRIVATE, file, 0);
+		close(file);
+		if(data == MAP_FAILED)
+			return nullptr;
+
+		return Resource::WrapShared(new MappedFile(static_cast<const uint8_t*>(data), status.st_size, copy_on_write));
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	MappedFile::MappedFile(const uint8_t* data, const uint64_t size, const bool copy_on_write)
+		: m_Data(data),
+		m_Size(size),
+		m_CopyOnWrite(copy_on_write)
+	{}
+
+	//-------------------------------------------------------------------------------------
+
+	MappedFile::~MappedFile()
+	{
+		munmap(const_cast<uint8_t*>(m_Data), m_Size);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	void MappedFile::prefetch() const
+	{
+		// This is only a hint, so it does not matter if it fails
+		madvise(const_cast<uint8_t*>(m_Data), m_Size, MADV_WILLNEED);
+	}
+
+#endif
+
+	//-------------------------------------------------------------------------------------
+
+	bool MappedFile::Replace(const std::filesystem::path& source, const std::filesystem::path& destination)
+	{
+		const auto pending_path = std::filesystem::path(destination).concat(c_PendingExtension);
+
+		// An older pending replacement must be removed, or it would later be moved over the new file
+		std::error_code error;
+		std::filesystem::remove(pending_path, error);
+		if(!error)
+		{
+			std::filesystem::rename(source, destination, error);
+			if(!error)
+				return true;
+
+			// The destination is most likely still mapped, so it is replaced later instead
+			std::filesystem::rename(source, pending_path, error);
+			if(!error)
+				return true;
+		}
+
+		std::filesystem::remove(source, error);
+		return false;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	std::filesystem::path MappedFile::Resolve(const std::filesystem::path& path)
+	{
+		const auto pending_path = std::filesystem::path(path).concat(c_PendingExtension);
+
+		std::error_code error;
+		if(!std::filesystem::exists(pending_path, error))
+			return path;
+
+		std::filesystem::rename(pending_path, path, error);
+		return error ? pending_path : path;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	const uint8_t* MappedFile::data() const
+	{
+		return m_Data;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint8_t* MappedFile::writable_data()
+	{
+		CBN_Assert(m_CopyOnWrite, "Cannot write to a read-only file mapping");
+
+		return const_cast<uint8_t*>(m_Data);
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	uint64_t MappedFile::size() const
+	{
+		return m_Size;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+	bool MappedFile::is_copy_on_write() const
+	{
+		return m_CopyOnWrite;
+	}
+
+	//-------------------------------------------------------------------------------------
+
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <filesystem>
+#include <stdint.h>
+
+#include "Resource.hpp"
+
+namespace cbn
+{
+
+	// A read-only view of a whole file, mapped directly into memory so that 
+	// its contents are paged in by the OS on demand instead of being copied.
+	// A copy-on-write mapping can also be written to, but any modified pages
+	// become private copies, so the changes never reach the file itself. 
+	class MappedFile
+	{
+	public:
+
+		// Opens the latest contents of the file, as given by Resolve
+		static SRes<MappedFile> Open(const std::filesystem::path& path, const bool copy_on_write = false);
+
+		// Moves a newly written file over the destination. Windows cannot replace a file which is
+		// still mapped, so if the move fails the file is kept beside the destination with a 
+		// '.pending' extension instead, and replaces the destination once it is next resolved.
+		// This fails if there is already a pending replacement which is itself still mapped.
+		static bool Replace(const std::filesystem::path& source, const std::filesystem::path& destination);
+
+		// Returns the path which holds the latest contents of the file. A pending replacement
+		// is first moved over the file, or if the file is still mapped, its path is returned.
+		static std::filesystem::path Resolve(const std::filesystem::path& path);
+
+	private:
+
+		static constexpr const char* c_PendingExtension = ".pending";
+
+		const uint8_t* m_Data;
+		const uint64_t m_Size;
+		const bool m_CopyOnWrite;
+
+#ifdef _WIN32
+		void* m_Mapping;
+
+		MappedFile(const uint8_t* data, const uint64_t size, const bool copy_on_write, void* mapping);
+#else
+		MappedFile(const uint8_t* data, const uint64_t size, const bool copy_on_write);
+#endif
+
+	public:
+
+		~MappedFile();
+
+		// Asks the OS to start reading the whole file into memory in the background,
+		// so that later accesses do not stall on a page fault for every page. 
+		void prefetch() const;
+
+		const uint8_t* data() const;
+
+		uint8_t* writable_data();
+
+		uint64_t size() const;
+
+		bool is_copy_on_write() const;
+
+	};
+
+}
\ No newline at end of file
@@ -47,28 +47,37 @@ namespace cbn
 
 	HSLColour Colour::to_hsl() const
 	{
-		const float r = red / 255;
-		const float g = green / 255;
-		const float b = blue / 255;
+		// The batch kernels in ImageKernels follow these exact steps, so any change 
+		// here must also be made there to keep their results identical.
+		constexpr float scale = 1.0f / 255.0f;
+		const float r = red * scale;
+		const float g = green * scale;
+		const float b = blue * scale;
 		const float c_max = std::max(r, std::max(g, b));
 		const float c_min = std::min(r, std::min(g, b));
 		const float delta = c_max - c_min;
+		const float luminance = (c_max + c_min) * 0.5f;
 
+		// Greys have no hue or saturation
 		if(delta == 0)
-			return {0,0,0};
-		
-		const float luminance = (c_max + c_min) / 2;
-		const float saturation = delta / (1 - std::abs(2 * luminance - 2));
+			return {0.0f, 0.0f, luminance};
 		
+		const float saturation = std::min(delta / (1.0f - std::abs(luminance * 2.0f - 1.0f)), 1.0f);
+		const float inverse_delta = 1.0f / delta;
+
 		float hue = 0;
 		if(c_max == r)
-			hue = 60 * std::fmodf((g - b) / delta, 6);
+		{
+			hue = (g - b) * inverse_delta;
+			if(hue < 0)
+				hue += 6.0f;
+		}
 		else if(c_max == g)
-			hue = 60 * ((b - r) / delta + 2);
+			hue = (b - r) * inverse_delta + 2.0f;
 		else
-			hue = 60 * ((r - g) / delta + 4);
+			hue = (r - g) * inverse_delta + 4.0f;
 
-		return {std::round(hue), std::round(saturation), std::round(luminance)};
+		return {hue * 60.0f, saturation, luminance};
 	}
 
 	//-------------------------------------------------------------------------------------
@@ -79,22 +88,20 @@ namespace cbn
 		const float S = std::clamp(saturation, 0.0f, 1.0f);
 		const float L = std::clamp(luminance, 0.0f, 1.0f);
 
-		const float C = (1 - std::abs(2 * L - 1)) * S;
-		const float X = C * (1 - std::abs(std::fmodf(H / 60, 2) - 1));
-		const float m = L - C / 2.0f;
-
-		if(H < 60)
-			return Colour{static_cast<uint8_t>((C + m) * 255), static_cast<uint8_t>((X + m) * 255), static_cast<uint8_t>(m * 255)};
-		else if(H < 120)
-			return Colour{static_cast<uint8_t>((X + m) * 255), static_cast<uint8_t>((C + m) * 255), static_cast<uint8_t>(m * 255)};
-		else if(H < 180)
-			return Colour{static_cast<uint8_t>(m * 255), static_cast<uint8_t>((C + m) * 255), static_cast<uint8_t>((X + m) * 255)};
-		else if(H < 240)
-			return Colour{static_cast<uint8_t>(m * 255), static_cast<uint8_t>((X + m) * 255), static_cast<uint8_t>((X + m) * 255)};
-		else if(H < 300)
-			return Colour{static_cast<uint8_t>((X + m) * 255), static_cast<uint8_t>(m * 255), static_cast<uint8_t>((C + m) * 255)};
-		else
-			return Colour{static_cast<uint8_t>((C + m) * 255), static_cast<uint8_t>(m * 255), static_cast<uint8_t>((X + m) * 255)};
+		// Each channel is found from its own offset around the hue circle, 
+		// which avoids having to branch on which sextant the hue is in. 
+		const float A = S * std::min(L, 1.0f - L);
+		const auto channel = [&](const float offset)
+		{
+			float k = offset + H * (1.0f / 30.0f);
+			if(k >= 12.0f)
+				k -= 12.0f;
+
+			const float value = L - A * std::max(std::min(std::min(k - 3.0f, 9.0f - k), 1.0f), -1.0f);
+			return static_cast<uint8_t>(std::lrint(value * 255.0f));
+		};
+
+		return Colour{channel(0.0f), channel(8.0f), channel(4.0f)};
 	}
 
 	//-------------------------------------------------------------------------------------
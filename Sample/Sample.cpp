@@ -1,6 +1,7 @@
 #define CBN_DISABLE_ASSERTS
 
 #include <algorithm>
+#include <fstream>
 #include <iostream>
 #include <thread>
 
@@ -48,6 +49,7 @@ void dynamic_render_scene(URes<Window>& window, bool& runflag);
 //-------------------------------------------------------------------------------------
 
 constexpr bool DEBUG = false;
+constexpr TexturePackEncoding PACK_ENCODING = TexturePackEncoding::PACKED;
 
 int main()
 {
@@ -155,9 +157,13 @@ URes<Window> create_window()
 
 SRes<ShaderProgram> load_program(const String& vertex_name, const String& fragment_name)
 {
-	// Load the vertex shader
+	// Load the vertex shader, inserting the texture pack decoder after its version directive
 	const std::string vertex_shader_path = "res/shaders/" + vertex_name;
-	auto [vertex_shader, log_1] = Shader::Open(vertex_shader_path, Shader::Stage::VERTEX);
+	std::ifstream vertex_file(vertex_shader_path);
+	std::string vertex_source{std::istreambuf_iterator<char>(vertex_file), std::istreambuf_iterator<char>()};
+	vertex_source.insert(std::min(vertex_source.find('\n') + 1, vertex_source.size()), TexturePack::DecoderSource(PACK_ENCODING));
+
+	auto [vertex_shader, log_1] = vertex_file ? Shader::Compile(vertex_source, Shader::Stage::VERTEX) : std::tuple<SRes<Shader>, String>{nullptr, "Could not load file"};
 	if(!vertex_shader)
 		print("Failed to load " + vertex_name + " due to:\n\t" + log_1);
 
@@ -188,6 +194,7 @@ TexturePack load_textures(const URes<Window>& window, const std::map<Identifier,
 {
 	// Load each texture into an array
 	std::array<TexturePackEntry, TexturePack::SupportedTextureCount> entries{};
+	std::vector<std::filesystem::path> paths;
 
 	for(int i = 0; const auto& [id, name] : textures)
 	{
@@ -196,14 +203,25 @@ TexturePack load_textures(const URes<Window>& window, const std::map<Identifier,
 			const std::string full_path = "res/textures/" + name;
 
 			entries[i].identifier = id;
-			entries[i].texture = Texture::Open(full_path);
+			paths.push_back(full_path);
 		}
 		else print("Could not fit texture with ID: " + id.alias() + " and name: " + name);
 		
 		i++;
 	}
 
-	return TexturePack{entries, window->get_opengl_version()};
+	// Decode all the images in parallel, then upload them on this thread
+	const auto images = Image::OpenMany(paths);
+	for(int i = 0; i < images.size(); i++)
+	{
+		const auto& [image, error] = images[i];
+		if(image)
+			entries[i].texture = Texture::Create(image);
+		else
+			print("Failed to load " + String{paths[i].string()} + " due to: " + error);
+	}
+
+	return TexturePack{entries, window->get_opengl_version(), PACK_ENCODING};
 }
 
 //-------------------------------------------------------------------------------------
@@ -6,10 +6,11 @@ layout(location = 2) in uvec4 user_data;
 
 out vec3 tdata;
 
-uniform samplerBuffer tp_data; 
+// The texture pack decoder, see TexturePack::DecoderSource, is inserted after the version directive
+uniform usamplerBuffer tp_data; 
 
 void main(void)
 {
 	gl_Position = vec4(position.xy, 0.0, 1.0);
-	tdata = texelFetch(tp_data, int(textures.x)).xyz;
+	tdata = decode_texture_data(tp_data, textures.x);
 }